@@ -0,0 +1,19 @@
+#pragma once
+#include "palette/types/button_action.hpp"
+#include <string_view>
+
+namespace palette::buttons {
+
+struct button_id {
+    button_action action = button_action::unknown;
+    // Points into the custom id it was parsed from.
+    std::string_view payload;
+};
+
+// Splits off the action segment and looks it up in a perfect hash table
+// built at compile time, so routing costs one hash and one comparison
+// however many actions are registered. Ids without a payload or with an
+// unregistered action come back as button_action::unknown.
+button_id parse_button_id(std::string_view custom_id);
+
+} // namespace palette::buttons
@@ -0,0 +1,36 @@
+#pragma once
+#include "palette/services/palette_controls.hpp"
+#include "palette/services/thread_pool.hpp"
+#include <cstdint>
+#include <dpp/dpp.h>
+#include <string_view>
+
+namespace palette::buttons {
+
+struct palette_click_stats {
+    uint64_t clicks = 0;
+    // Folded into a render that was already queued or running.
+    uint64_t coalesced = 0;
+    uint64_t renders = 0;
+    // Started because clicks moved the target while the previous render
+    // of the same message ran.
+    uint64_t rerenders = 0;
+    // Sent when a click had already moved the target past them.
+    uint64_t wasted = 0;
+};
+
+// Moves a shades/tints message `delta` steps; runs on the gateway thread.
+// The first click on a message claims it and queues its render; clicks
+// arriving while that render is queued or running only move its target and
+// are acknowledged with a deferred update. Every finished render is shown,
+// the first as the click's update and later ones as edits of it, and the
+// render repeats until it shows the latest target, so a message has at most
+// one render running and one more owed.
+void handle_palette_click(services::thread_pool &pool, dpp::cluster &bot,
+                          const dpp::button_click_t &event,
+                          std::string_view payload,
+                          services::palette_control_mode mode, int delta);
+
+palette_click_stats palette_clicks();
+
+} // namespace palette::buttons
@@ -1,6 +1,10 @@
 #pragma once
+#include "palette/buttons/button_id.hpp"
+#include "palette/services/thread_pool.hpp"
 #include <dpp/dpp.h>
 
 namespace palette::buttons {
-void handle_shades(dpp::cluster &bot, const dpp::button_click_t &event);
+// Routed `shades_next` and `shades_back` clicks.
+void handle_shades(services::thread_pool &pool, dpp::cluster &bot,
+                   const dpp::button_click_t &event, const button_id &id);
 }
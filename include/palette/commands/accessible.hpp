@@ -0,0 +1,8 @@
+#pragma once
+#include "palette/services/interaction_context.hpp"
+#include <dpp/dpp.h>
+
+namespace palette::commands {
+void handle_accessible(dpp::cluster &bot,
+                       const services::interaction_context &event);
+} // namespace palette::commands
@@ -1,15 +1,8 @@
 #pragma once
-#include "palette/types/command_options.hpp"
+#include "palette/services/interaction_context.hpp"
 #include <dpp/dpp.h>
 
 namespace palette::commands {
-inline constexpr command_option_t get_server_count_command_options{
-    .isPrivate = true,
-    .isWhitelist = false,
-    .requiredVote = false,
-    .ratelimit = 0,
-};
-
 void handle_get_server_count(dpp::cluster &bot,
-                             const dpp::slashcommand_t &event);
+                             const services::interaction_context &event);
 }
@@ -0,0 +1,16 @@
+#pragma once
+#include "palette/types/command_schema.hpp"
+#include <span>
+#include <string_view>
+
+namespace palette::commands {
+
+// Every slash command, public ones first, in registration order.
+std::span<const command_spec> command_table();
+
+// Looks the name up in a perfect hash table built at compile time from
+// command_table(), so dispatch costs one hash and one comparison however
+// many commands exist. Returns nullptr for names that are not registered.
+const command_spec *find_command(std::string_view name);
+
+} // namespace palette::commands
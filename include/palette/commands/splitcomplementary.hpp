@@ -1,15 +1,8 @@
 #pragma once
-#include "palette/types/command_options.hpp"
+#include "palette/services/interaction_context.hpp"
 #include <dpp/dpp.h>
 
 namespace palette::commands {
-inline constexpr command_option_t splitcomplementary_command_options{
-    .isPrivate = false,
-    .isWhitelist = false,
-    .requiredVote = false,
-    .ratelimit = 2000,
-};
-
 void handle_splitcomplementary(dpp::cluster &bot,
-                               const dpp::slashcommand_t &event);
+                               const services::interaction_context &event);
 } // namespace palette::commands
@@ -1,15 +1,15 @@
 #pragma once
+#include "palette/services/http_request.hpp"
 #include <dpp/dpp.h>
-#include <functional>
 #include <string>
 
 namespace palette::services {
-void fetch_color(dpp::cluster &bot, const std::string &query_key,
-                 const std::string &query_value,
-                 std::function<void(bool ok, std::string body)> cb);
-void fetch_scheme(dpp::cluster &bot, const std::string &hex,
-                  const std::string &mode, int count,
-                  std::function<void(bool ok, std::string body)> cb);
+// TheColorAPI lookups. Both requests are sent before returning; co_await the
+// result.
+pending_request fetch_color(dpp::cluster &bot, const std::string &query_key,
+                            const std::string &query_value);
+pending_request fetch_scheme(dpp::cluster &bot, const std::string &hex,
+                             const std::string &mode, int count);
 std::string name_distance_label(double d);
 std::string resolve_self_url(const nlohmann::json &json,
                              const std::string &fallback_url);
@@ -0,0 +1,32 @@
+#pragma once
+#include "palette/services/palette_image.hpp"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace palette::services {
+
+inline constexpr size_t kMaxMixColors = 48;
+
+// srgb averages encoded channels (the classic /mix result), linear averages
+// light, oklab averages perceptually and pigment mixes like paint.
+enum class mix_mode { srgb, linear, oklab, pigment };
+
+bool parse_mix_mode(std::string_view name, mix_mode &out);
+const char *mix_mode_label(mix_mode mode);
+
+// Positive parts separated by ';', one per color (e.g. "2;1;1").
+bool parse_mix_weights(const std::string &raw, size_t count,
+                       std::vector<double> &out, std::string &error);
+
+// Weighted mix; empty `weights` means equal parts. The pigment mode maps
+// each color onto reflectance curves built from a precomputed three-curve
+// basis, mixes their Kubelka-Munk absorption/scattering ratios per
+// wavelength and projects the result back to sRGB, so a single color
+// round-trips unchanged.
+rgb_color mix_colors_weighted(const std::vector<rgb_color> &colors,
+                              const std::vector<double> &weights,
+                              mix_mode mode);
+
+} // namespace palette::services
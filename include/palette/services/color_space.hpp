@@ -0,0 +1,54 @@
+#pragma once
+#include "palette/services/palette_image.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace palette::services {
+
+inline constexpr size_t kLinearToSrgbTableSize = 16384;
+
+struct oklab_color {
+    double l = 0.0;
+    double a = 0.0;
+    double b = 0.0;
+};
+
+struct oklch_color {
+    double l = 0.0;
+    double c = 0.0;
+    double h = 0.0;
+};
+
+// IEC 61966-2-1 transfer function (threshold 0.04045). WCAG luminance keeps
+// its own legacy constant in color_utils.
+const std::array<float, 256> &srgb_to_linear_table();
+double srgb_to_linear(double encoded);
+double linear_to_srgb(double linear);
+uint8_t linear_to_srgb8(double linear);
+// Encodes linear values by table lookup; the 16K entries keep every result
+// within one step of linear_to_srgb8 for kernels that run per swatch.
+const std::array<uint8_t, kLinearToSrgbTableSize> &linear_to_srgb8_table();
+inline uint8_t linear_to_srgb8_fast(float linear) {
+    const float clamped =
+        linear < 0.0F ? 0.0F : (linear > 1.0F ? 1.0F : linear);
+    return linear_to_srgb8_table()[static_cast<size_t>(
+        clamped * static_cast<float>(kLinearToSrgbTableSize - 1) + 0.5F)];
+}
+
+oklab_color linear_rgb_to_oklab(double r, double g, double b);
+void oklab_to_linear_rgb(oklab_color value, double &r, double &g, double &b);
+oklab_color rgb_to_oklab(rgb_color value);
+rgb_color oklab_to_rgb(oklab_color value);
+bool oklab_in_srgb_gamut(oklab_color value);
+
+oklch_color oklab_to_oklch(oklab_color value);
+oklab_color oklch_to_oklab(oklch_color value);
+
+double oklab_distance_squared(oklab_color x, oklab_color y);
+
+// Structure-of-arrays conversion for bulk work (samples, candidate sets).
+void rgb_to_oklab_batch(const rgb_color *in, size_t count, float *l, float *a,
+                        float *b);
+
+} // namespace palette::services
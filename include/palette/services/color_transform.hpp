@@ -0,0 +1,59 @@
+#pragma once
+#include "palette/services/icc_profile.hpp"
+#include "palette/services/palette_image.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace palette::services {
+
+inline constexpr int kRgbTransformGrid = 33;
+inline constexpr int kCmykTransformGrid = 17;
+
+// Device-to-device transform between two profiles, compiled into a grid of
+// output values: 33^3 nodes for RGB input, 17^4 for CMYK. Lookups use
+// tetrahedral interpolation; CMYK input blends two adjacent K slices. The
+// per-channel offset and fraction tables turn 8-bit input into node
+// positions without any division.
+struct color_transform {
+    int inputs = 3;
+    int outputs = 3;
+    int grid = kRgbTransformGrid;
+    std::array<size_t, 4> strides{};
+    std::vector<float> nodes;
+    std::array<std::array<uint32_t, 256>, 4> offsets{};
+    std::array<std::array<float, 256>, 4> fractions{};
+};
+
+std::shared_ptr<const color_transform>
+build_color_transform(const icc_profile &source,
+                      const icc_profile &destination);
+// Cached per profile pair, keyed on both profile hashes and checked against
+// the profiles themselves on a hit. Null when the destination profile
+// cannot be used for output.
+std::shared_ptr<const color_transform>
+get_color_transform(const std::shared_ptr<const icc_profile> &source,
+                    const std::shared_ptr<const icc_profile> &destination);
+
+// Interleaved 8-bit pixels, `inputs` bytes in and `outputs` bytes out per
+// pixel.
+void apply_color_transform(const color_transform &transform,
+                           const uint8_t *in, uint8_t *out, size_t count);
+// One pixel with channel values in [0, 1].
+void apply_color_transform(const color_transform &transform, const double *in,
+                           double *out);
+
+// CMYK profile from BOT_CMYK_PROFILE (default profiles/cmyk.icc), loaded
+// on first use. Null when no usable profile is found.
+std::shared_ptr<const icc_profile> cmyk_icc_profile();
+// CMYK percentages through the configured profile. Both return false when
+// no CMYK profile is configured.
+bool profiled_cmyk_to_rgb(const std::array<double, 4> &cmyk, rgb_color &out);
+bool profiled_rgb_to_cmyk(rgb_color in, std::array<double, 4> &cmyk);
+// Display P3 coordinates in [0, 1], clipped to the P3 gamut. False when
+// the transform cannot be built.
+bool rgb_to_display_p3(rgb_color in, std::array<double, 3> &p3);
+
+} // namespace palette::services
@@ -1,5 +1,6 @@
 #pragma once
 #include "palette/services/palette_image.hpp"
+#include <array>
 #include <dpp/dpp.h>
 #include <string>
 #include <string_view>
@@ -32,11 +33,13 @@ struct wcag_contrast_result {
     double ratio = 1.0;
 };
 
+class interaction_context;
+
 bool read_optional_string(const dpp::command_value &value, std::string &out);
 single_color_input_result
-parse_single_color_input(const dpp::slashcommand_t &event);
+parse_single_color_input(const interaction_context &event);
 multi_color_input_result
-parse_multi_color_input(const dpp::slashcommand_t &event, size_t max_colors);
+parse_multi_color_input(const interaction_context &event, size_t max_colors);
 
 std::string trim_copy(std::string_view value);
 
@@ -52,6 +55,8 @@ void rgb_to_hsl(rgb_color in, double &h, double &s, double &l);
 bool parse_color_list(const std::string &raw, color_model model,
                       std::vector<rgb_color> &out);
 
+// WCAG 2 channel linearization (legacy 0.03928 threshold) by table lookup.
+const std::array<double, 256> &wcag_channel_linear_table();
 double relative_luminance(rgb_color value);
 double contrast_ratio(rgb_color a, rgb_color b);
 double contrast_ratio_on_black(rgb_color text_color);
@@ -59,7 +64,6 @@ wcag_contrast_result evaluate_wcag_contrast(rgb_color text,
                                             rgb_color background);
 bool is_web_safe_color(rgb_color value);
 rgb_color nearest_web_safe_color(rgb_color value);
-rgb_color mix_colors(const std::vector<rgb_color> &colors);
 std::string rgb_to_hex(rgb_color value);
 
 } // namespace palette::services
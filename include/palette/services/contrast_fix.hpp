@@ -0,0 +1,46 @@
+#pragma once
+#include "palette/services/palette_image.hpp"
+#include <string_view>
+#include <vector>
+
+namespace palette::services {
+
+inline constexpr int kMinTonalScaleSteps = 3;
+inline constexpr int kMaxTonalScaleSteps = 12;
+
+enum class contrast_level { aa_normal, aa_large, aaa_normal, aaa_large };
+
+bool parse_contrast_level(std::string_view name, contrast_level &out);
+double contrast_level_ratio(contrast_level level);
+const char *contrast_level_label(contrast_level level);
+
+struct contrast_fix {
+    rgb_color color;
+    double ratio = 1.0;
+    // OKLab distance from the original color, scaled by 100.
+    double distance = 0.0;
+    bool lighter = false;
+};
+
+// Closest colors reaching `target_ratio` on `background`: at most one
+// lighter and one darker than the original, nearest first, and none on a
+// side the original already reaches. Only OKLCH lightness moves; chroma is
+// kept unless the color would leave sRGB.
+std::vector<contrast_fix> find_contrast_fixes(rgb_color text,
+                                              rgb_color background,
+                                              double target_ratio);
+
+struct tonal_scale {
+    std::vector<rgb_color> colors;
+    // Smallest step distance at which every pair reaches 4.5:1 / 7:1, or 0
+    // if no distance does.
+    int aa_separation = 0;
+    int aaa_separation = 0;
+};
+
+// Light-to-dark scale in the seed's hue. Steps are spaced evenly in WCAG
+// contrast (log luminance), so the ratio between two steps depends only on
+// how far apart they are.
+tonal_scale generate_tonal_scale(rgb_color seed, int steps);
+
+} // namespace palette::services
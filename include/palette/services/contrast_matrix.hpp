@@ -0,0 +1,41 @@
+#pragma once
+#include "palette/services/palette_image.hpp"
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace palette::services {
+
+inline constexpr size_t kMaxContrastMatrixColors = 32;
+
+enum class contrast_method { wcag, apca };
+
+// Strongest level a text/background pair reaches. For APCA the levels are
+// the Lc 90/75/60 readability bands rather than WCAG ratios.
+enum class contrast_grade { fail, large_text, aa, aaa };
+
+// Contrast of every text color (rows) on every background (columns). WCAG
+// values are ratios (1-21); APCA values are signed Lc (-108 to 106).
+struct contrast_matrix {
+    contrast_method method = contrast_method::wcag;
+    size_t rows = 0;
+    size_t columns = 0;
+    std::vector<float> values;
+
+    float at(size_t row, size_t column) const {
+        return values[row * columns + column];
+    }
+};
+
+bool parse_contrast_method(std::string_view name, contrast_method &out);
+
+// Luminance terms are computed once per color; each cell is then a couple
+// of arithmetic operations over contiguous arrays.
+contrast_matrix
+compute_contrast_matrix(const std::vector<rgb_color> &texts,
+                        const std::vector<rgb_color> &backgrounds,
+                        contrast_method method);
+contrast_grade grade_contrast(contrast_method method, float value);
+const char *contrast_grade_label(contrast_grade grade);
+
+} // namespace palette::services
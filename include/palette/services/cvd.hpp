@@ -0,0 +1,50 @@
+#pragma once
+#include "palette/services/palette_image.hpp"
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace palette::services {
+
+enum class cvd_type { protan, deutan, tritan };
+
+// Severity is a percentage: 100 simulates dichromacy (protanopia etc.),
+// lower values the matching anomalous trichromacy.
+struct cvd_simulation {
+    cvd_type type = cvd_type::deutan;
+    int severity = 100;
+};
+
+struct cvd_input_result {
+    bool ok = false;
+    std::string error;
+    std::optional<cvd_simulation> simulation;
+};
+
+class interaction_context;
+
+// Reads the optional `cvd` and `severity` options shared by palette commands.
+cvd_input_result parse_cvd_input(const interaction_context &event);
+bool parse_cvd_type(std::string_view name, cvd_type &out);
+std::string cvd_label(const cvd_simulation &simulation);
+
+// Machado et al. (2009) simulation applied in linear RGB. The kernel converts
+// through lookup tables in fixed-size structure-of-arrays blocks, so a whole
+// swatch grid is one call. `in` and `out` may alias.
+void simulate_cvd(const rgb_color *in, size_t count,
+                  const cvd_simulation &simulation, rgb_color *out);
+std::vector<std::vector<rgb_color>>
+simulate_cvd_grid(const std::vector<std::vector<rgb_color>> &grid,
+                  const cvd_simulation &simulation);
+
+// Original palette next to its simulation. Flat color lists are laid out in
+// rows of five like generate_palette_image; step grids keep their rows.
+std::string generate_cvd_comparison_image(const std::vector<rgb_color> &colors,
+                                          const cvd_simulation &simulation);
+std::string generate_cvd_comparison_image(
+    const std::vector<std::vector<rgb_color>> &grid,
+    const cvd_simulation &simulation);
+
+} // namespace palette::services
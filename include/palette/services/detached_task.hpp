@@ -0,0 +1,31 @@
+#pragma once
+#include <coroutine>
+#include <exception>
+#include <iostream>
+
+namespace palette::services {
+
+// Return type for fire-and-forget coroutines such as command flows. The body
+// starts running as soon as it is called and the frame frees itself once it
+// finishes. An exception escaping the body is logged and dropped, so one
+// failed flow cannot take down the thread that resumed it.
+struct detached_task {
+    struct promise_type {
+        detached_task get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept {
+            try {
+                throw;
+            } catch (const std::exception &e) {
+                std::cerr << "Detached coroutine failed: " << e.what()
+                          << "\n";
+            } catch (...) {
+                std::cerr << "Detached coroutine failed.\n";
+            }
+        }
+    };
+};
+
+} // namespace palette::services
@@ -0,0 +1,35 @@
+#pragma once
+#include "palette/services/palette_image.hpp"
+#include <vector>
+
+namespace palette::services {
+
+inline constexpr int kMinDistinctColors = 2;
+inline constexpr int kMaxDistinctColors = 256;
+
+// OKLCH bounds for generated colors. Chroma uses the CSS percentage scale,
+// where 100% is 0.4.
+struct distinct_constraints {
+    double min_lightness = 0.0;
+    double max_lightness = 1.0;
+    double min_chroma = 0.0;
+    double max_chroma = 0.4;
+};
+
+struct distinct_palette {
+    std::vector<rgb_color> colors;
+    // Smallest OKLab distance between two colors, scaled by 100.
+    double min_distance = 0.0;
+};
+
+// Picks up to `count` sRGB colors inside the constraints that are as far
+// apart as possible in OKLab. Farthest-point sampling over a lattice of
+// candidates gives the initial set, in an order where every prefix is
+// itself well spread; the closest pairs are then relocated while that
+// widens the minimum distance. Fewer colors are returned only when the
+// constraints admit fewer candidates. When called from a pool worker the
+// relocation search is spread over the pool.
+distinct_palette generate_distinct_palette(int count,
+                                           const distinct_constraints &limits);
+
+} // namespace palette::services
@@ -0,0 +1,34 @@
+#pragma once
+#include "palette/services/palette_image.hpp"
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace palette::services {
+
+inline constexpr size_t kMaxGradientStops = 16;
+inline constexpr int kMinGradientSteps = 2;
+inline constexpr int kMaxGradientSteps = 256;
+inline constexpr size_t kGradientStripWidth = 1024;
+
+enum class gradient_space { srgb, linear, oklab, oklch };
+
+// How OKLCH interpolation walks around the hue circle between two stops, as
+// in CSS Color 4.
+enum class hue_path { shorter, longer, increasing, decreasing };
+
+bool parse_gradient_space(std::string_view name, gradient_space &out);
+bool parse_hue_path(std::string_view name, hue_path &out);
+const char *gradient_space_label(gradient_space space);
+
+// Samples `count` evenly spaced colors from the first to the last stop, with
+// stops spread evenly along the gradient. Stops are converted once; samples
+// are then interpolated and converted back per channel in fixed-size blocks.
+void interpolate_gradient(const std::vector<rgb_color> &stops,
+                          gradient_space space, hue_path path, size_t count,
+                          rgb_color *out);
+std::vector<rgb_color> interpolate_gradient(const std::vector<rgb_color> &stops,
+                                            gradient_space space,
+                                            hue_path path, size_t count);
+
+} // namespace palette::services
@@ -0,0 +1,28 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace palette::services {
+
+// Commands are tracked by their position in the command table.
+inline constexpr size_t kMaxTrackedCommands = 32;
+
+struct handler_cost_stats {
+    uint64_t samples = 0;
+    uint64_t auto_deferred = 0;
+};
+
+// What the command's handler is expected to take, learned the way TCP
+// learns its retransmission timeout: a smoothed mean plus four smoothed
+// deviations of recent run times, so commands whose timings jump around
+// are budgeted for their slow runs. Zero until the first sample.
+std::chrono::microseconds handler_cost_estimate(size_t command);
+void record_handler_cost(size_t command,
+                         std::chrono::steady_clock::duration took);
+
+// Counts interactions deferred because the estimate did not fit.
+void record_auto_defer();
+handler_cost_stats handler_costs();
+
+} // namespace palette::services
@@ -0,0 +1,19 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace palette::services {
+
+inline constexpr size_t kSha256Bytes = 32;
+using sha256_digest = std::array<uint8_t, kSha256Bytes>;
+
+sha256_digest sha256(const uint8_t *data, size_t size);
+// RFC 2104 HMAC over SHA-256.
+sha256_digest hmac_sha256(std::string_view key, const uint8_t *data,
+                          size_t size);
+// Compares in time independent of where the inputs differ.
+bool constant_time_equal(const uint8_t *a, const uint8_t *b, size_t size);
+
+} // namespace palette::services
@@ -0,0 +1,54 @@
+#pragma once
+#include "palette/types/task_class.hpp"
+#include <coroutine>
+#include <cstdint>
+#include <dpp/dpp.h>
+#include <memory>
+#include <string>
+
+namespace palette::services {
+
+struct http_result {
+    uint16_t status = 0;
+    std::string body;
+
+    bool ok() const { return status == 200; }
+    // "HTTP <status>", as shown in API error replies.
+    std::string error() const;
+};
+
+// A GET request that is already in flight. Awaiting it suspends the
+// coroutine until the response arrives, or not at all if it already has,
+// so starting several requests before awaiting any of them runs them
+// concurrently. Each request is awaited at most once.
+//
+// A suspended coroutine resumes as a task on the worker pool the request
+// was started from, in the lane it was started with, so JSON parsing and
+// image rendering never hold up D++'s HTTP threads. Requests started
+// outside the pool, or whose pool is stopping, resume on the D++ thread.
+class pending_request {
+  public:
+    struct state;
+
+    explicit pending_request(std::shared_ptr<state> shared);
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> waiter);
+    http_result await_resume();
+
+  private:
+    std::shared_ptr<state> state_;
+};
+
+// Time D++'s HTTP threads spend in our completion callbacks.
+struct http_completion_stats {
+    uint64_t completions = 0;
+    double total_ms = 0.0;
+    double max_ms = 0.0;
+};
+
+pending_request start_request(dpp::cluster &bot, const std::string &url,
+                              task_class lane = task_class::render);
+http_completion_stats completion_stats();
+
+} // namespace palette::services
@@ -0,0 +1,94 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace palette::services {
+
+enum class icc_device_space { rgb, cmyk };
+
+// One-dimensional ICC curve: identity, gamma, sampled table or one of the
+// parametric functions (types 0-4).
+struct icc_curve {
+    enum class kind { identity, gamma, table, parametric };
+    kind type = kind::identity;
+    int function = 0;
+    std::array<double, 7> params{};
+    std::vector<double> samples;
+
+    double evaluate(double x) const;
+    // Inverse by bisection; curves are assumed monotonic.
+    double invert(double y) const;
+};
+
+// Multidimensional lookup table with normalized node values.
+struct icc_clut {
+    int inputs = 0;
+    int outputs = 0;
+    std::array<int, 8> grid{};
+    std::vector<float> values;
+
+    void evaluate(const double *in, double *out) const;
+};
+
+// Encoding of the PCS side of a LUT pipeline.
+enum class icc_pcs_encoding { xyz, lab, lab_legacy };
+
+// A lut8/lut16 or v4 lutAtoB/lutBtoA tag as one stage sequence:
+// curves, matrix, curves, CLUT, curves, matrix, curves. The tag type
+// decides which stages are present.
+struct icc_lut {
+    int inputs = 0;
+    int outputs = 0;
+    icc_pcs_encoding encoding = icc_pcs_encoding::lab;
+    std::vector<icc_curve> curves1;
+    bool has_matrix1 = false;
+    std::array<double, 12> matrix1{};
+    std::vector<icc_curve> curves2;
+    icc_clut clut;
+    std::vector<icc_curve> curves3;
+    bool has_matrix2 = false;
+    std::array<double, 12> matrix2{};
+    std::vector<icc_curve> curves4;
+
+    void evaluate(const double *in, double *out) const;
+};
+
+// Parsed ICC v2/v4 profile. Device values are normalized to [0, 1]; the
+// PCS side is always handled as D50 XYZ with media-relative white.
+// LUT tags win over matrix/TRC when a profile carries both, and the
+// relative colorimetric tags over the perceptual ones.
+struct icc_profile {
+    std::string name;
+    icc_device_space space = icc_device_space::rgb;
+    uint64_t hash = 0;
+    bool has_matrix_trc = false;
+    std::array<double, 9> matrix{};
+    std::array<double, 9> inverse_matrix{};
+    std::array<icc_curve, 3> trc;
+    bool has_a2b = false;
+    icc_lut a2b;
+    bool has_b2a = false;
+    icc_lut b2a;
+};
+
+int icc_channel_count(icc_device_space space);
+
+std::shared_ptr<const icc_profile> parse_icc_profile(std::string_view data,
+                                                     std::string &error);
+std::shared_ptr<const icc_profile> load_icc_profile(const std::string &path,
+                                                    std::string &error);
+const std::shared_ptr<const icc_profile> &srgb_icc_profile();
+const std::shared_ptr<const icc_profile> &display_p3_icc_profile();
+
+void icc_device_to_pcs(const icc_profile &profile, const double *device,
+                       double xyz[3]);
+// Returns false when the profile has no PCS-to-device direction.
+bool icc_pcs_to_device(const icc_profile &profile, const double xyz[3],
+                       double *device);
+bool icc_profile_is_output_capable(const icc_profile &profile);
+
+} // namespace palette::services
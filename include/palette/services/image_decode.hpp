@@ -0,0 +1,43 @@
+#pragma once
+#include "palette/services/palette_image.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace palette::services {
+
+inline constexpr int kMaxDecodeDimension = 16384;
+inline constexpr uint64_t kMaxDecodePixels = 64ULL * 1024 * 1024;
+
+struct image_sample_result {
+    bool ok = false;
+    std::string error;
+    int width = 0;
+    int height = 0;
+    std::vector<rgb_color> samples;
+};
+
+// Decodes a PNG or baseline JPEG and keeps an evenly spaced grid of roughly
+// `max_samples` opaque pixels. Decoders stream rows into the sampler, so
+// memory stays at a few scanlines plus the samples whatever the image size.
+image_sample_result sample_image_pixels(std::string_view data,
+                                        size_t max_samples);
+image_sample_result sample_png_pixels(std::string_view data,
+                                      size_t max_samples);
+image_sample_result sample_jpeg_pixels(std::string_view data,
+                                       size_t max_samples);
+
+// Distance between sampled rows/columns for a `max_samples` budget.
+int sample_stride(int width, int height, size_t max_samples);
+
+// Streaming zlib inflate. Input is pulled from `next_input` a piece at a
+// time, such as a PNG's IDAT chunks, and read in place; an empty piece ends
+// it. Output is handed to `sink` in chunks as soon as it leaves the 32 KiB
+// back-reference window; returning false from the sink stops decoding early.
+bool zlib_inflate(const std::function<std::string_view()> &next_input,
+                  const std::function<bool(const uint8_t *, size_t)> &sink);
+
+} // namespace palette::services
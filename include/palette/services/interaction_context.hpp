@@ -0,0 +1,132 @@
+#pragma once
+#include "palette/services/color_utils.hpp"
+#include "palette/types/command_schema.hpp"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <dpp/dpp.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace palette::services {
+
+class interaction_context;
+
+// Post-processor for the message that answers an interaction, such as the
+// occasional suggestion embed.
+using response_decorator = void (*)(const interaction_context &,
+                                    dpp::message &);
+inline constexpr size_t kMaxResponseDecorators = 4;
+
+// The parts of a slash command interaction a handler needs, taken once on
+// the gateway thread. Apart from which response has been sent, it never
+// changes afterwards, and it is shared by pointer through the worker pool
+// and HTTP continuations, which capture shared_from_this() instead of
+// copying the event or its strings.
+// Replies go through the same REST calls as dpp::interaction_create_t.
+//
+// Options are decoded once, against the command's schema, into slots in
+// schema order; options the schema does not declare are dropped.
+//
+// Once the interaction is deferred, replies edit the deferred response
+// (and later ones become followups). Replies made before Discord has
+// acknowledged the deferral are held back and sent when it has, so they
+// cannot overtake it. If Discord rejects the deferral, they are sent as a
+// normal first response and followups instead.
+//
+// The decorators chosen at dispatch run once, on whichever message ends up
+// answering: the first reply, the edit of a deferred response or the first
+// followup. Nothing is fetched or edited after the fact.
+class interaction_context
+    : public std::enable_shared_from_this<interaction_context> {
+  public:
+    interaction_context(dpp::cluster &bot, const dpp::slashcommand_t &event,
+                        const command_spec &spec,
+                        std::span<const response_decorator> decorators = {});
+
+    // Empty when the option was not given or is not in the schema.
+    const dpp::command_value &get_parameter(std::string_view name) const;
+    // Throws std::out_of_range when the attachment was not resolved.
+    const dpp::attachment &get_resolved_attachment(dpp::snowflake id) const;
+
+    void reply(const std::string &text,
+               dpp::command_completion_event_t callback = {}) const;
+    void reply(const dpp::message &msg,
+               dpp::command_completion_event_t callback = {}) const;
+    void reply(dpp::interaction_response_type type, const dpp::message &msg,
+               dpp::command_completion_event_t callback = {}) const;
+    // Does nothing once the interaction has been answered or deferred.
+    void thinking(bool ephemeral = false,
+                  dpp::command_completion_event_t callback = {}) const;
+    bool deferred() const;
+    // For handlers that answer after thinking(), in place of
+    // dpp::cluster::interaction_followup_create. Held back like replies
+    // while the deferral is unacknowledged.
+    void followup(const dpp::message &msg,
+                  dpp::command_completion_event_t callback = {}) const;
+    void edit_original_response(
+        const dpp::message &msg,
+        dpp::command_completion_event_t callback = {}) const;
+
+    dpp::snowflake id;
+    dpp::snowflake channel_id;
+    dpp::snowflake guild_id;
+    dpp::snowflake user_id;
+    std::string token;
+    std::string command_name;
+    // Latest start that can still answer without deferring, from
+    // interaction_response_deadline().
+    std::chrono::steady_clock::time_point response_deadline;
+    // The `hex`/`rgb`/`hsl`/`cmyk` input, parsed up front for commands
+    // that take a single color.
+    single_color_input_result color;
+
+  private:
+    enum class response_state { none, deferring, deferred, answered };
+
+    struct held_reply {
+        dpp::message msg;
+        dpp::command_completion_event_t callback;
+    };
+
+    // Returns false when a first response was already sent.
+    bool begin_deferral() const;
+    void deferral_acknowledged() const;
+    void deferral_failed(const std::string &error) const;
+    void answer_deferred(const dpp::message &msg,
+                         dpp::command_completion_event_t callback) const;
+    void send_followup(const dpp::message &msg,
+                       dpp::command_completion_event_t callback) const;
+    // Hands `send` the message, decorated if it is the first answer.
+    void send_answer(
+        const dpp::message &msg,
+        const std::function<void(const dpp::message &)> &send) const;
+
+    dpp::cluster *bot_;
+    std::span<const option_spec> schema_;
+    std::array<dpp::command_value, kMaxCommandOptions> values_;
+    std::map<dpp::snowflake, dpp::attachment> attachments_;
+    std::array<response_decorator, kMaxResponseDecorators> decorators_{};
+    size_t decorator_count_ = 0;
+
+    mutable std::mutex response_mutex_;
+    mutable response_state response_ = response_state::none;
+    mutable bool original_edited_ = false;
+    mutable bool decorated_ = false;
+    mutable std::vector<held_reply> held_;
+};
+
+using interaction_handle = std::shared_ptr<const interaction_context>;
+
+interaction_handle
+make_interaction_context(dpp::cluster &bot, const dpp::slashcommand_t &event,
+                         const command_spec &spec,
+                         std::span<const response_decorator> decorators = {});
+
+} // namespace palette::services
@@ -0,0 +1,25 @@
+#pragma once
+#include <chrono>
+#include <dpp/dpp.h>
+
+namespace palette::services {
+
+// Discord drops an interaction that has no initial response this long after
+// it was created.
+inline constexpr std::chrono::milliseconds kInteractionResponseWindow{3000};
+// Left for the handler itself to build and send that first response.
+inline constexpr std::chrono::milliseconds kInteractionResponseMargin{500};
+
+// Creation time from the interaction's snowflake, on the steady clock.
+std::chrono::steady_clock::time_point
+interaction_created_at(const dpp::interaction &command);
+// Latest time a handler may start and still answer directly; one starting
+// later should defer first.
+std::chrono::steady_clock::time_point
+interaction_response_deadline(const dpp::interaction &command);
+// End of the response window. Queued work for the interaction that has not
+// started by then can no longer answer at all, not even by deferring.
+std::chrono::steady_clock::time_point
+interaction_response_expiry(const dpp::interaction &command);
+
+} // namespace palette::services
@@ -1,6 +1,10 @@
+#include "palette/services/interaction_context.hpp"
 #include <dpp/dpp.h>
 
 namespace palette::services {
-void add_suggestion(const dpp::slashcommand_t &event);
-void send_ratelimited(const dpp::slashcommand_t &event);
+// Response decorator that adds one of the tips as an embed.
+void append_suggestion(const interaction_context &event, dpp::message &msg);
+void send_ratelimited(const dpp::interaction_create_t &event);
+// Immediate reply for interactions the worker pool refused to queue.
+void send_busy(const dpp::interaction_create_t &event);
 } // namespace palette::services
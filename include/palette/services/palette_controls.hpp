@@ -1,17 +1,31 @@
 #pragma once
+#include "palette/services/cvd.hpp"
 #include "palette/services/palette_image.hpp"
+#include "palette/types/button_action.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <dpp/dpp.h>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace palette::services {
 
+inline constexpr size_t kMaxPaletteSeeds = 10;
+
 enum class palette_control_mode { shades, tints };
 
+// Fixed size with the seeds inline, so it packs into a button id.
 struct palette_control_state {
     palette_control_mode mode = palette_control_mode::shades;
-    std::vector<rgb_color> seed_colors;
     int amount = 2;
+    uint8_t seed_count = 0;
+    std::array<rgb_color, kMaxPaletteSeeds> seeds{};
+    std::optional<cvd_simulation> simulation;
+
+    std::vector<rgb_color> seed_colors() const;
 };
 
 struct palette_render_result {
@@ -23,24 +37,24 @@ struct palette_render_result {
 
 int clamp_palette_amount(int amount);
 
-std::string create_palette_control_token(palette_control_mode mode,
-                                         const std::vector<rgb_color> &seeds,
-                                         int amount);
-bool get_palette_control_state(const std::string &token,
-                               palette_control_state &out);
-bool adjust_palette_control_amount(const std::string &token, int delta,
-                                   palette_control_state &out);
-
-std::string build_palette_button_id(palette_control_mode mode, int delta,
-                                    const std::string &token);
-bool parse_palette_button_id(const std::string &custom_id,
-                             palette_control_mode &mode, int &delta,
-                             std::string &token);
-
-dpp::component build_palette_controls_row(palette_control_mode mode, int amount,
-                                          const std::string &token);
-palette_render_result render_palette_with_controls(palette_control_mode mode,
-                                                   const std::vector<rgb_color> &seeds,
-                                                   int amount);
+// Empty when there are no seeds or more than kMaxPaletteSeeds.
+std::optional<palette_control_state> make_palette_control_state(
+    palette_control_mode mode, const std::vector<rgb_color> &seeds, int amount,
+    const std::optional<cvd_simulation> &simulation = std::nullopt);
+
+// The whole state packed into a button id payload and authenticated with
+// BOT_BUTTON_SECRET, so a click can be handled by any process without a
+// lookup. Decoding fails on anything that was not encoded with that key.
+std::string encode_palette_state(const palette_control_state &state);
+bool decode_palette_state(std::string_view payload,
+                          palette_control_state &out);
+
+std::string build_palette_button_id(int delta,
+                                    const palette_control_state &state);
+
+dpp::component build_palette_controls_row(const palette_control_state &state);
+palette_render_result render_palette_with_controls(
+    palette_control_mode mode, const std::vector<rgb_color> &seeds, int amount,
+    const std::optional<cvd_simulation> &simulation = std::nullopt);
 
 } // namespace palette::services
@@ -0,0 +1,25 @@
+#pragma once
+#include "palette/services/palette_image.hpp"
+#include <cstddef>
+#include <vector>
+
+namespace palette::services {
+
+inline constexpr int kMinExtractColors = 2;
+inline constexpr int kMaxExtractColors = 10;
+inline constexpr size_t kExtractSampleBudget = 65536;
+
+struct extracted_color {
+    rgb_color color;
+    double share = 0.0;
+};
+
+// Clusters sampled pixels in OKLab with weighted k-means. Samples are first
+// folded into a 15-bit RGB histogram so the iterations scale with the number
+// of distinct colors rather than the image size; when called from a pool
+// worker the assignment step is spread over the pool. Results are ordered by
+// share, largest first.
+std::vector<extracted_color>
+extract_dominant_colors(const std::vector<rgb_color> &samples, int count);
+
+} // namespace palette::services
@@ -1,6 +1,7 @@
 #pragma once
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace palette::services {
@@ -11,6 +12,12 @@ struct rgb_color {
     uint8_t b;
 };
 
+struct heatmap_cell {
+    rgb_color fill;
+    std::string value;
+    std::string mark;
+};
+
 struct image_result {
     std::string image_data;
     std::vector<std::vector<rgb_color>> palette;
@@ -23,6 +30,23 @@ std::vector<rgb_color> make_tints_to_white(rgb_color seed, int amount);
 std::string generate_palette_image(const std::vector<rgb_color> &colors);
 std::string generate_palette_image(const std::vector<rgb_color> &colors,
                                    bool include_numbers);
+// Continuous strip with one column per strip color, above a row of sampled
+// swatches. Only the first strip row is drawn; the rest are copies of it.
+std::string generate_gradient_image(const std::vector<rgb_color> &strip,
+                                    const std::vector<rgb_color> &swatches);
+// Labelled grid: a swatch for every row and column header, and one cell per
+// pair (row-major) showing its value and mark when the cell is big enough.
+std::string generate_heatmap_image(const std::vector<rgb_color> &row_headers,
+                                   const std::vector<rgb_color> &column_headers,
+                                   const std::vector<heatmap_cell> &cells);
+// Two swatch grids side by side under their labels, e.g. a palette and its
+// color-vision simulation. Swatches are numbered per column unless
+// `number_continuously` is set, in which case numbering runs across rows.
+std::string generate_comparison_palette_image(
+    const std::vector<std::vector<rgb_color>> &left,
+    const std::vector<std::vector<rgb_color>> &right,
+    std::string_view left_label, std::string_view right_label,
+    bool number_continuously);
 std::string
 generate_text_on_background_image(const std::vector<std::string> &lines,
                                   rgb_color text_color,
@@ -0,0 +1,45 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace palette::services {
+
+// FNV-1a, offset by the seed.
+constexpr uint32_t seeded_fnv1a(std::string_view key, uint32_t seed) {
+    uint32_t hash = 2166136261U ^ seed;
+    for (const char c : key) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+template <size_t Slots>
+constexpr size_t perfect_hash_slot(std::string_view key, uint32_t seed) {
+    return seeded_fnv1a(key, seed) % Slots;
+}
+
+// First seed that puts every key in its own slot, or UINT32_MAX when none
+// below 65536 does. Meant for constant evaluation over a fixed key set.
+template <size_t Slots, size_t N>
+constexpr uint32_t
+find_perfect_hash_seed(const std::array<std::string_view, N> &keys) {
+    static_assert(Slots >= N);
+    for (uint32_t seed = 0; seed < 65536; ++seed) {
+        std::array<bool, Slots> used{};
+        bool collision = false;
+        for (const std::string_view key : keys) {
+            const size_t slot = perfect_hash_slot<Slots>(key, seed);
+            collision = collision || used[slot];
+            used[slot] = true;
+        }
+        if (!collision) {
+            return seed;
+        }
+    }
+    return UINT32_MAX;
+}
+
+} // namespace palette::services
@@ -0,0 +1,34 @@
+#pragma once
+#include "palette/services/palette_image.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace palette::services {
+
+inline constexpr size_t kMaxQuantizePaletteSize = 256;
+
+// Nearest-color lookup table for one target palette. The RGB cube is split
+// into 32x32x32 cells; every cell lists the palette entries that can be the
+// nearest match for some color inside it, so a lookup scans one short list.
+struct palette_lut {
+    std::vector<rgb_color> targets;
+    uint64_t hash = 0;
+    std::vector<uint32_t> cell_offsets;
+    std::vector<uint8_t> candidates;
+};
+
+uint64_t hash_palette(const std::vector<rgb_color> &targets);
+std::shared_ptr<const palette_lut>
+build_palette_lut(const std::vector<rgb_color> &targets);
+std::shared_ptr<const palette_lut>
+get_palette_lut(const std::vector<rgb_color> &targets);
+
+size_t quantize_index(const palette_lut &lut, rgb_color value);
+rgb_color quantize_color(const palette_lut &lut, rgb_color value);
+
+bool resolve_named_palette(std::string_view name, std::vector<rgb_color> &out);
+
+} // namespace palette::services
@@ -1,7 +1,41 @@
 #pragma once
-#include "dpp/dpp.h"
-#include <ctime>
+#include "palette/types/command_options.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <dpp/dpp.h>
+#include <string_view>
 
 namespace palette::services {
-bool is_ratelimited(dpp::snowflake user_id, int64_t ms);
+
+// Rate limits follow GCRA: each bucket keeps a theoretical arrival time
+// (TAT) and a request conforms when it does not push the TAT further ahead
+// than the bucket tolerates. Every user has one cooldown per command, with
+// the command's `ratelimit` as its interval, and one budget shared by all
+// their commands that heavier lanes drain faster.
+inline constexpr std::chrono::milliseconds kRateBudgetInterval{1000};
+inline constexpr int64_t kRateBudgetBurst = 12;
+inline constexpr size_t kRateLimitShards = 64;
+// Shards are also swept on a timer, so one that stops seeing traffic still
+// lets go of its drained users.
+inline constexpr std::chrono::seconds kRateLimitSweepInterval{30};
+
+// Budget tokens a command of that lane spends.
+int64_t rate_cost(task_class lane);
+
+// Checks and, when allowed, records one use. Runs on the gateway thread
+// before anything is queued; users are spread over striped shards, and idle
+// users are swept out on a timer wheel as their buckets drain.
+bool is_ratelimited(dpp::snowflake user_id, std::string_view command,
+                    const command_option_t &options);
+
+// Users currently tracked, for diagnostics.
+size_t ratelimited_users();
+
+// Advances every shard's wheel to now, dropping users whose buckets have
+// drained.
+void sweep_ratelimits();
+// Runs sweep_ratelimits every kRateLimitSweepInterval.
+void schedule_ratelimit_sweeps(dpp::cluster &bot);
+
 } // namespace palette::services
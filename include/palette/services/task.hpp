@@ -0,0 +1,116 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace palette::services {
+
+// Fits the dispatcher captures (an interaction handle, cluster and pool
+// references and a handler pointer) and the parallel_for helpers with room
+// to spare.
+inline constexpr size_t kTaskInlineBytes = 96;
+
+// Move-only `void()` callable for the worker pool. Callables up to
+// kTaskInlineBytes that can be moved without throwing are built straight
+// into the inline buffer; anything bigger falls back to one heap
+// allocation. Unlike std::function it never copies its target, so
+// move-only captures work too.
+class task {
+  public:
+    task() = default;
+
+    template <typename F,
+              typename = std::enable_if_t<
+                  !std::is_same_v<std::decay_t<F>, task> &&
+                  std::is_invocable_r_v<void, std::decay_t<F> &>>>
+    task(F &&fn) {
+        emplace<std::decay_t<F>>(std::forward<F>(fn));
+    }
+
+    task(task &&other) noexcept { take(other); }
+
+    task &operator=(task &&other) noexcept {
+        if (this != &other) {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    task(const task &) = delete;
+    task &operator=(const task &) = delete;
+
+    ~task() { reset(); }
+
+    // Constructs the callable in place, replacing the current one.
+    template <typename F, typename... Args> void emplace(Args &&...args) {
+        reset();
+        if constexpr (stored_inline<F>) {
+            ::new (static_cast<void *>(storage_))
+                F(std::forward<Args>(args)...);
+            ops_ = &inline_operations<F>::table;
+        } else {
+            ::new (static_cast<void *>(storage_))
+                F *(new F(std::forward<Args>(args)...));
+            ops_ = &heap_operations<F>::table;
+        }
+    }
+
+    void reset() noexcept {
+        if (ops_) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    explicit operator bool() const { return ops_ != nullptr; }
+    void operator()() { ops_->invoke(storage_); }
+
+  private:
+    struct operations {
+        void (*invoke)(void *);
+        void (*relocate)(void *from, void *to) noexcept;
+        void (*destroy)(void *) noexcept;
+    };
+
+    template <typename F>
+    static constexpr bool stored_inline =
+        sizeof(F) <= kTaskInlineBytes &&
+        alignof(F) <= alignof(std::max_align_t) &&
+        std::is_nothrow_move_constructible_v<F>;
+
+    template <typename F> struct inline_operations {
+        static void invoke(void *p) { (*static_cast<F *>(p))(); }
+        static void relocate(void *from, void *to) noexcept {
+            F *source = static_cast<F *>(from);
+            ::new (to) F(std::move(*source));
+            source->~F();
+        }
+        static void destroy(void *p) noexcept { static_cast<F *>(p)->~F(); }
+        static constexpr operations table{invoke, relocate, destroy};
+    };
+
+    template <typename F> struct heap_operations {
+        static F *target(void *p) { return *static_cast<F **>(p); }
+        static void invoke(void *p) { (*target(p))(); }
+        static void relocate(void *from, void *to) noexcept {
+            ::new (to) F *(target(from));
+        }
+        static void destroy(void *p) noexcept { delete target(p); }
+        static constexpr operations table{invoke, relocate, destroy};
+    };
+
+    void take(task &other) noexcept {
+        if (other.ops_) {
+            other.ops_->relocate(other.storage_, storage_);
+            ops_ = other.ops_;
+            other.ops_ = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage_[kTaskInlineBytes];
+    const operations *ops_ = nullptr;
+};
+
+} // namespace palette::services
@@ -1,21 +1,119 @@
 #pragma once
+#include "palette/services/task.hpp"
+#include "palette/types/task_class.hpp"
+#include <array>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 
 namespace palette::services {
 
+inline constexpr size_t kQueueWaitBuckets = 24;
+inline constexpr size_t kDefaultLaneCapacity = 256;
+
+using task_clock = std::chrono::steady_clock;
+
 size_t resolve_worker_thread_count(const char *env_name, size_t fallback);
+const char *task_class_label(task_class lane);
+
+enum class admission { accepted, queue_full, over_budget, stopped };
+const char *admission_label(admission result);
+
+// Zero min/max threads mean "same as threads", which keeps the pool fixed.
+struct thread_pool_options {
+    size_t threads = 4;
+    size_t min_threads = 0;
+    size_t max_threads = 0;
+    // Bounds each lane for try_enqueue.
+    size_t lane_capacity = kDefaultLaneCapacity;
+};
+
+enum class scaling_decision { hold, grow, shrink };
+const char *scaling_decision_label(scaling_decision decision);
+
+// Latest window seen by the elastic sizing controller.
+struct scaling_stats {
+    size_t workers = 0;
+    size_t min_workers = 0;
+    size_t max_workers = 0;
+    uint64_t grown = 0;
+    uint64_t shrunk = 0;
+    double window_p90_ms = 0.0;
+    double utilization = 0.0;
+    scaling_decision last_decision = scaling_decision::hold;
+};
+
+// Queue waits in power-of-two microsecond buckets: bucket 0 counts waits
+// under 1 us, bucket b those in [2^(b-1), 2^b) us. The last bucket also
+// takes everything longer.
+struct queue_wait_histogram {
+    std::array<uint64_t, kQueueWaitBuckets> counts{};
+
+    uint64_t total() const;
+    // Upper bound, in milliseconds, of the bucket holding that fraction of
+    // the waits.
+    double percentile_ms(double fraction) const;
+};
 
 class thread_pool {
   public:
-    explicit thread_pool(size_t thread_count);
+    explicit thread_pool(size_t thread_count,
+                         size_t lane_capacity = kDefaultLaneCapacity);
+    // Between min_threads and max_threads the pool grows when queue waits
+    // or utilization stay high and retires parked workers after a long
+    // quiet spell.
+    explicit thread_pool(const thread_pool_options &options);
     ~thread_pool();
 
     thread_pool(const thread_pool &) = delete;
     thread_pool &operator=(const thread_pool &) = delete;
 
-    void enqueue(std::function<void()> task);
+    struct lane_stats {
+        size_t queued = 0;
+        size_t running = 0;
+        size_t limit = 0;
+        size_t capacity = 0;
+        // Smoothed run time of the lane's tasks.
+        double service_ms = 0.0;
+        uint64_t shed_full = 0;
+        uint64_t shed_over_budget = 0;
+        uint64_t expired = 0;
+        queue_wait_histogram wait;
+    };
+
+    // Work-stealing scheduler: tasks submitted from one of this pool's
+    // workers go to that worker's own deque, where idle workers steal them,
+    // and count against the lane of the task that submitted them; anything
+    // else goes to the interactive lane.
+    void enqueue(task work);
+    // Queues on the given lane even from inside a worker. Lanes share the
+    // pool by weight, and part of the pool is kept free for interactive and
+    // render work: the other lanes together never occupy it. Only a pool
+    // that is stopping turns the task away, with admission::stopped, when
+    // it comes from outside the pool.
+    admission enqueue(task work, task_class lane);
+    // Bounded admission for new work; enqueue stays unbounded so work that
+    // was already admitted is never cut off halfway. The task is refused when
+    // its lane is at capacity or, given a deadline, when the lane's estimated
+    // wait would run past it. An admitted task still queued at its deadline
+    // is dropped without running.
+    admission try_enqueue(task work, task_class lane,
+                          task_clock::time_point deadline =
+                              task_clock::time_point::max());
+    // Active workers; changes over time for an elastic pool.
     size_t size() const;
+    lane_stats stats(task_class lane) const;
+    scaling_stats scaling() const;
+
+    // Splits [0, count) into chunks and runs them on idle workers. The
+    // calling thread works through chunks too, so this is safe to call from
+    // inside a pool task even when every other worker is busy.
+    void parallel_for(size_t count, size_t min_chunk,
+                      const std::function<void(size_t, size_t)> &body);
+
+    // The pool owning the calling worker thread, or nullptr.
+    static thread_pool *current();
 
   private:
     struct impl;
@@ -0,0 +1,27 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Component custom ids are "<action>:<payload>". The action picks the
+// handler; the payload belongs to it.
+enum class button_action : uint8_t {
+    shades_next,
+    shades_back,
+    tints_next,
+    tints_back,
+    unknown,
+};
+
+inline constexpr size_t kButtonActionCount = 4;
+
+inline constexpr std::array<std::string_view, kButtonActionCount>
+    kButtonActionNames = {"shades_next", "shades_back", "tints_next",
+                          "tints_back"};
+
+constexpr std::string_view button_action_name(button_action action) {
+    return action == button_action::unknown
+               ? std::string_view{}
+               : kButtonActionNames[static_cast<size_t>(action)];
+}
@@ -1,8 +1,10 @@
 #pragma once
+#include "palette/types/task_class.hpp"
 
 struct command_option_t {
     bool isPrivate;
     bool isWhitelist;
     bool requiredVote;
     int ratelimit;
+    task_class lane = task_class::interactive;
 };
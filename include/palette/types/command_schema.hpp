@@ -0,0 +1,47 @@
+#pragma once
+#include "palette/types/command_options.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace dpp {
+class cluster;
+}
+
+namespace palette::services {
+class interaction_context;
+}
+
+enum class option_kind : uint8_t { string, integer, attachment };
+
+struct option_choice {
+    std::string_view label;
+    std::string_view value;
+};
+
+struct option_spec {
+    std::string_view name;
+    std::string_view description;
+    option_kind kind = option_kind::string;
+    bool required = false;
+    std::span<const option_choice> choices{};
+};
+
+// Decoded option values live in a fixed array indexed by schema position.
+inline constexpr size_t kMaxCommandOptions = 10;
+
+using command_handler =
+    void (*)(dpp::cluster &, const palette::services::interaction_context &);
+
+// Everything about one slash command: what is registered with Discord, how
+// it is limited and queued, and what runs it.
+struct command_spec {
+    std::string_view name;
+    std::string_view description{};
+    std::span<const option_spec> options{};
+    command_option_t policy{};
+    command_handler handler = nullptr;
+    // `hex`/`rgb`/`hsl`/`cmyk` name one color, parsed before the handler.
+    bool single_color_input = false;
+};
@@ -0,0 +1,9 @@
+#pragma once
+#include <cstddef>
+
+// Scheduling lane for pool work. Interactive covers cheap replies and button
+// updates, render the image-heavy commands, and background anything nobody
+// is waiting on.
+enum class task_class { interactive, render, background };
+
+inline constexpr size_t kTaskClassCount = 3;
@@ -0,0 +1,45 @@
+#include "palette/buttons/button_id.hpp"
+#include "palette/services/perfect_hash.hpp"
+#include <array>
+#include <cstdint>
+
+namespace palette::buttons {
+namespace {
+constexpr size_t kRouteSlots = 8;
+
+constexpr size_t route_slot(std::string_view name, uint32_t seed) {
+    return services::perfect_hash_slot<kRouteSlots>(name, seed);
+}
+
+constexpr uint32_t kRouteSeed =
+    services::find_perfect_hash_seed<kRouteSlots>(kButtonActionNames);
+static_assert(kRouteSeed != UINT32_MAX, "no perfect hash for button actions");
+
+constexpr std::array<button_action, kRouteSlots> build_routes() {
+    std::array<button_action, kRouteSlots> routes{};
+    routes.fill(button_action::unknown);
+    for (size_t i = 0; i < kButtonActionCount; ++i) {
+        routes[route_slot(kButtonActionNames[i], kRouteSeed)] =
+            static_cast<button_action>(i);
+    }
+    return routes;
+}
+
+constexpr std::array<button_action, kRouteSlots> kRoutes = build_routes();
+} // namespace
+
+button_id parse_button_id(std::string_view custom_id) {
+    const size_t colon = custom_id.find(':');
+    if (colon == std::string_view::npos || colon + 1 == custom_id.size()) {
+        return {};
+    }
+
+    const std::string_view name = custom_id.substr(0, colon);
+    const button_action action = kRoutes[route_slot(name, kRouteSeed)];
+    if (button_action_name(action) != name) {
+        return {};
+    }
+    return {action, custom_id.substr(colon + 1)};
+}
+
+} // namespace palette::buttons
@@ -0,0 +1,395 @@
+#include "palette/buttons/palette_clicks.hpp"
+#include "palette/services/interaction_deadline.hpp"
+#include "palette/services/message.hpp"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+namespace palette::buttons {
+namespace {
+struct pending_render {
+    services::palette_control_state state;
+    // Bumped by every coalesced click that moves the amount, so a render
+    // can tell it went stale.
+    uint64_t generation = 0;
+};
+
+// Messages whose renders are queued, running or not yet sent, each owned by
+// the click that started them.
+std::mutex pending_mutex;
+std::unordered_map<uint64_t, pending_render> pending;
+
+std::atomic<uint64_t> clicks{0};
+std::atomic<uint64_t> coalesced{0};
+std::atomic<uint64_t> renders{0};
+std::atomic<uint64_t> rerenders{0};
+std::atomic<uint64_t> wasted{0};
+
+std::string expired_message(services::palette_control_mode mode) {
+    return mode == services::palette_control_mode::tints
+               ? "This tints session expired. Run `/tints` again."
+               : "This shades session expired. Run `/shades` again.";
+}
+
+dpp::message build_update(const services::palette_control_state &state,
+                          const services::palette_render_result &rendered) {
+    dpp::message msg;
+    msg.set_content(rendered.description);
+    msg.add_component(services::build_palette_controls_row(state));
+    msg.add_file(state.mode == services::palette_control_mode::tints
+                     ? "tint-palette.png"
+                     : "color-palette.png",
+                 rendered.image_data);
+    return msg;
+}
+
+void release_message(uint64_t message) {
+    std::lock_guard<std::mutex> lock(pending_mutex);
+    pending.erase(message);
+}
+
+// The render for one message while it is queued or running. Destroying a
+// claim that was never rendered, as happens to a shed or expired task,
+// releases the message so its next click renders again.
+class palette_render_claim {
+  public:
+    palette_render_claim() = default;
+    explicit palette_render_claim(dpp::snowflake message)
+        : message_(static_cast<uint64_t>(message)) {}
+    ~palette_render_claim() {
+        if (message_ != 0) {
+            release_message(message_);
+        }
+    }
+
+    palette_render_claim(palette_render_claim &&other) noexcept
+        : message_(std::exchange(other.message_, 0)) {}
+    palette_render_claim &operator=(palette_render_claim &&other) noexcept {
+        if (this != &other) {
+            if (message_ != 0) {
+                release_message(message_);
+            }
+            message_ = std::exchange(other.message_, 0);
+        }
+        return *this;
+    }
+    palette_render_claim(const palette_render_claim &) = delete;
+    palette_render_claim &operator=(const palette_render_claim &) = delete;
+
+    explicit operator bool() const { return message_ != 0; }
+    dpp::snowflake message() const { return message_; }
+    // Hands the message back without releasing it.
+    dpp::snowflake release() {
+        return dpp::snowflake(std::exchange(message_, 0));
+    }
+
+  private:
+    uint64_t message_ = 0;
+};
+
+// Renders one message for the click that owns it, until the latest target
+// has been rendered and its send confirmed; only then does a new click take
+// the message over. Sends go out one at a time in render order: the first
+// answers the click, unless a deferred update already has, and later ones
+// edit it. While a send is out, the next render may run, and once it is
+// done it waits for that send instead of being thrown away, so a message
+// has at most one render running and one more waiting.
+class palette_renderer
+    : public std::enable_shared_from_this<palette_renderer> {
+  public:
+    palette_renderer(services::thread_pool &pool, dpp::cluster &bot,
+                     const dpp::button_click_t &event, uint64_t message)
+        : bot_(&bot), pool_(&pool), id_(event.command.id),
+          token_(event.command.token), message_(message) {}
+
+    void start(const dpp::interaction &command) {
+        // A click that waited past the deadline is acknowledged first, so
+        // its render can still land as an edit.
+        if (std::chrono::steady_clock::now() >
+            services::interaction_response_deadline(command)) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                answered_ = true;
+                in_flight_ = true;
+            }
+            bot_->interaction_response_create(
+                id_, token_,
+                dpp::interaction_response(dpp::ir_deferred_update_message),
+                confirmation());
+        }
+        render();
+    }
+
+  private:
+    void render() {
+        try {
+            render_while_stale();
+        } catch (...) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                done_ = true;
+            }
+            // Later clicks must not fold into a render that is gone.
+            release_message(message_);
+            // Renders only run on the pool, which logs what they throw.
+            throw;
+        }
+    }
+
+    void render_while_stale() {
+        for (;;) {
+            services::palette_control_state state;
+            uint64_t generation = 0;
+            {
+                std::lock_guard<std::mutex> lock(pending_mutex);
+                const pending_render &entry = pending.at(message_);
+                state = entry.state;
+                generation = entry.generation;
+            }
+            if (renders_started_++ != 0) {
+                rerenders.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            const services::palette_render_result rendered =
+                services::render_palette_with_controls(
+                    state.mode, state.seed_colors(), state.amount,
+                    state.simulation);
+            renders.fetch_add(1, std::memory_order_relaxed);
+            if (!rendered.ok) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    done_ = true;
+                }
+                release_message(message_);
+                fail(rendered.error);
+                return;
+            }
+
+            dpp::message msg = build_update(state, rendered);
+            bool first = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (in_flight_) {
+                    // confirmed() sends it and decides what comes next.
+                    waiting_ = std::move(msg);
+                    waiting_generation_ = generation;
+                    rendering_ = false;
+                    return;
+                }
+                in_flight_ = true;
+                first = !answered_;
+                answered_ = true;
+                sent_generation_ = generation;
+                count_if_wasted();
+            }
+            transmit(msg, first);
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stale()) {
+                continue;
+            }
+            rendering_ = false;
+            // Already confirmed: nothing else will come back to settle it.
+            if (!in_flight_) {
+                release_message(message_);
+                done_ = true;
+            }
+            return;
+        }
+    }
+
+    // Whether a click has moved the target past what was last sent. Called
+    // with mutex_ held.
+    bool stale() const {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        return pending.at(message_).generation != sent_generation_;
+    }
+
+    // A render sent after a click already moved the target past it is
+    // replaced by the next one before anyone needs it. Called with mutex_
+    // held.
+    void count_if_wasted() const {
+        if (stale()) {
+            wasted.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void confirmed() {
+        std::optional<dpp::message> next;
+        bool render_next = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (done_) {
+                return;
+            }
+            if (waiting_) {
+                next = std::exchange(waiting_, std::nullopt);
+                sent_generation_ = waiting_generation_;
+                count_if_wasted();
+            } else {
+                in_flight_ = false;
+            }
+            if (!rendering_) {
+                if (stale()) {
+                    rendering_ = true;
+                    render_next = true;
+                } else if (!in_flight_) {
+                    release_message(message_);
+                    done_ = true;
+                }
+            }
+        }
+        if (next) {
+            transmit(*next, false);
+        }
+        if (render_next) {
+            schedule_render();
+        }
+    }
+
+    // Called from a confirmation on a D++ thread, so the render goes back
+    // onto the pool. The click behind it was already admitted, so it is not
+    // shed; only a stopping pool refuses it, and then the message is let go.
+    void schedule_render() {
+        auto self = shared_from_this();
+        if (pool_->enqueue([self]() { self->render(); },
+                           task_class::interactive) ==
+            services::admission::accepted) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_ = true;
+        }
+        release_message(message_);
+    }
+
+    dpp::command_completion_event_t confirmation() {
+        return [self = shared_from_this()](
+                   const dpp::confirmation_callback_t &) { self->confirmed(); };
+    }
+
+    void transmit(const dpp::message &msg, bool first) {
+        if (first) {
+            bot_->interaction_response_create(
+                id_, token_,
+                dpp::interaction_response(dpp::ir_update_message, msg),
+                confirmation());
+            return;
+        }
+        bot_->interaction_response_edit(token_, msg, confirmation());
+    }
+
+    void fail(const std::string &error) {
+        bool first = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            first = !answered_;
+            answered_ = true;
+        }
+        if (first) {
+            bot_->interaction_response_create(
+                id_, token_,
+                dpp::interaction_response(dpp::ir_channel_message_with_source,
+                                          dpp::message(error)));
+            return;
+        }
+        bot_->interaction_followup_create(
+            token_, dpp::message(error).set_flags(dpp::m_ephemeral));
+    }
+
+    dpp::cluster *bot_;
+    services::thread_pool *pool_;
+    dpp::snowflake id_;
+    std::string token_;
+    uint64_t message_;
+    // Only touched by the one render running at a time.
+    uint64_t renders_started_ = 0;
+
+    std::mutex mutex_;
+    bool rendering_ = true;
+    bool in_flight_ = false;
+    bool answered_ = false;
+    // Set once the message is released; late confirmations are ignored.
+    bool done_ = false;
+    uint64_t sent_generation_ = 0;
+    std::optional<dpp::message> waiting_;
+    uint64_t waiting_generation_ = 0;
+};
+} // namespace
+
+void handle_palette_click(services::thread_pool &pool, dpp::cluster &bot,
+                          const dpp::button_click_t &event,
+                          std::string_view payload,
+                          services::palette_control_mode mode, int delta) {
+    clicks.fetch_add(1, std::memory_order_relaxed);
+    const uint64_t message = static_cast<uint64_t>(event.command.message_id);
+
+    services::palette_control_state state;
+    const bool resolved =
+        services::decode_palette_state(payload, state) && state.mode == mode;
+    bool folded = false;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        const auto it = pending.find(message);
+        if (it != pending.end()) {
+            services::palette_control_state &target = it->second.state;
+            const int amount =
+                services::clamp_palette_amount(target.amount + delta);
+            // A click at either end changes nothing to render again.
+            if (amount != target.amount) {
+                target.amount = amount;
+                ++it->second.generation;
+            }
+            folded = true;
+        } else if (resolved) {
+            state.amount = services::clamp_palette_amount(state.amount + delta);
+            pending.emplace(message, pending_render{state});
+        }
+    }
+
+    if (folded) {
+        coalesced.fetch_add(1, std::memory_order_relaxed);
+        event.reply(dpp::ir_deferred_update_message, dpp::message());
+        return;
+    }
+    if (!resolved) {
+        event.reply(expired_message(mode));
+        return;
+    }
+
+    // Component updates answer a user who is already looking at the
+    // message, so they share the interactive lane with cheap commands. A
+    // refused or expired task drops the claim with it.
+    const services::admission admitted = pool.try_enqueue(
+        [event_copy = event, &pool, &bot,
+         claim = palette_render_claim(event.command.message_id)]() mutable {
+            const uint64_t owned = static_cast<uint64_t>(claim.release());
+            std::make_shared<palette_renderer>(pool, bot, event_copy, owned)
+                ->start(event_copy.command);
+        },
+        task_class::interactive,
+        services::interaction_response_expiry(event.command));
+    if (admitted == services::admission::queue_full ||
+        admitted == services::admission::over_budget) {
+        services::send_busy(event);
+        bot.log(dpp::ll_warning, "Shed button `" + event.custom_id + "`: " +
+                                     services::admission_label(admitted));
+    }
+}
+
+palette_click_stats palette_clicks() {
+    return {clicks.load(std::memory_order_relaxed),
+            coalesced.load(std::memory_order_relaxed),
+            renders.load(std::memory_order_relaxed),
+            rerenders.load(std::memory_order_relaxed),
+            wasted.load(std::memory_order_relaxed)};
+}
+
+} // namespace palette::buttons
@@ -0,0 +1,148 @@
+#include "palette/commands/accessible.hpp"
+#include "palette/services/color_utils.hpp"
+#include "palette/services/contrast_fix.hpp"
+#include "palette/services/env_utils.hpp"
+#include "palette/services/palette_image.hpp"
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace palette::commands {
+namespace {
+constexpr int kDefaultScaleSteps = 10;
+
+std::string format_ratio(double ratio) {
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(2) << ratio << ":1";
+    return ss.str();
+}
+
+std::string format_distance(double distance) {
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(1) << distance;
+    return ss.str();
+}
+
+std::string separation_line(const char *label, int separation) {
+    std::string line = std::string("- **") + label + ":** ";
+    if (separation == 0) {
+        return line + "no pair of steps\n";
+    }
+    if (separation == 1) {
+        return line + "any two steps\n";
+    }
+    return line + "steps " + std::to_string(separation) +
+           " or more apart\n";
+}
+} // namespace
+
+void handle_accessible(dpp::cluster &bot,
+                       const services::interaction_context &event) {
+    (void)bot;
+
+    const services::single_color_input_result &input = event.color;
+    if (!input.ok) {
+        event.reply(input.error);
+        return;
+    }
+
+    services::rgb_color text_color{};
+    if (!services::parse_query_color_to_rgb(input.query_key, input.query_value,
+                                            text_color)) {
+        event.reply("Could not parse the input value for `" + input.query_key +
+                    "`.");
+        return;
+    }
+
+    services::rgb_color background{255, 255, 255};
+    std::string background_raw;
+    if (services::read_optional_string(event.get_parameter("background"),
+                                       background_raw) &&
+        !services::parse_query_color_to_rgb("hex", background_raw,
+                                            background)) {
+        event.reply("Invalid `background`. Use a hex color like #FFFFFF.");
+        return;
+    }
+
+    std::string level_name = "aa";
+    services::read_optional_string(event.get_parameter("level"), level_name);
+    services::contrast_level level = services::contrast_level::aa_normal;
+    if (!services::parse_contrast_level(
+            services::normalize_ascii_lower(level_name), level)) {
+        event.reply("`level` must be one of: aa, aa-large, aaa, aaa-large.");
+        return;
+    }
+
+    int steps = kDefaultScaleSteps;
+    const auto steps_param = event.get_parameter("steps");
+    if (const auto *p = std::get_if<int64_t>(&steps_param)) {
+        steps = static_cast<int>(*p);
+    }
+    if (steps < services::kMinTonalScaleSteps ||
+        steps > services::kMaxTonalScaleSteps) {
+        event.reply("`steps` must be an integer from " +
+                    std::to_string(services::kMinTonalScaleSteps) + " to " +
+                    std::to_string(services::kMaxTonalScaleSteps) + ".");
+        return;
+    }
+
+    const double target = services::contrast_level_ratio(level);
+    const double original_ratio =
+        services::contrast_ratio(text_color, background);
+    const std::vector<services::contrast_fix> fixes =
+        services::find_contrast_fixes(text_color, background, target);
+    const services::tonal_scale scale =
+        services::generate_tonal_scale(text_color, steps);
+
+    const std::string hex = services::rgb_to_hex(text_color);
+    std::string description =
+        "**Accessible colors**\n"
+        "Alternatives keep the hue and chroma of " +
+        hex + " and only change its OKLCH lightness.\n\n" +
+        "- **Background:** " + services::rgb_to_hex(background) + "\n" +
+        "- **Target:** " + services::contrast_level_label(level) + " (" +
+        format_ratio(target) + ")\n" + "- **Original:** " + hex + " at " +
+        format_ratio(original_ratio) +
+        (original_ratio >= target ? " (passes)" : " (fails)") + "\n\n";
+
+    std::vector<services::rgb_color> swatches{text_color};
+    if (fixes.empty()) {
+        description += original_ratio >= target
+                           ? "The original already reaches the target.\n"
+                           : "No color in this hue reaches the target on "
+                             "this background.\n";
+    } else {
+        description += "**Alternatives**\n";
+        for (const services::contrast_fix &fix : fixes) {
+            description += std::string("- ") +
+                           (fix.lighter ? "Lighter: " : "Darker: ") +
+                           services::rgb_to_hex(fix.color) + " at " +
+                           format_ratio(fix.ratio) + ", ΔE " +
+                           format_distance(fix.distance) + "\n";
+            swatches.push_back(fix.color);
+        }
+    }
+
+    description += "\n**Tonal scale**\n";
+    for (size_t i = 0; i < scale.colors.size(); ++i) {
+        const double ratio =
+            services::contrast_ratio(scale.colors[i], background);
+        description += std::to_string(i + 1) + ". " +
+                       services::rgb_to_hex(scale.colors[i]) + " (" +
+                       format_ratio(ratio) + ")\n";
+    }
+    description += separation_line("AA pairs (4.5:1)", scale.aa_separation);
+    description += separation_line("AAA pairs (7:1)", scale.aaa_separation);
+    swatches.insert(swatches.end(), scale.colors.begin(), scale.colors.end());
+
+    dpp::message msg(event.channel_id, description);
+    const std::string image_data =
+        services::generate_palette_image(swatches, true);
+    if (!image_data.empty()) {
+        msg.add_file("accessible.png", image_data);
+    }
+    event.reply(msg);
+}
+
+} // namespace palette::commands
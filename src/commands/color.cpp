@@ -1,136 +1,181 @@
 #include "palette/commands/color.hpp"
 #include "palette/services/color_api.hpp"
+#include "palette/services/color_transform.hpp"
 #include "palette/services/color_utils.hpp"
+#include "palette/services/detached_task.hpp"
+#include <array>
+#include <iomanip>
 #include <nlohmann/json.hpp>
+#include <sstream>
+#include <utility>
 
 namespace palette::commands {
 namespace {
-void handle_color_impl(dpp::cluster &bot, const dpp::slashcommand_t &event) {
-    const services::single_color_input_result input =
-        services::parse_single_color_input(event);
-    if (!input.ok) {
-        event.reply(input.error);
-        return;
+// Empty when the Display P3 transform is unavailable.
+std::string format_display_p3(services::rgb_color value) {
+    std::array<double, 3> p3{};
+    if (!services::rgb_to_display_p3(value, p3)) {
+        return std::string();
+    }
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(4) << "color(display-p3 " << p3[0]
+       << " " << p3[1] << " " << p3[2] << ")";
+    return ss.str();
+}
+
+// CMYK through the configured print profile, or empty when there is none.
+std::string format_profiled_cmyk(services::rgb_color value) {
+    std::array<double, 4> cmyk{};
+    if (!services::profiled_rgb_to_cmyk(value, cmyk)) {
+        return std::string();
     }
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(0) << "cmyk(" << cmyk[0] << "%, "
+       << cmyk[1] << "%, " << cmyk[2] << "%, " << cmyk[3] << "%) ("
+       << services::cmyk_icc_profile()->name << ")";
+    return ss.str();
+}
 
-    const std::string &query_key = input.query_key;
-    const std::string &query_value = input.query_value;
+services::detached_task lookup_color(dpp::cluster &bot,
+                                     services::interaction_handle context,
+                                     std::string query_key,
+                                     std::string query_value,
+                                     std::string profiled_cmyk,
+                                     std::string display_p3) {
+    const services::http_result response =
+        co_await services::fetch_color(bot, query_key, query_value);
+    if (!response.ok()) {
+        context->followup(dpp::message("API error: " + response.error()));
+        co_return;
+    }
 
-    event.thinking();
-    const std::string token = event.command.token;
+    try {
+        auto j = nlohmann::json::parse(response.body);
+        std::string name = j.at("name").at("value").get<std::string>();
+        int r = j.at("rgb").at("r").get<int>();
+        int g = j.at("rgb").at("g").get<int>();
+        int b = j.at("rgb").at("b").get<int>();
+        std::string thumbnail = j.at("image").at("bare").get<std::string>();
+        std::string hsl_value = j.at("hsl").at("value").get<std::string>();
+        std::string hsv_value = j.at("hsv").at("value").get<std::string>();
+        std::string rgb_value = j.at("rgb").at("value").get<std::string>();
+        std::string cmyk_value = j.at("cmyk").at("value").get<std::string>();
+        std::string xyz_value = j.at("XYZ").at("value").get<std::string>();
+        std::string hex_value = j.at("hex").at("value").get<std::string>();
+        bool match_name = j.at("name").at("exact_match_name").get<bool>();
+        double distance = j.at("name").at("distance").get<double>();
 
-    services::fetch_color(
-        bot, query_key, query_value,
-        [&bot, token, query_key, query_value](bool ok, std::string body) {
-            if (!ok) {
-                bot.interaction_followup_create(
-                    token, dpp::message("API error: " + body));
-                return;
+        std::string api_url = services::build_id_url(query_key, query_value);
+        if (j.contains("_links") && j["_links"].contains("self") &&
+            j["_links"]["self"].is_object() &&
+            j["_links"]["self"].contains("href") &&
+            j["_links"]["self"]["href"].is_string()) {
+            std::string href = j["_links"]["self"]["href"].get<std::string>();
+            if (!href.empty() && href.front() == '/') {
+                api_url = "https://www.thecolorapi.com" + href;
+            } else if (!href.empty()) {
+                api_url = href;
             }
+        }
+
+        uint32_t color = (r << 16) | (g << 8) | b;
+        const bool is_web_safe =
+            services::is_web_safe_color({static_cast<uint8_t>(r),
+                                         static_cast<uint8_t>(g),
+                                         static_cast<uint8_t>(b)});
+        std::string description =
+            "- **HEX:** " + hex_value +
+            "\n"
+            "- **RGB:** " +
+            rgb_value +
+            "\n"
+            "- **HSL:** " +
+            hsl_value +
+            "\n"
+            "- **HSV:** " +
+            hsv_value +
+            "\n"
+            "- **CMYK:** " +
+            (profiled_cmyk.empty() ? cmyk_value : profiled_cmyk) +
+            "\n" +
+            (display_p3.empty() ? std::string()
+                                : "- **Display P3:** " + display_p3 +
+                                      "\n") +
+            "- **XYZ:** " +
+            xyz_value +
+            "\n\n"
+            "**Details**\n"
+            "- **Exact name match:** " +
+            std::string(match_name ? "Yes" : "No") +
+            "\n"
+            "- **Name distance:** " +
+            std::to_string(static_cast<int>(distance)) + " (" +
+            services::name_distance_label(distance) +
+            ")\n\n**Web Safe Color**\n"
+            "- **Is web safe:** " +
+            std::string(is_web_safe ? "Yes" : "No") +
+            "\n"
+            "A web safe color will appear consistently across "
+            "devices, especially legacy 256-color environments.";
 
-            try {
-                auto j = nlohmann::json::parse(body);
-                std::string name = j.at("name").at("value").get<std::string>();
-                int r = j.at("rgb").at("r").get<int>();
-                int g = j.at("rgb").at("g").get<int>();
-                int b = j.at("rgb").at("b").get<int>();
-                std::string thumbnail =
-                    j.at("image").at("bare").get<std::string>();
-                std::string hsl_value =
-                    j.at("hsl").at("value").get<std::string>();
-                std::string hsv_value =
-                    j.at("hsv").at("value").get<std::string>();
-                std::string rgb_value =
-                    j.at("rgb").at("value").get<std::string>();
-                std::string cmyk_value =
-                    j.at("cmyk").at("value").get<std::string>();
-                std::string xyz_value =
-                    j.at("XYZ").at("value").get<std::string>();
-                std::string hex_value =
-                    j.at("hex").at("value").get<std::string>();
-                bool match_name =
-                    j.at("name").at("exact_match_name").get<bool>();
-                double distance = j.at("name").at("distance").get<double>();
+        std::string image_url = "https://images.weserv.nl/?url=" +
+                                dpp::utility::url_encode(thumbnail) +
+                                "&output=png&w=800&h=600";
 
-                std::string api_url =
-                    services::build_id_url(query_key, query_value);
-                if (j.contains("_links") && j["_links"].contains("self") &&
-                    j["_links"]["self"].is_object() &&
-                    j["_links"]["self"].contains("href") &&
-                    j["_links"]["self"]["href"].is_string()) {
-                    std::string href =
-                        j["_links"]["self"]["href"].get<std::string>();
-                    if (!href.empty() && href.front() == '/') {
-                        api_url = "https://www.thecolorapi.com" + href;
-                    } else if (!href.empty()) {
-                        api_url = href;
-                    }
-                }
+        dpp::embed embed =
+            dpp::embed()
+                .set_color(color)
+                .set_url(
+                    services::resolve_self_url(
+                        j, services::build_id_url("hex", query_key)) +
+                    "&format=html")
+                .set_title(name)
+                .set_url(api_url)
+                .set_description(description)
+                .set_image(image_url);
 
-                uint32_t color = (r << 16) | (g << 8) | b;
-                const bool is_web_safe =
-                    services::is_web_safe_color({static_cast<uint8_t>(r),
-                                                 static_cast<uint8_t>(g),
-                                                 static_cast<uint8_t>(b)});
-                std::string description =
-                    "- **HEX:** " + hex_value +
-                    "\n"
-                    "- **RGB:** " +
-                    rgb_value +
-                    "\n"
-                    "- **HSL:** " +
-                    hsl_value +
-                    "\n"
-                    "- **HSV:** " +
-                    hsv_value +
-                    "\n"
-                    "- **CMYK:** " +
-                    cmyk_value +
-                    "\n"
-                    "- **XYZ:** " +
-                    xyz_value +
-                    "\n\n"
-                    "**Details**\n"
-                    "- **Exact name match:** " +
-                    std::string(match_name ? "Yes" : "No") +
-                    "\n"
-                    "- **Name distance:** " +
-                    std::to_string(static_cast<int>(distance)) + " (" +
-                    services::name_distance_label(distance) +
-                    ")\n\n**Web Safe Color**\n"
-                    "- **Is web safe:** " +
-                    std::string(is_web_safe ? "Yes" : "No") +
-                    "\n"
-                    "A web safe color will appear consistently across "
-                    "devices, especially legacy 256-color environments.";
+        context->followup(embed);
+    } catch (const std::exception &e) {
+        context->followup(dpp::message("Failed to parse color response: " +
+                                       std::string(e.what())));
+    }
+}
+
+void handle_color_impl(dpp::cluster &bot,
+                       const services::interaction_context &event) {
+    const services::single_color_input_result &input = event.color;
+    if (!input.ok) {
+        event.reply(input.error);
+        return;
+    }
 
-                std::string image_url = "https://images.weserv.nl/?url=" +
-                                        dpp::utility::url_encode(thumbnail) +
-                                        "&output=png&w=800&h=600";
+    std::string query_key = input.query_key;
+    std::string query_value = input.query_value;
+    // TheColorAPI converts CMYK naively; with a print profile configured the
+    // color is resolved locally and looked up by hex instead.
+    services::rgb_color local{};
+    const bool parsed =
+        services::parse_query_color_to_rgb(query_key, query_value, local);
+    if (parsed && query_key == "cmyk" && services::cmyk_icc_profile()) {
+        query_key = "hex";
+        query_value = services::rgb_to_hex(local);
+    }
+    // Profile transforms are compiled here on the worker, not after the
+    // lookup below.
+    std::string profiled_cmyk =
+        parsed ? format_profiled_cmyk(local) : std::string();
+    std::string display_p3 = parsed ? format_display_p3(local) : std::string();
 
-                dpp::embed embed =
-                    dpp::embed()
-                        .set_color(color)
-                        .set_url(
-                            services::resolve_self_url(
-                                j, services::build_id_url("hex", query_key)) +
-                            "&format=html")
-                        .set_title(name)
-                        .set_url(api_url)
-                        .set_description(description)
-                        .set_image(image_url);
+    event.thinking();
 
-                bot.interaction_followup_create(token, embed);
-            } catch (const std::exception &e) {
-                bot.interaction_followup_create(
-                    token, dpp::message("Failed to parse color response: " +
-                                        std::string(e.what())));
-            }
-        });
+    lookup_color(bot, event.shared_from_this(), std::move(query_key),
+                 std::move(query_value), std::move(profiled_cmyk),
+                 std::move(display_p3));
 }
 } // namespace
 
-void handle_color(dpp::cluster &bot, const dpp::slashcommand_t &event) {
+void handle_color(dpp::cluster &bot,
+                  const services::interaction_context &event) {
     handle_color_impl(bot, event);
 }
 } // namespace palette::commands
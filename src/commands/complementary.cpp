@@ -1,163 +1,194 @@
 #include "palette/commands/complementary.hpp"
 #include "palette/services/color_api.hpp"
 #include "palette/services/color_utils.hpp"
+#include "palette/services/detached_task.hpp"
 #include "palette/services/palette_image.hpp"
+#include <cmath>
 #include <nlohmann/json.hpp>
+#include <optional>
 #include <vector>
 
 namespace palette::commands {
-void handle_complementary(dpp::cluster &bot, const dpp::slashcommand_t &event) {
-    const services::single_color_input_result input =
-        services::parse_single_color_input(event);
+namespace {
+struct seed_color {
+    std::string name;
+    std::string hex;
+    std::string rgb;
+    std::string hsl;
+    std::string url;
+    int h = 0;
+    int s = 0;
+    int l = 0;
+    services::rgb_color value{};
+};
+
+seed_color parse_seed(const std::string &body,
+                      const std::string &fallback_url) {
+    auto j = nlohmann::json::parse(body);
+    seed_color seed;
+    seed.name = j.at("name").at("value").get<std::string>();
+    seed.h = j.at("hsl").at("h").get<int>();
+    seed.s = j.at("hsl").at("s").get<int>();
+    seed.l = j.at("hsl").at("l").get<int>();
+    seed.hex = j.at("hex").at("value").get<std::string>();
+    seed.rgb = j.at("rgb").at("value").get<std::string>();
+    seed.hsl = j.at("hsl").at("value").get<std::string>();
+    seed.value = {static_cast<uint8_t>(j.at("rgb").at("r").get<int>()),
+                  static_cast<uint8_t>(j.at("rgb").at("g").get<int>()),
+                  static_cast<uint8_t>(j.at("rgb").at("b").get<int>())};
+    seed.url = services::resolve_self_url(j, fallback_url);
+    return seed;
+}
+
+// Opposite hue at the same saturation and lightness, from HSL in the whole
+// degrees and percents TheColorAPI reports.
+std::string complement_hex(int h, int s, int l) {
+    services::rgb_color comp_rgb{};
+    services::hsl_to_rgb((h + 180) % 360, s, l, comp_rgb);
+    return services::rgb_to_hex(comp_rgb);
+}
+
+// The complement worked out from the input itself, so its lookup can go out
+// alongside the seed's. Empty when the input does not parse locally.
+std::optional<std::string>
+local_complement_hex(const services::single_color_input_result &input) {
+    services::rgb_color value{};
+    if (!services::parse_query_color_to_rgb(input.query_key, input.query_value,
+                                            value)) {
+        return std::nullopt;
+    }
+    double h = 0.0;
+    double s = 0.0;
+    double l = 0.0;
+    services::rgb_to_hsl(value, h, s, l);
+    return complement_hex(static_cast<int>(std::lround(h)) % 360,
+                          static_cast<int>(std::lround(s)),
+                          static_cast<int>(std::lround(l)));
+}
+
+services::detached_task lookup_complementary(
+    dpp::cluster &bot, services::interaction_handle context) {
+    const services::single_color_input_result &input = context->color;
+
+    services::pending_request seed_lookup =
+        services::fetch_color(bot, input.query_key, input.query_value);
+    std::optional<services::pending_request> comp_lookup;
+    if (const std::optional<std::string> comp_hex =
+            local_complement_hex(input)) {
+        comp_lookup.emplace(services::fetch_color(bot, "hex", *comp_hex));
+    }
+
+    const services::http_result seed_response = co_await seed_lookup;
+    if (!seed_response.ok()) {
+        context->followup(dpp::message("API error: " + seed_response.error()));
+        co_return;
+    }
+
+    seed_color seed;
+    try {
+        seed = parse_seed(seed_response.body,
+                          services::build_id_url(input.query_key,
+                                                 input.query_value));
+    } catch (const std::exception &e) {
+        context->followup(dpp::message("Failed to parse color response: " +
+                                       std::string(e.what())));
+        co_return;
+    }
+
+    // Inputs the local parser rejects still get a complement, one round trip
+    // later, from the HSL the API resolved.
+    if (!comp_lookup) {
+        comp_lookup.emplace(services::fetch_color(
+            bot, "hex", complement_hex(seed.h, seed.s, seed.l)));
+    }
+    const services::http_result comp_response = co_await *comp_lookup;
+    if (!comp_response.ok()) {
+        context->followup(dpp::message("API error (complement lookup): " +
+                                       comp_response.error()));
+        co_return;
+    }
+
+    try {
+        auto comp_json = nlohmann::json::parse(comp_response.body);
+        std::string comp_name =
+            comp_json.at("name").at("value").get<std::string>();
+        std::string comp_hex_api =
+            comp_json.at("hex").at("value").get<std::string>();
+        std::string comp_rgb_api =
+            comp_json.at("rgb").at("value").get<std::string>();
+        std::string comp_hsl_api =
+            comp_json.at("hsl").at("value").get<std::string>();
+        int comp_r_api = comp_json.at("rgb").at("r").get<int>();
+        int comp_g_api = comp_json.at("rgb").at("g").get<int>();
+        int comp_b_api = comp_json.at("rgb").at("b").get<int>();
+        std::string description =
+            "Complementary colors are opposite on the "
+            "color wheel. Using them together creates "
+            "strong visual contrast.\n\n"
+            "**Your provided color**\n"
+            "- **Name:** " +
+            seed.name +
+            "\n"
+            "- **HEX:** " +
+            seed.hex +
+            "\n"
+            "- **RGB:** " +
+            seed.rgb +
+            "\n"
+            "- **HSL:** " +
+            seed.hsl +
+            "\n"
+            "- **URL:** [Open](" +
+            seed.url +
+            ")\n\n"
+            "**Complement**\n"
+            "- **Name:** " +
+            comp_name +
+            "\n"
+            "- **HEX:** " +
+            comp_hex_api +
+            "\n"
+            "- **RGB:** " +
+            comp_rgb_api +
+            "\n"
+            "- **HSL:** " +
+            comp_hsl_api + "\n - **URL:** [Open](" +
+            services::build_id_url("hex", comp_hex_api) + "&format=html" +
+            ")\n\n";
+        dpp::message msg(description);
+
+        std::vector<services::rgb_color> palette_colors = {
+            seed.value,
+            {static_cast<uint8_t>(comp_r_api),
+             static_cast<uint8_t>(comp_g_api),
+             static_cast<uint8_t>(comp_b_api)},
+        };
+
+        const std::string palette_image =
+            services::generate_palette_image(palette_colors, true);
+        if (!palette_image.empty()) {
+            msg.add_file("complementary-palette.png", palette_image);
+        }
+
+        context->followup(msg);
+    } catch (const std::exception &e) {
+        context->followup(
+            dpp::message("Failed to parse complement response: " +
+                         std::string(e.what())));
+    }
+}
+} // namespace
+
+void handle_complementary(dpp::cluster &bot,
+                          const services::interaction_context &event) {
+    const services::single_color_input_result &input = event.color;
     if (!input.ok) {
         event.reply(input.error);
         return;
     }
 
-    const std::string &query_key = input.query_key;
-    const std::string &query_value = input.query_value;
-
     event.thinking();
-    const std::string token = event.command.token;
-
-    services::fetch_color(
-        bot, query_key, query_value,
-        [&bot, token, query_key, query_value](bool ok, std::string body) {
-            if (!ok) {
-                bot.interaction_followup_create(
-                    token, dpp::message("API error: " + body));
-                return;
-            }
-
-            try {
-                auto j = nlohmann::json::parse(body);
-
-                std::string name = j.at("name").at("value").get<std::string>();
-                int h = j.at("hsl").at("h").get<int>();
-                int s = j.at("hsl").at("s").get<int>();
-                int l = j.at("hsl").at("l").get<int>();
-                std::string seed_hex =
-                    j.at("hex").at("value").get<std::string>();
-                std::string seed_rgb =
-                    j.at("rgb").at("value").get<std::string>();
-                std::string seed_hsl =
-                    j.at("hsl").at("value").get<std::string>();
-                int seed_r = j.at("rgb").at("r").get<int>();
-                int seed_g = j.at("rgb").at("g").get<int>();
-                int seed_b = j.at("rgb").at("b").get<int>();
-
-                int comp_h = (h + 180) % 360;
-                int comp_s = s;
-                int comp_l = l;
-
-                services::rgb_color comp_rgb{};
-                services::hsl_to_rgb(comp_h, comp_s, comp_l, comp_rgb);
-
-                std::string comp_hex = services::rgb_to_hex(comp_rgb);
-                std::string original_url = services::resolve_self_url(
-                    j, services::build_id_url(query_key, query_value));
-
-                services::fetch_color(
-                    bot, "hex", comp_hex,
-                    [&bot, token, name, seed_hex, seed_rgb, seed_hsl, comp_hex,
-                     original_url, seed_r, seed_g,
-                     seed_b](bool comp_ok, std::string comp_body) {
-                        if (!comp_ok) {
-                            bot.interaction_followup_create(
-                                token,
-                                dpp::message("API error (complement lookup): " +
-                                             comp_body));
-                            return;
-                        }
-
-                        try {
-                            auto comp_json = nlohmann::json::parse(comp_body);
-                            std::string comp_name = comp_json.at("name")
-                                                        .at("value")
-                                                        .get<std::string>();
-                            std::string comp_hex_api = comp_json.at("hex")
-                                                           .at("value")
-                                                           .get<std::string>();
-                            std::string comp_rgb_api = comp_json.at("rgb")
-                                                           .at("value")
-                                                           .get<std::string>();
-                            std::string comp_hsl_api = comp_json.at("hsl")
-                                                           .at("value")
-                                                           .get<std::string>();
-                            int comp_r_api =
-                                comp_json.at("rgb").at("r").get<int>();
-                            int comp_g_api =
-                                comp_json.at("rgb").at("g").get<int>();
-                            int comp_b_api =
-                                comp_json.at("rgb").at("b").get<int>();
-                            std::string description =
-                                "Complementary colors are opposite on the "
-                                "color wheel. Using them together creates "
-                                "strong visual contrast.\n\n"
-                                "**Your provided color**\n"
-                                "- **Name:** " +
-                                name +
-                                "\n"
-                                "- **HEX:** " +
-                                seed_hex +
-                                "\n"
-                                "- **RGB:** " +
-                                seed_rgb +
-                                "\n"
-                                "- **HSL:** " +
-                                seed_hsl +
-                                "\n"
-                                "- **URL:** [Open](" +
-                                original_url +
-                                ")\n\n"
-                                "**Complement**\n"
-                                "- **Name:** " +
-                                comp_name +
-                                "\n"
-                                "- **HEX:** " +
-                                comp_hex_api +
-                                "\n"
-                                "- **RGB:** " +
-                                comp_rgb_api +
-                                "\n"
-                                "- **HSL:** " +
-                                comp_hsl_api + "\n - **URL:** [Open](" +
-                                services::build_id_url("hex", comp_hex_api) +
-                                "&format=html" + ")\n\n";
-                            dpp::message msg(description);
-
-                            std::vector<services::rgb_color> palette_colors = {
-                                {static_cast<uint8_t>(seed_r),
-                                 static_cast<uint8_t>(seed_g),
-                                 static_cast<uint8_t>(seed_b)},
-                                {static_cast<uint8_t>(comp_r_api),
-                                 static_cast<uint8_t>(comp_g_api),
-                                 static_cast<uint8_t>(comp_b_api)},
-                            };
-
-                            const std::string palette_image =
-                                services::generate_palette_image(palette_colors,
-                                                                 true);
-                            if (!palette_image.empty()) {
-                                msg.add_file("complementary-palette.png",
-                                             palette_image);
-                            }
-
-                            bot.interaction_followup_create(token, msg);
-                        } catch (const std::exception &e) {
-                            bot.interaction_followup_create(
-                                token,
-                                dpp::message(
-                                    "Failed to parse complement response: " +
-                                    std::string(e.what())));
-                        }
-                    });
-            } catch (const std::exception &e) {
-                bot.interaction_followup_create(
-                    token, dpp::message("Failed to parse color response: " +
-                                        std::string(e.what())));
-            }
-        });
+    lookup_complementary(bot, event.shared_from_this());
 }
 
 } // namespace palette::commands
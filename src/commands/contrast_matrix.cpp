@@ -0,0 +1,154 @@
+#include "palette/commands/contrast_matrix.hpp"
+#include "palette/services/color_utils.hpp"
+#include "palette/services/contrast_matrix.hpp"
+#include "palette/services/env_utils.hpp"
+#include "palette/services/palette_image.hpp"
+#include <array>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace palette::commands {
+namespace {
+services::rgb_color grade_fill(services::contrast_grade grade) {
+    switch (grade) {
+    case services::contrast_grade::aaa:
+        return {27, 94, 32};
+    case services::contrast_grade::aa:
+        return {67, 160, 71};
+    case services::contrast_grade::large_text:
+        return {249, 168, 37};
+    case services::contrast_grade::fail:
+        return {198, 40, 40};
+    }
+    return {198, 40, 40};
+}
+
+std::string format_value(services::contrast_method method, float value) {
+    std::ostringstream ss;
+    if (method == services::contrast_method::apca) {
+        ss << static_cast<int>(std::lround(value));
+    } else {
+        ss << std::fixed << std::setprecision(1) << value;
+    }
+    return ss.str();
+}
+
+std::string color_legend(const char *title,
+                         const std::vector<services::rgb_color> &colors) {
+    std::string out = std::string("**") + title + "**\n";
+    for (size_t i = 0; i < colors.size(); ++i) {
+        out += std::to_string(i + 1) + ". " + services::rgb_to_hex(colors[i]) +
+               "\n";
+    }
+    return out;
+}
+} // namespace
+
+void handle_contrast_matrix(dpp::cluster &bot,
+                            const services::interaction_context &event) {
+    (void)bot;
+
+    const services::multi_color_input_result input =
+        services::parse_multi_color_input(
+            event, services::kMaxContrastMatrixColors);
+    if (!input.ok) {
+        event.reply(input.error);
+        return;
+    }
+
+    std::vector<services::rgb_color> backgrounds;
+    std::string backgrounds_raw;
+    const bool has_backgrounds = services::read_optional_string(
+        event.get_parameter("backgrounds"), backgrounds_raw);
+    if (has_backgrounds) {
+        if (!services::parse_color_list(backgrounds_raw,
+                                        services::color_model::hex,
+                                        backgrounds)) {
+            event.reply("Invalid `backgrounds` list. Use hex colors separated "
+                        "by ';'.");
+            return;
+        }
+        if (backgrounds.size() > services::kMaxContrastMatrixColors) {
+            event.reply("Provide at most " +
+                        std::to_string(services::kMaxContrastMatrixColors) +
+                        " background colors.");
+            return;
+        }
+    } else {
+        if (input.colors.size() < 2) {
+            event.reply("Provide at least 2 colors, or a `backgrounds` list.");
+            return;
+        }
+        backgrounds = input.colors;
+    }
+
+    std::string method_name = "wcag";
+    services::read_optional_string(event.get_parameter("method"), method_name);
+    services::contrast_method method = services::contrast_method::wcag;
+    if (!services::parse_contrast_method(
+            services::normalize_ascii_lower(method_name), method)) {
+        event.reply("`method` must be one of: wcag, apca.");
+        return;
+    }
+
+    const services::contrast_matrix matrix =
+        services::compute_contrast_matrix(input.colors, backgrounds, method);
+
+    std::array<size_t, 4> grade_counts{};
+    std::vector<services::heatmap_cell> cells;
+    cells.reserve(matrix.values.size());
+    for (size_t row = 0; row < matrix.rows; ++row) {
+        for (size_t col = 0; col < matrix.columns; ++col) {
+            if (!has_backgrounds && row == col) {
+                cells.push_back({{230, 230, 230}, "-", ""});
+                continue;
+            }
+            const float value = matrix.at(row, col);
+            const services::contrast_grade grade =
+                services::grade_contrast(method, value);
+            ++grade_counts[static_cast<size_t>(grade)];
+            cells.push_back({grade_fill(grade), format_value(method, value),
+                             services::contrast_grade_label(grade)});
+        }
+    }
+
+    const bool apca = method == services::contrast_method::apca;
+    std::string description =
+        "**Contrast Matrix**\n" +
+        std::string(apca ? "APCA lightness contrast (Lc) of each row color "
+                           "as text on each column color. |Lc| 90 suits "
+                           "body text, 75 content text and 60 large text.\n\n"
+                         : "WCAG contrast ratio of each row color as text on "
+                           "each column color. AAA needs 7:1, AA 4.5:1 and "
+                           "large text (AA18) 3:1.\n\n") +
+        "- **AAA:** " +
+        std::to_string(grade_counts[static_cast<size_t>(
+            services::contrast_grade::aaa)]) +
+        " pairs\n- **AA:** " +
+        std::to_string(
+            grade_counts[static_cast<size_t>(services::contrast_grade::aa)]) +
+        " pairs\n- **Large text only:** " +
+        std::to_string(grade_counts[static_cast<size_t>(
+            services::contrast_grade::large_text)]) +
+        " pairs\n- **Fail:** " +
+        std::to_string(
+            grade_counts[static_cast<size_t>(services::contrast_grade::fail)]) +
+        " pairs\n\n" + color_legend("Text (rows)", input.colors);
+    if (has_backgrounds) {
+        description +=
+            "\n" + color_legend("Backgrounds (columns)", backgrounds);
+    }
+
+    dpp::message msg(event.channel_id, description);
+    const std::string image_data =
+        services::generate_heatmap_image(input.colors, backgrounds, cells);
+    if (!image_data.empty()) {
+        msg.add_file("contrast-matrix.png", image_data);
+    }
+    event.reply(msg);
+}
+
+} // namespace palette::commands
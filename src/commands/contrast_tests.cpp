@@ -1,5 +1,6 @@
 #include "palette/commands/contrast.hpp"
 #include "palette/services/color_utils.hpp"
+#include "palette/services/contrast_fix.hpp"
 #include "palette/services/palette_image.hpp"
 #include <algorithm>
 #include <cctype>
@@ -37,12 +38,11 @@ std::vector<std::string> contrast_image_lines(const std::string &hex_no_hash,
     };
 }
 
-void handle_contrast_test(const dpp::slashcommand_t &event,
+void handle_contrast_test(const services::interaction_context &event,
                           services::rgb_color background,
                           const std::string &background_name,
                           bool background_is_black) {
-    const services::single_color_input_result input =
-        services::parse_single_color_input(event);
+    const services::single_color_input_result &input = event.color;
     if (!input.ok) {
         event.reply(input.error);
         return;
@@ -79,7 +79,21 @@ void handle_contrast_test(const dpp::slashcommand_t &event,
         pass_fail(result.aaa_normal) + "\n" + "- AAA large text (4.5:1): " +
         pass_fail(result.aaa_large);
 
-    dpp::message msg(event.command.channel_id, description);
+    if (!result.aa_normal) {
+        const std::vector<services::contrast_fix> fixes =
+            services::find_contrast_fixes(text_color, background, 4.5);
+        if (!fixes.empty()) {
+            std::ostringstream fix_ratio_ss;
+            fix_ratio_ss << std::fixed << std::setprecision(2)
+                         << fixes.front().ratio;
+            description += "\n\nNearest AA alternative: " +
+                           services::rgb_to_hex(fixes.front().color) + " (" +
+                           fix_ratio_ss.str() +
+                           ":1). Use `/accessible` for more options.";
+        }
+    }
+
+    dpp::message msg(event.channel_id, description);
     const std::vector<std::string> lines =
         contrast_image_lines(hex_no_hash, background_name, result.pass_count,
                              result.rating_percent);
@@ -104,7 +118,8 @@ std::string to_lower_ascii(std::string value) {
 }
 } // namespace
 
-void handle_contrast(dpp::cluster &bot, const dpp::slashcommand_t &event) {
+void handle_contrast(dpp::cluster &bot,
+                     const services::interaction_context &event) {
     (void)bot;
 
     auto background_param = event.get_parameter("background");
@@ -0,0 +1,117 @@
+#include "palette/commands/distinct.hpp"
+#include "palette/services/color_utils.hpp"
+#include "palette/services/distinct_palette.hpp"
+#include "palette/services/palette_image.hpp"
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace palette::commands {
+namespace {
+constexpr int kDefaultCount = 8;
+constexpr size_t kMaxListedColors = 32;
+
+// Reads an optional 0-100 integer option into `out`.
+bool read_percent(const services::interaction_context &event, const char *name,
+                  int &out) {
+    const auto param = event.get_parameter(name);
+    if (const auto *p = std::get_if<int64_t>(&param)) {
+        if (*p < 0 || *p > 100) {
+            return false;
+        }
+        out = static_cast<int>(*p);
+    }
+    return true;
+}
+} // namespace
+
+void handle_distinct(dpp::cluster &bot,
+                     const services::interaction_context &event) {
+    (void)bot;
+
+    int count = kDefaultCount;
+    const auto count_param = event.get_parameter("count");
+    if (const auto *p = std::get_if<int64_t>(&count_param)) {
+        count = static_cast<int>(*p);
+    }
+    if (count < services::kMinDistinctColors ||
+        count > services::kMaxDistinctColors) {
+        event.reply("`count` must be an integer from " +
+                    std::to_string(services::kMinDistinctColors) + " to " +
+                    std::to_string(services::kMaxDistinctColors) + ".");
+        return;
+    }
+
+    int min_lightness = 0;
+    int max_lightness = 100;
+    int min_chroma = 0;
+    int max_chroma = 100;
+    if (!read_percent(event, "min_lightness", min_lightness) ||
+        !read_percent(event, "max_lightness", max_lightness) ||
+        !read_percent(event, "min_chroma", min_chroma) ||
+        !read_percent(event, "max_chroma", max_chroma)) {
+        event.reply("Lightness and chroma limits must be integers from 0 to "
+                    "100.");
+        return;
+    }
+    if (min_lightness > max_lightness || min_chroma > max_chroma) {
+        event.reply("Each `min_` limit must not exceed its `max_` limit.");
+        return;
+    }
+
+    services::distinct_constraints limits;
+    limits.min_lightness = min_lightness / 100.0;
+    limits.max_lightness = max_lightness / 100.0;
+    limits.min_chroma = min_chroma / 100.0 * 0.4;
+    limits.max_chroma = max_chroma / 100.0 * 0.4;
+    const services::distinct_palette palette =
+        services::generate_distinct_palette(count, limits);
+    if (palette.colors.empty()) {
+        event.reply("No sRGB colors fit these lightness and chroma limits.");
+        return;
+    }
+
+    std::ostringstream distance_ss;
+    distance_ss << std::fixed << std::setprecision(1) << palette.min_distance;
+
+    std::string description =
+        "**Distinct palette**\n"
+        "Colors are spread as far apart as possible in OKLab, so any two "
+        "stay easy to tell apart. Earlier colors are the best picks for "
+        "smaller sets.\n\n"
+        "- **Colors:** " +
+        std::to_string(palette.colors.size()) + "\n" +
+        "- **Lightness:** " + std::to_string(min_lightness) + "-" +
+        std::to_string(max_lightness) + "%\n" +
+        "- **Chroma:** " + std::to_string(min_chroma) + "-" +
+        std::to_string(max_chroma) + "%\n" +
+        "- **Closest pair:** ΔE " + distance_ss.str() + "\n\n";
+    if (palette.colors.size() < static_cast<size_t>(count)) {
+        description += "Only " + std::to_string(palette.colors.size()) +
+                       " colors fit these limits.\n\n";
+    }
+
+    std::string all_hex;
+    for (size_t i = 0; i < palette.colors.size(); ++i) {
+        const std::string hex = services::rgb_to_hex(palette.colors[i]);
+        all_hex += hex + "\n";
+        if (i < kMaxListedColors) {
+            description += std::to_string(i + 1) + ". " + hex + "\n";
+        }
+    }
+
+    dpp::message msg(event.channel_id, description);
+    if (palette.colors.size() > kMaxListedColors) {
+        msg.content += "Hex codes for every color are in distinct.txt.";
+        msg.add_file("distinct.txt", all_hex);
+    }
+    const std::string image_data =
+        services::generate_palette_image(palette.colors, true);
+    if (!image_data.empty()) {
+        msg.add_file("distinct.png", image_data);
+    }
+    event.reply(msg);
+}
+
+} // namespace palette::commands
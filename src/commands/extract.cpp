@@ -0,0 +1,119 @@
+#include "palette/commands/extract.hpp"
+#include "palette/services/color_utils.hpp"
+#include "palette/services/detached_task.hpp"
+#include "palette/services/http_request.hpp"
+#include "palette/services/image_decode.hpp"
+#include "palette/services/palette_extract.hpp"
+#include "palette/services/palette_image.hpp"
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace palette::commands {
+namespace {
+constexpr uint32_t kMaxAttachmentBytes = 8U * 1024U * 1024U;
+
+void reply_with_palette(const services::interaction_context &context,
+                        const std::string &body, int count) {
+    const services::image_sample_result sampled =
+        services::sample_image_pixels(body, services::kExtractSampleBudget);
+    if (!sampled.ok) {
+        context.followup(dpp::message(sampled.error));
+        return;
+    }
+
+    const std::vector<services::extracted_color> extracted =
+        services::extract_dominant_colors(sampled.samples, count);
+    if (extracted.empty()) {
+        context.followup(
+            dpp::message("Could not find any colors in the image."));
+        return;
+    }
+
+    std::string description =
+        "**Dominant Colors**\n"
+        "The most common colors of the image, clustered in the perceptual "
+        "OKLab space and ordered by how much of the image they cover.\n\n"
+        "- **Image:** " +
+        std::to_string(sampled.width) + "x" + std::to_string(sampled.height) +
+        " (" + std::to_string(sampled.samples.size()) + " pixels sampled)\n";
+
+    std::vector<services::rgb_color> colors;
+    colors.reserve(extracted.size());
+    for (size_t i = 0; i < extracted.size(); ++i) {
+        std::ostringstream share_ss;
+        share_ss << std::fixed << std::setprecision(1) << extracted[i].share;
+        description += std::to_string(i + 1) + ". " +
+                       services::rgb_to_hex(extracted[i].color) + " (" +
+                       share_ss.str() + "%)\n";
+        colors.push_back(extracted[i].color);
+    }
+
+    dpp::message msg(description);
+    const std::string image_data =
+        services::generate_palette_image(colors, true);
+    if (!image_data.empty()) {
+        msg.add_file("extract-palette.png", image_data);
+    }
+    context.followup(msg);
+}
+
+services::detached_task
+download_and_extract(dpp::cluster &bot, services::interaction_handle context,
+                     std::string url, int count) {
+    // Resumes on the render lane: decoding is CPU heavy.
+    const services::http_result response =
+        co_await services::start_request(bot, url, task_class::render);
+    if (response.status != 200) {
+        context->followup(
+            dpp::message("Failed to download the image (HTTP " +
+                         std::to_string(response.status) + ")."));
+        co_return;
+    }
+    if (response.body.size() > kMaxAttachmentBytes) {
+        context->followup(dpp::message("`image` must be at most 8 MB."));
+        co_return;
+    }
+    reply_with_palette(*context, response.body, count);
+}
+} // namespace
+
+void handle_extract(dpp::cluster &bot,
+                    const services::interaction_context &event) {
+    const auto image_param = event.get_parameter("image");
+    const auto *attachment_id = std::get_if<dpp::snowflake>(&image_param);
+    if (!attachment_id) {
+        event.reply("`image` is required and must be an uploaded image.");
+        return;
+    }
+
+    const dpp::attachment attachment =
+        event.get_resolved_attachment(*attachment_id);
+    if (attachment.url.empty()) {
+        event.reply("Could not read the uploaded `image`.");
+        return;
+    }
+    if (attachment.size > kMaxAttachmentBytes) {
+        event.reply("`image` must be at most 8 MB.");
+        return;
+    }
+
+    int count = 5;
+    const auto count_param = event.get_parameter("count");
+    if (const auto *p = std::get_if<int64_t>(&count_param)) {
+        count = static_cast<int>(*p);
+    }
+    if (count < services::kMinExtractColors ||
+        count > services::kMaxExtractColors) {
+        event.reply("`count` must be an integer from " +
+                    std::to_string(services::kMinExtractColors) + " to " +
+                    std::to_string(services::kMaxExtractColors) + ".");
+        return;
+    }
+
+    event.thinking();
+    download_and_extract(bot, event.shared_from_this(), attachment.url, count);
+}
+
+} // namespace palette::commands
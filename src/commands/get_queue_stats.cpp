@@ -0,0 +1,69 @@
+#include "palette/commands/get_queue_stats.hpp"
+#include "palette/buttons/palette_clicks.hpp"
+#include "palette/services/handler_cost.hpp"
+#include "palette/services/http_request.hpp"
+#include "palette/services/ratelimit.hpp"
+#include "palette/services/thread_pool.hpp"
+#include <iomanip>
+#include <sstream>
+
+namespace palette::commands {
+
+void handle_get_queue_stats(dpp::cluster &bot,
+                            const services::interaction_context &event) {
+    (void)bot;
+    const services::thread_pool *const pool =
+        services::thread_pool::current();
+    if (!pool) {
+        event.reply("Queue statistics are only available from the pool.");
+        return;
+    }
+
+    const services::scaling_stats scaling = pool->scaling();
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(3);
+    ss << "Workers: " << scaling.workers << " (" << scaling.min_workers << "-"
+       << scaling.max_workers << "), grown " << scaling.grown
+       << " times, shrunk " << scaling.shrunk << " times\n"
+       << "Last window: " << services::scaling_decision_label(
+                                 scaling.last_decision)
+       << ", wait p90 <= " << scaling.window_p90_ms << " ms, utilization "
+       << static_cast<int>(scaling.utilization * 100.0) << "%\n";
+    for (const task_class lane : {task_class::interactive, task_class::render,
+                                  task_class::background}) {
+        const services::thread_pool::lane_stats stats = pool->stats(lane);
+        ss << "\n**" << services::task_class_label(lane) << "** (limit "
+           << stats.limit << ")\n"
+           << "- Queued: " << stats.queued << "/" << stats.capacity
+           << ", running: " << stats.running
+           << ", service: " << stats.service_ms << " ms\n"
+           << "- Shed: " << stats.shed_full << " full, "
+           << stats.shed_over_budget << " over budget; expired: "
+           << stats.expired << "\n"
+           << "- Waits: " << stats.wait.total() << ", p50 <= "
+           << stats.wait.percentile_ms(0.5) << " ms, p90 <= "
+           << stats.wait.percentile_ms(0.9) << " ms, p99 <= "
+           << stats.wait.percentile_ms(0.99) << " ms\n";
+    }
+
+    // Should stay near zero: completions only hand the response to the pool.
+    const services::http_completion_stats http = services::completion_stats();
+    ss << "\n**HTTP completions** (on D++ threads)\n"
+       << "- Completions: " << http.completions << ", total "
+       << http.total_ms << " ms, max " << http.max_ms << " ms\n";
+    const services::handler_cost_stats costs = services::handler_costs();
+    ss << "\n**Handlers**\n- Timed: " << costs.samples
+       << ", deferred to fit the response window: " << costs.auto_deferred
+       << "\n";
+    ss << "\n**Rate limiter**\n- Users tracked: "
+       << services::ratelimited_users() << "\n";
+    const buttons::palette_click_stats clicks = buttons::palette_clicks();
+    ss << "\n**Palette buttons**\n- Clicks: " << clicks.clicks
+       << ", coalesced " << clicks.coalesced << ", rendered " << clicks.renders
+       << " (" << clicks.rerenders << " re-rendered), wasted "
+       << clicks.wasted << "\n";
+
+    event.reply(dpp::embed().set_description(ss.str()));
+}
+
+} // namespace palette::commands
@@ -3,7 +3,7 @@
 namespace palette::commands {
 
 void handle_get_server_count(dpp::cluster &_,
-                             const dpp::slashcommand_t &event) {
+                             const services::interaction_context &event) {
     dpp::embed embed = dpp::embed();
     auto server_count = dpp::get_guild_count();
     embed.set_description(std::string("Palette's total server count: ") +
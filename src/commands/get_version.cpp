@@ -23,7 +23,8 @@ std::optional<std::string> get_deployed_tag(
     return tag; // e.g. "v1.2.3"
 }
 
-void handle_get_version(dpp::cluster &_, const dpp::slashcommand_t &event) {
+void handle_get_version(dpp::cluster &_,
+                        const services::interaction_context &event) {
     dpp::embed embed = dpp::embed();
     std::optional<std::string> version = get_deployed_tag();
     if (version) {
@@ -0,0 +1,103 @@
+#include "palette/commands/gradient.hpp"
+#include "palette/services/color_utils.hpp"
+#include "palette/services/env_utils.hpp"
+#include "palette/services/gradient.hpp"
+#include "palette/services/palette_image.hpp"
+#include <string>
+#include <vector>
+
+namespace palette::commands {
+namespace {
+constexpr size_t kMaxListedSteps = 32;
+} // namespace
+
+void handle_gradient(dpp::cluster &bot,
+                     const services::interaction_context &event) {
+    (void)bot;
+
+    const services::multi_color_input_result input =
+        services::parse_multi_color_input(event, services::kMaxGradientStops);
+    if (!input.ok) {
+        event.reply(input.error);
+        return;
+    }
+    if (input.colors.size() < 2) {
+        event.reply("Provide at least 2 colors as gradient stops.");
+        return;
+    }
+
+    int steps = 8;
+    const auto steps_param = event.get_parameter("steps");
+    if (const auto *p = std::get_if<int64_t>(&steps_param)) {
+        steps = static_cast<int>(*p);
+    }
+    if (steps < services::kMinGradientSteps ||
+        steps > services::kMaxGradientSteps) {
+        event.reply("`steps` must be an integer from " +
+                    std::to_string(services::kMinGradientSteps) + " to " +
+                    std::to_string(services::kMaxGradientSteps) + ".");
+        return;
+    }
+
+    std::string space_name = "oklab";
+    services::read_optional_string(event.get_parameter("space"), space_name);
+    services::gradient_space space = services::gradient_space::oklab;
+    if (!services::parse_gradient_space(
+            services::normalize_ascii_lower(space_name), space)) {
+        event.reply("`space` must be one of: srgb, linear, oklab, oklch.");
+        return;
+    }
+
+    std::string hue_name = "shorter";
+    services::read_optional_string(event.get_parameter("hue"), hue_name);
+    services::hue_path path = services::hue_path::shorter;
+    if (!services::parse_hue_path(services::normalize_ascii_lower(hue_name),
+                                  path)) {
+        event.reply("`hue` must be one of: shorter, longer, increasing, "
+                    "decreasing.");
+        return;
+    }
+
+    const std::vector<services::rgb_color> strip =
+        services::interpolate_gradient(input.colors, space, path,
+                                       services::kGradientStripWidth);
+    const std::vector<services::rgb_color> swatches =
+        services::interpolate_gradient(input.colors, space, path,
+                                       static_cast<size_t>(steps));
+
+    std::string description =
+        "**Gradient**\n"
+        "A gradient blends between color stops. Perceptual spaces like OKLab "
+        "keep lightness changes even; linear RGB matches how light mixes.\n\n"
+        "- **Space:** " +
+        std::string(services::gradient_space_label(space));
+    if (space == services::gradient_space::oklch) {
+        description += " (" + services::normalize_ascii_lower(hue_name) +
+                       " hue path)";
+    }
+    description += "\n- **Stops:**";
+    for (const services::rgb_color stop : input.colors) {
+        description += " " + services::rgb_to_hex(stop);
+    }
+    description += "\n- **Steps:** " + std::to_string(steps) + "\n\n";
+
+    if (swatches.size() <= kMaxListedSteps) {
+        for (size_t i = 0; i < swatches.size(); ++i) {
+            description += std::to_string(i + 1) + ". " +
+                           services::rgb_to_hex(swatches[i]) + "\n";
+        }
+    } else {
+        description += "Hex codes are listed for up to " +
+                       std::to_string(kMaxListedSteps) + " steps.";
+    }
+
+    dpp::message msg(event.channel_id, description);
+    const std::string image_data =
+        services::generate_gradient_image(strip, swatches);
+    if (!image_data.empty()) {
+        msg.add_file("gradient.png", image_data);
+    }
+    event.reply(msg);
+}
+
+} // namespace palette::commands
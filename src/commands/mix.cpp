@@ -1,11 +1,43 @@
 #include "palette/commands/mix.hpp"
+#include "palette/services/color_mix.hpp"
 #include "palette/services/color_utils.hpp"
+#include "palette/services/cvd.hpp"
+#include "palette/services/env_utils.hpp"
 #include "palette/services/palette_image.hpp"
 #include <string>
 #include <vector>
 
 namespace palette::commands {
 namespace {
+// Longer input lists drop the rgb() column to stay within one message.
+constexpr size_t kMaxDetailedInputs = 10;
+
+std::string format_weight(double weight) {
+    std::string text = std::to_string(weight);
+    text.erase(text.find_last_not_of('0') + 1);
+    if (!text.empty() && text.back() == '.') {
+        text.pop_back();
+    }
+    return text;
+}
+
+std::string mode_explanation(services::mix_mode mode) {
+    switch (mode) {
+    case services::mix_mode::srgb:
+        return "Mixing blends source colors by averaging their RGB channels.";
+    case services::mix_mode::linear:
+        return "Mixing blends source colors like overlapping light, averaging "
+               "in linear RGB.";
+    case services::mix_mode::oklab:
+        return "Mixing blends source colors perceptually, averaging in OKLab.";
+    case services::mix_mode::pigment:
+        return "Mixing blends source colors like paint: each becomes a "
+               "reflectance spectrum and the pigments combine with "
+               "Kubelka-Munk absorption and scattering.";
+    }
+    return std::string();
+}
+
 std::string rgb_label(services::rgb_color color) {
     return "rgb(" + std::to_string(static_cast<int>(color.r)) + "," +
            std::to_string(static_cast<int>(color.g)) + "," +
@@ -13,11 +45,11 @@ std::string rgb_label(services::rgb_color color) {
 }
 } // namespace
 
-void handle_mix(dpp::cluster &bot, const dpp::slashcommand_t &event) {
+void handle_mix(dpp::cluster &bot, const services::interaction_context &event) {
     (void)bot;
 
     const services::multi_color_input_result input =
-        services::parse_multi_color_input(event, 3);
+        services::parse_multi_color_input(event, services::kMaxMixColors);
     if (!input.ok) {
         event.reply(input.error);
         return;
@@ -27,27 +59,68 @@ void handle_mix(dpp::cluster &bot, const dpp::slashcommand_t &event) {
         return;
     }
 
-    const services::rgb_color mixed = services::mix_colors(input.colors);
+    const services::cvd_input_result cvd = services::parse_cvd_input(event);
+    if (!cvd.ok) {
+        event.reply(cvd.error);
+        return;
+    }
+
+    std::string mode_name = "srgb";
+    services::read_optional_string(event.get_parameter("mode"), mode_name);
+    services::mix_mode mode = services::mix_mode::srgb;
+    if (!services::parse_mix_mode(services::normalize_ascii_lower(mode_name),
+                                  mode)) {
+        event.reply("`mode` must be one of: srgb, linear, oklab, pigment.");
+        return;
+    }
+
+    std::vector<double> weights;
+    std::string weights_raw;
+    if (services::read_optional_string(event.get_parameter("weights"),
+                                       weights_raw)) {
+        std::string error;
+        if (!services::parse_mix_weights(weights_raw, input.colors.size(),
+                                         weights, error)) {
+            event.reply(error);
+            return;
+        }
+    }
+
+    const services::rgb_color mixed =
+        services::mix_colors_weighted(input.colors, weights, mode);
     std::vector<services::rgb_color> palette_colors = input.colors;
     palette_colors.push_back(mixed);
 
-    std::string description =
-        "**Color Mixing**\n"
-        "Mixing blends source colors by averaging their RGB channels.\n\n"
-        "**Inputs**\n";
+    std::string description = "**Color Mixing**\n" + mode_explanation(mode) +
+                              "\n\n- **Mode:** " +
+                              services::mix_mode_label(mode) +
+                              "\n\n**Inputs**\n";
+    const bool detailed = input.colors.size() <= kMaxDetailedInputs;
     for (size_t i = 0; i < input.colors.size(); ++i) {
         const services::rgb_color c = input.colors[i];
-        description += std::to_string(i + 1) + ". " + services::rgb_to_hex(c) +
-                       " | " + rgb_label(c) + "\n";
+        description += std::to_string(i + 1) + ". " + services::rgb_to_hex(c);
+        if (detailed) {
+            description += " | " + rgb_label(c);
+        }
+        if (!weights.empty()) {
+            description += " | " + format_weight(weights[i]) + " parts";
+        }
+        description += "\n";
     }
 
     description += "\n**Mixed Result**\n" +
                    std::to_string(input.colors.size() + 1) + ". " +
                    services::rgb_to_hex(mixed) + " | " + rgb_label(mixed);
+    if (cvd.simulation) {
+        description += "\n\n- **Simulated vision:** " +
+                       services::cvd_label(*cvd.simulation);
+    }
 
-    dpp::message msg(event.command.channel_id, description);
+    dpp::message msg(event.channel_id, description);
     const std::string image_data =
-        services::generate_palette_image(palette_colors, true);
+        cvd.simulation ? services::generate_cvd_comparison_image(
+                             palette_colors, *cvd.simulation)
+                       : services::generate_palette_image(palette_colors, true);
     if (!image_data.empty()) {
         msg.add_file("mixed-palette.png", image_data);
     }
@@ -0,0 +1,151 @@
+#include "palette/commands/quantize.hpp"
+#include "palette/services/color_utils.hpp"
+#include "palette/services/env_utils.hpp"
+#include "palette/services/palette_image.hpp"
+#include "palette/services/quantize.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace palette::commands {
+namespace {
+bool same_color(services::rgb_color a, services::rgb_color b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+bool collect_role_colors(const services::interaction_context &event,
+                         std::vector<services::rgb_color> &out) {
+    const dpp::guild *guild = dpp::find_guild(event.guild_id);
+    if (!guild) {
+        return false;
+    }
+
+    for (const dpp::snowflake role_id : guild->roles) {
+        const dpp::role *role = dpp::find_role(role_id);
+        // A colour of 0 means the role does not override the member color.
+        if (!role || role->colour == 0) {
+            continue;
+        }
+
+        const services::rgb_color color{
+            static_cast<uint8_t>((role->colour >> 16) & 0xFF),
+            static_cast<uint8_t>((role->colour >> 8) & 0xFF),
+            static_cast<uint8_t>(role->colour & 0xFF)};
+        if (std::none_of(out.begin(), out.end(),
+                         [color](services::rgb_color existing) {
+                             return same_color(existing, color);
+                         })) {
+            out.push_back(color);
+        }
+        if (out.size() >= services::kMaxQuantizePaletteSize) {
+            break;
+        }
+    }
+    return !out.empty();
+}
+} // namespace
+
+void handle_quantize(dpp::cluster &bot,
+                     const services::interaction_context &event) {
+    (void)bot;
+
+    const services::single_color_input_result &input = event.color;
+    if (!input.ok) {
+        event.reply(input.error);
+        return;
+    }
+
+    services::rgb_color original{};
+    if (!services::parse_query_color_to_rgb(input.query_key, input.query_value,
+                                            original)) {
+        event.reply("Could not parse the input value for `" + input.query_key +
+                    "`.");
+        return;
+    }
+
+    std::string palette_name;
+    services::read_optional_string(event.get_parameter("palette"),
+                                   palette_name);
+    std::string custom_colors;
+    const bool has_custom = services::read_optional_string(
+        event.get_parameter("colors"), custom_colors);
+    palette_name = services::normalize_ascii_lower(palette_name);
+    if (palette_name.empty()) {
+        palette_name = has_custom ? "custom" : "websafe";
+    }
+
+    std::vector<services::rgb_color> targets;
+    if (palette_name == "custom") {
+        if (!has_custom || !services::parse_color_list(
+                               custom_colors, services::color_model::hex,
+                               targets)) {
+            event.reply("Provide a `colors` hex list separated by ';' for the "
+                        "custom palette.");
+            return;
+        }
+        if (targets.size() > services::kMaxQuantizePaletteSize) {
+            event.reply("Provide at most " +
+                        std::to_string(services::kMaxQuantizePaletteSize) +
+                        " palette colors.");
+            return;
+        }
+    } else if (palette_name == "roles") {
+        if (!collect_role_colors(event, targets)) {
+            event.reply("This server has no colored roles to compare with.");
+            return;
+        }
+    } else if (!services::resolve_named_palette(palette_name, targets)) {
+        event.reply("`palette` must be one of: websafe, material, tailwind, "
+                    "roles, custom.");
+        return;
+    }
+
+    const auto lut = services::get_palette_lut(targets);
+    if (!lut) {
+        event.reply("Failed to prepare the target palette.");
+        return;
+    }
+
+    const size_t index = services::quantize_index(*lut, original);
+    const services::rgb_color nearest = lut->targets[index];
+    const double distance = std::sqrt(
+        std::pow(static_cast<double>(original.r) - nearest.r, 2.0) +
+        std::pow(static_cast<double>(original.g) - nearest.g, 2.0) +
+        std::pow(static_cast<double>(original.b) - nearest.b, 2.0));
+
+    std::ostringstream distance_ss;
+    distance_ss << std::fixed << std::setprecision(1) << distance;
+
+    std::string description =
+        "**Nearest Palette Color**\n"
+        "Quantizing maps a color to the closest entry of a target palette, "
+        "measured as distance in RGB space.\n\n"
+        "- **Palette:** " +
+        palette_name + " (" + std::to_string(lut->targets.size()) +
+        " colors)\n"
+        "1. **Original:** " +
+        services::rgb_to_hex(original) +
+        "\n"
+        "2. **Nearest:** " +
+        services::rgb_to_hex(nearest) + " (entry " +
+        std::to_string(index + 1) +
+        ")\n"
+        "- **RGB distance:** " +
+        distance_ss.str() +
+        "\n"
+        "- **Exact match:** " +
+        std::string(same_color(original, nearest) ? "Yes" : "No");
+
+    dpp::message msg(event.channel_id, description);
+    const std::string image_data =
+        services::generate_palette_image({original, nearest}, true);
+    if (!image_data.empty()) {
+        msg.add_file("quantize-palette.png", image_data);
+    }
+    event.reply(msg);
+}
+
+} // namespace palette::commands
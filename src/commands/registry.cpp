@@ -1,22 +1,16 @@
 #include "palette/commands/registry.hpp"
-#include "palette/commands/color.hpp"
-#include "palette/commands/complementary.hpp"
-#include "palette/commands/contrast.hpp"
-#include "palette/commands/get_server_count.hpp"
-#include "palette/commands/get_version.hpp"
-#include "palette/commands/mix.hpp"
-#include "palette/commands/scheme.hpp"
-#include "palette/commands/shades.hpp"
-#include "palette/commands/splitcomplementary.hpp"
-#include "palette/commands/tints.hpp"
-#include "palette/commands/websafe.hpp"
+#include "palette/commands/schema.hpp"
 #include "palette/services/env_utils.hpp"
+#include "palette/services/handler_cost.hpp"
+#include "palette/services/interaction_context.hpp"
+#include "palette/services/interaction_deadline.hpp"
 #include "palette/services/message.hpp"
 #include "palette/services/ratelimit.hpp"
+#include <chrono>
 #include <cstdint>
-#include <functional>
 #include <optional>
 #include <random>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -28,37 +22,89 @@ bool one_in_seven() {
 
 namespace palette::commands {
 namespace {
-using command_handler =
-    std::function<void(dpp::cluster &, const dpp::slashcommand_t &)>;
-
-std::string format_command_options(const std::string &command_name,
-                                   const command_option_t &options) {
-    return "Command options for `" + command_name +
-           "` => isPrivate=" + (options.isPrivate ? "true" : "false") +
-           ", isWhitelist=" + (options.isWhitelist ? "true" : "false") +
-           ", requiredVote=" + (options.requiredVote ? "true" : "false") +
-           ", ratelimit=" + std::to_string(options.ratelimit);
+// Runs the handler, first deferring the interaction when what is left of
+// the response window would not cover the command's learned cost, so a slow
+// render lands as an edit of the deferred response instead of being lost.
+// Tasks that waited in the queue past the response deadline always defer;
+// the pool only drops them once the window itself has closed.
+void run_handler(const services::interaction_context &context,
+                 dpp::cluster &bot, command_handler handler, size_t command) {
+    const auto started = std::chrono::steady_clock::now();
+    if (started + services::handler_cost_estimate(command) >
+        context.response_deadline) {
+        context.thinking();
+        services::record_auto_defer();
+    }
+    handler(bot, context);
+    services::record_handler_cost(command,
+                                  std::chrono::steady_clock::now() - started);
 }
 
+// `command` is the spec's position in command_table(), used to learn its
+// cost; anything past services::kMaxTrackedCommands is not tracked.
 void dispatch_async(services::thread_pool &pool, dpp::cluster &bot,
-                    const dpp::slashcommand_t &event,
-                    const command_option_t &options, command_handler handler) {
-    const dpp::slashcommand_t event_copy = event;
-    const std::string options_log =
-        format_command_options(event.command.get_command_name(), options);
-    pool.enqueue([event_copy, &bot, options, handler = std::move(handler)]() {
-        bool is_ratelimited = palette::services::is_ratelimited(
-            event_copy.command.usr.id, int64_t(options.ratelimit));
-        bot.log(dpp::ll_info, std::to_string(options.ratelimit));
-        if (is_ratelimited) {
-            services::send_ratelimited(event_copy);
-            return;
-        }
-        handler(bot, event_copy);
-        if (one_in_seven()) {
-            services::add_suggestion(event_copy);
+                    const dpp::slashcommand_t &event, const command_spec &spec,
+                    size_t command) {
+    // Checked before anything is built or queued for the command.
+    if (services::is_ratelimited(event.command.usr.id, spec.name,
+                                 spec.policy)) {
+        services::send_ratelimited(event);
+        return;
+    }
+    // Built here on the gateway thread and shared by the handler and its
+    // HTTP continuations. The suggestion rides along on whichever message
+    // answers the interaction.
+    static constexpr services::response_decorator kSuggestion[] = {
+        services::append_suggestion};
+    std::span<const services::response_decorator> decorators;
+    if (one_in_seven()) {
+        decorators = kSuggestion;
+    }
+    services::interaction_handle context =
+        services::make_interaction_context(bot, event, spec, decorators);
+    const command_handler handler = spec.handler;
+    const services::admission admitted = pool.try_enqueue(
+        [context, &bot, handler, command]() {
+            run_handler(*context, bot, handler, command);
+        },
+        spec.policy.lane, services::interaction_response_expiry(event.command));
+    if (admitted == services::admission::queue_full ||
+        admitted == services::admission::over_budget) {
+        services::send_busy(event);
+        bot.log(dpp::ll_warning, "Shed `" + event.command.get_command_name() +
+                                     "`: " +
+                                     services::admission_label(admitted));
+    }
+}
+
+dpp::command_option_type option_type(option_kind kind) {
+    switch (kind) {
+    case option_kind::integer:
+        return dpp::co_integer;
+    case option_kind::attachment:
+        return dpp::co_attachment;
+    case option_kind::string:
+        break;
+    }
+    return dpp::co_string;
+}
+
+dpp::slashcommand build_slashcommand(const command_spec &spec,
+                                     dpp::snowflake application_id) {
+    dpp::slashcommand command(std::string(spec.name),
+                              std::string(spec.description), application_id);
+    for (const option_spec &option : spec.options) {
+        dpp::command_option built(option_type(option.kind),
+                                  std::string(option.name),
+                                  std::string(option.description),
+                                  option.required);
+        for (const option_choice &choice : option.choices) {
+            built.add_choice(dpp::command_option_choice(
+                std::string(choice.label), std::string(choice.value)));
         }
-    });
+        command.add_option(built);
+    }
+    return command;
 }
 
 std::optional<dpp::snowflake> resolve_guild_id_for_registration() {
@@ -107,234 +153,37 @@ void register_by_environment(
 } // namespace
 
 void register_commands(dpp::cluster &bot) {
-    dpp::slashcommand color("color", "Identify a color via hex/rgb/hsl/cmyk",
-                            bot.me.id);
-    color.add_option(dpp::command_option(dpp::co_string, "hex",
-                                         "Hex like 24B1E0 or #24B1E0", false));
-    color.add_option(dpp::command_option(
-        dpp::co_string, "rgb", "RGB like 0,71,171 or rgb(0,71,171)", false));
-    color.add_option(dpp::command_option(
-        dpp::co_string, "hsl", "HSL like 215,100%,34% or hsl(...)", false));
-    color.add_option(dpp::command_option(
-        dpp::co_string, "cmyk", "CMYK like 100,58,0,33 or cmyk(...)", false));
-
-    dpp::slashcommand complementary("complementary",
-                                    "Find the complementary color", bot.me.id);
-    complementary.add_option(dpp::command_option(
-        dpp::co_string, "hex", "Hex like 24B1E0 or #24B1E0", false));
-    complementary.add_option(dpp::command_option(
-        dpp::co_string, "rgb", "RGB like 0,71,171 or rgb(0,71,171)", false));
-    complementary.add_option(dpp::command_option(
-        dpp::co_string, "hsl", "HSL like 215,100%,34% or hsl(...)", false));
-    complementary.add_option(dpp::command_option(
-        dpp::co_string, "cmyk", "CMYK like 100,58,0,33 or cmyk(...)", false));
-
-    dpp::slashcommand scheme("scheme", "Generate a color scheme from a seed",
-                             bot.me.id);
-    scheme.add_option(dpp::command_option(dpp::co_string, "hex",
-                                          "Hex like 24B1E0 or #24B1E0", true));
-
-    dpp::command_option mode(dpp::co_string, "mode",
-                             "Scheme mode (default: monochrome)", false);
-    mode.add_choice(dpp::command_option_choice("monochrome", "monochrome"));
-    mode.add_choice(
-        dpp::command_option_choice("monochrome-dark", "monochrome-dark"));
-    mode.add_choice(
-        dpp::command_option_choice("monochrome-light", "monochrome-light"));
-    mode.add_choice(dpp::command_option_choice("analogic", "analogic"));
-    mode.add_choice(dpp::command_option_choice("complement", "complement"));
-    mode.add_choice(dpp::command_option_choice("analogic-complement",
-                                               "analogic-complement"));
-    mode.add_choice(dpp::command_option_choice("triad", "triad"));
-    mode.add_choice(dpp::command_option_choice("quad", "quad"));
-    scheme.add_option(mode);
-
-    scheme.add_option(dpp::command_option(
-        dpp::co_integer, "count", "Number of colors to return (1-20)", false));
-
-    dpp::slashcommand shades(
-        "shades", "Generate numbered shades image (toward black)", bot.me.id);
-    shades.add_option(dpp::command_option(
-        dpp::co_integer, "amount", "Number of shades per color (2-8)", true));
-    shades.add_option(dpp::command_option(
-        dpp::co_string, "hex",
-        "Hex list separated by ';' (example: #FF0000; 00AAFF)", false));
-    shades.add_option(dpp::command_option(
-        dpp::co_string, "rgb",
-        "RGB list separated by ';' (example: 255,0,0; rgb(0,128,255))", false));
-    shades.add_option(dpp::command_option(
-        dpp::co_string, "hsl",
-        "HSL list separated by ';' (example: 0,100%,50%; hsl(210,100%,50%))",
-        false));
-    shades.add_option(dpp::command_option(
-        dpp::co_string, "cmyk",
-        "CMYK list separated by ';' (example: 0,100,100,0; cmyk(100,0,0,0))",
-        false));
-
-    dpp::slashcommand tints(
-        "tints", "Generate numbered tints image (toward white)", bot.me.id);
-    tints.add_option(dpp::command_option(
-        dpp::co_integer, "amount", "Number of tints per color (2-8)", true));
-    tints.add_option(dpp::command_option(
-        dpp::co_string, "hex",
-        "Hex list separated by ';' (example: #FF0000; 00AAFF)", false));
-    tints.add_option(dpp::command_option(
-        dpp::co_string, "rgb",
-        "RGB list separated by ';' (example: 255,0,0; rgb(0,128,255))", false));
-    tints.add_option(dpp::command_option(
-        dpp::co_string, "hsl",
-        "HSL list separated by ';' (example: 0,100%,50%; hsl(210,100%,50%))",
-        false));
-    tints.add_option(dpp::command_option(
-        dpp::co_string, "cmyk",
-        "CMYK list separated by ';' (example: 0,100,100,0; cmyk(100,0,0,0))",
-        false));
-
-    dpp::slashcommand mix("mix", "Mix up to 3 colors into one", bot.me.id);
-    mix.add_option(dpp::command_option(
-        dpp::co_string, "hex",
-        "Hex list separated by ';' (example: #FF0000; 00AAFF)", false));
-    mix.add_option(dpp::command_option(
-        dpp::co_string, "rgb",
-        "RGB list separated by ';' (example: 255,0,0; rgb(0,128,255))", false));
-    mix.add_option(dpp::command_option(
-        dpp::co_string, "hsl",
-        "HSL list separated by ';' (example: 0,100%,50%; hsl(210,100%,50%))",
-        false));
-    mix.add_option(dpp::command_option(
-        dpp::co_string, "cmyk",
-        "CMYK list separated by ';' (example: 0,100,100,0; cmyk(100,0,0,0))",
-        false));
-
-    dpp::slashcommand splitcomplementary(
-        "splitcomplementary",
-        "Generate a split complementary scheme (3 colors)", bot.me.id);
-    splitcomplementary.add_option(dpp::command_option(
-        dpp::co_string, "hex", "Hex like 24B1E0 or #24B1E0", false));
-    splitcomplementary.add_option(dpp::command_option(
-        dpp::co_string, "rgb", "RGB like 0,71,171 or rgb(0,71,171)", false));
-    splitcomplementary.add_option(dpp::command_option(
-        dpp::co_string, "hsl", "HSL like 215,100%,34% or hsl(...)", false));
-    splitcomplementary.add_option(dpp::command_option(
-        dpp::co_string, "cmyk", "CMYK like 100,58,0,33 or cmyk(...)", false));
-
-    dpp::slashcommand websafe("websafe",
-                              "Compare a color with its nearest web safe color",
-                              bot.me.id);
-    websafe.add_option(dpp::command_option(
-        dpp::co_string, "hex", "Hex like 24B1E0 or #24B1E0", false));
-    websafe.add_option(dpp::command_option(
-        dpp::co_string, "rgb", "RGB like 0,71,171 or rgb(0,71,171)", false));
-    websafe.add_option(dpp::command_option(
-        dpp::co_string, "hsl", "HSL like 215,100%,34% or hsl(...)", false));
-    websafe.add_option(dpp::command_option(
-        dpp::co_string, "cmyk", "CMYK like 100,58,0,33 or cmyk(...)", false));
-
-    dpp::slashcommand contrast(
-        "contrast", "WCAG contrast test on black or white background",
-        bot.me.id);
-    dpp::command_option contrast_background(
-        dpp::co_string, "background", "Background color to test against", true);
-    contrast_background.add_choice(
-        dpp::command_option_choice("black", "black"));
-    contrast_background.add_choice(
-        dpp::command_option_choice("white", "white"));
-    contrast.add_option(contrast_background);
-    contrast.add_option(dpp::command_option(
-        dpp::co_string, "hex", "Hex like 24B1E0 or #24B1E0", false));
-    contrast.add_option(dpp::command_option(
-        dpp::co_string, "rgb", "RGB like 0,71,171 or rgb(0,71,171)", false));
-    contrast.add_option(dpp::command_option(
-        dpp::co_string, "hsl", "HSL like 215,100%,34% or hsl(...)", false));
-    contrast.add_option(dpp::command_option(
-        dpp::co_string, "cmyk", "CMYK like 100,58,0,33 or cmyk(...)", false));
-
-    const std::vector<dpp::slashcommand> commands = {
-        color, complementary,      scheme,  shades,  tints,
-        mix,   splitcomplementary, websafe, contrast};
-
-    dpp::slashcommand get_version("get_version", "Get palette's version",
-                                  bot.me.id);
-
-    dpp::slashcommand get_server_count("get_server_count",
-                                       "Get palette's server count", bot.me.id);
-
-    const std::vector<dpp::slashcommand> commands_private = {get_version,
-                                                             get_server_count};
-
+    std::vector<dpp::slashcommand> commands;
+    std::vector<dpp::slashcommand> commands_private;
+    for (const command_spec &spec : command_table()) {
+        (spec.policy.isPrivate ? commands_private : commands)
+            .push_back(build_slashcommand(spec, bot.me.id));
+    }
     register_by_environment(bot, commands, commands_private);
 }
 
 void wire_slashcommands(dpp::cluster &bot, services::thread_pool &pool) {
     bot.on_slashcommand([&bot, &pool](const dpp::slashcommand_t &event) {
-        const auto &name = event.command.get_command_name();
-
-        if (name == "color") {
-            dispatch_async(pool, bot, event, color_command_options,
-                           handle_color);
-            return;
-        }
-        if (name == "scheme") {
-            dispatch_async(pool, bot, event, scheme_command_options,
-                           handle_scheme);
-            return;
-        }
-        if (name == "complementary") {
-            dispatch_async(pool, bot, event, complementary_command_options,
-                           handle_complementary);
-            return;
-        }
-        if (name == "shades") {
-            dispatch_async(pool, bot, event, shades_command_options,
-                           handle_shades);
-            return;
-        }
-        if (name == "tints") {
-            dispatch_async(pool, bot, event, tints_command_options,
-                           handle_tints);
-            return;
-        }
-        if (name == "mix") {
-            dispatch_async(pool, bot, event, mix_command_options, handle_mix);
-            return;
-        }
-        if (name == "splitcomplementary") {
-            dispatch_async(pool, bot, event, splitcomplementary_command_options,
-                           handle_splitcomplementary);
-            return;
-        }
-        if (name == "websafe") {
-            dispatch_async(pool, bot, event, websafe_command_options,
-                           handle_websafe);
-            return;
-        }
-        if (name == "contrast") {
-            dispatch_async(pool, bot, event, contrast_command_options,
-                           handle_contrast);
-            return;
-        }
-        if (name == "get_version") {
-            dispatch_async(pool, bot, event, get_version_command_options,
-                           handle_get_version);
-            return;
-        }
-        if (name == "get_server_count") {
-            dispatch_async(pool, bot, event, get_server_count_command_options,
-                           handle_get_server_count);
+        if (const command_spec *spec =
+                find_command(event.command.get_command_name())) {
+            dispatch_async(pool, bot, event, *spec,
+                           static_cast<size_t>(spec - command_table().data()));
             return;
         }
         // default fallback
-        constexpr command_option_t unknown_command_options{
-            .isPrivate = false,
-            .isWhitelist = false,
-            .requiredVote = false,
-            .ratelimit = 0,
-        };
-        dispatch_async(
-            pool, bot, event, unknown_command_options,
-            [](dpp::cluster &, const dpp::slashcommand_t &unknown_event) {
+        static constexpr command_spec unknown_command{
+            .name = "unknown",
+            .policy = {.isPrivate = false,
+                       .isWhitelist = false,
+                       .requiredVote = false,
+                       .ratelimit = 0},
+            .handler = [](dpp::cluster &,
+                          const services::interaction_context &unknown_event) {
                 unknown_event.reply("Unknown command.");
-            });
+            },
+        };
+        dispatch_async(pool, bot, event, unknown_command,
+                       services::kMaxTrackedCommands);
     });
 }
 
@@ -0,0 +1,457 @@
+#include "palette/commands/schema.hpp"
+#include "palette/commands/accessible.hpp"
+#include "palette/commands/color.hpp"
+#include "palette/commands/complementary.hpp"
+#include "palette/commands/contrast.hpp"
+#include "palette/commands/contrast_matrix.hpp"
+#include "palette/commands/distinct.hpp"
+#include "palette/commands/extract.hpp"
+#include "palette/commands/get_queue_stats.hpp"
+#include "palette/commands/get_server_count.hpp"
+#include "palette/commands/get_version.hpp"
+#include "palette/commands/gradient.hpp"
+#include "palette/commands/mix.hpp"
+#include "palette/commands/quantize.hpp"
+#include "palette/commands/scheme.hpp"
+#include "palette/commands/shades.hpp"
+#include "palette/commands/splitcomplementary.hpp"
+#include "palette/commands/tints.hpp"
+#include "palette/commands/websafe.hpp"
+#include "palette/services/handler_cost.hpp"
+#include "palette/services/perfect_hash.hpp"
+#include <array>
+#include <cstdint>
+
+namespace palette::commands {
+namespace {
+// One color.
+constexpr option_spec kHex{"hex", "Hex like 24B1E0 or #24B1E0"};
+constexpr option_spec kRgb{"rgb", "RGB like 0,71,171 or rgb(0,71,171)"};
+constexpr option_spec kHsl{"hsl", "HSL like 215,100%,34% or hsl(...)"};
+constexpr option_spec kCmyk{"cmyk", "CMYK like 100,58,0,33 or cmyk(...)"};
+
+// Several colors.
+constexpr option_spec kHexList{
+    "hex", "Hex list separated by ';' (example: #FF0000; 00AAFF)"};
+constexpr option_spec kRgbList{
+    "rgb", "RGB list separated by ';' (example: 255,0,0; rgb(0,128,255))"};
+constexpr option_spec kHslList{
+    "hsl",
+    "HSL list separated by ';' (example: 0,100%,50%; hsl(210,100%,50%))"};
+constexpr option_spec kCmykList{
+    "cmyk",
+    "CMYK list separated by ';' (example: 0,100,100,0; cmyk(100,0,0,0))"};
+
+constexpr option_choice kCvdChoices[] = {
+    {"protanopia", "protanopia"},
+    {"deuteranopia", "deuteranopia"},
+    {"tritanopia", "tritanopia"},
+};
+constexpr option_spec kCvd{
+    "cvd", "Also show the palette as seen with a color vision deficiency",
+    option_kind::string, false, kCvdChoices};
+constexpr option_spec kSeverity{
+    "severity", "Deficiency severity in percent (1-100, default 100)",
+    option_kind::integer};
+
+constexpr option_spec kSingleColorOptions[] = {kHex, kRgb, kHsl, kCmyk};
+
+constexpr option_choice kSchemeModes[] = {
+    {"monochrome", "monochrome"},
+    {"monochrome-dark", "monochrome-dark"},
+    {"monochrome-light", "monochrome-light"},
+    {"analogic", "analogic"},
+    {"complement", "complement"},
+    {"analogic-complement", "analogic-complement"},
+    {"triad", "triad"},
+    {"quad", "quad"},
+};
+constexpr option_spec kSchemeOptions[] = {
+    {"hex", "Hex like 24B1E0 or #24B1E0", option_kind::string, true},
+    {"mode", "Scheme mode (default: monochrome)", option_kind::string, false,
+     kSchemeModes},
+    {"count", "Number of colors to return (1-20)", option_kind::integer},
+    kCvd,
+    kSeverity,
+};
+
+constexpr option_spec kShadesOptions[] = {
+    {"amount", "Number of shades per color (2-8)", option_kind::integer,
+     true},
+    kHexList, kRgbList, kHslList, kCmykList, kCvd, kSeverity,
+};
+
+constexpr option_spec kTintsOptions[] = {
+    {"amount", "Number of tints per color (2-8)", option_kind::integer, true},
+    kHexList, kRgbList, kHslList, kCmykList, kCvd, kSeverity,
+};
+
+constexpr option_choice kMixModes[] = {
+    {"sRGB average", "srgb"},
+    {"linear light", "linear"},
+    {"OKLab", "oklab"},
+    {"pigment", "pigment"},
+};
+constexpr option_spec kMixOptions[] = {
+    kHexList,
+    kRgbList,
+    kHslList,
+    kCmykList,
+    {"mode", "How colors combine (default: srgb)", option_kind::string, false,
+     kMixModes},
+    {"weights", "Parts per color separated by ';' (example: 2;1)"},
+    kCvd,
+    kSeverity,
+};
+
+constexpr option_choice kBackgrounds[] = {
+    {"black", "black"},
+    {"white", "white"},
+};
+constexpr option_spec kContrastOptions[] = {
+    {"background", "Background color to test against", option_kind::string,
+     true, kBackgrounds},
+    kHex, kRgb, kHsl, kCmyk,
+};
+
+constexpr option_choice kQuantizePalettes[] = {
+    {"websafe", "websafe"},   {"material", "material"},
+    {"tailwind", "tailwind"}, {"server roles", "roles"},
+    {"custom", "custom"},
+};
+constexpr option_spec kQuantizeOptions[] = {
+    {"palette", "Target palette (default: websafe)", option_kind::string,
+     false, kQuantizePalettes},
+    {"colors", "Custom palette hex list separated by ';' (up to 256)"},
+    kHex,
+    kRgb,
+    kHsl,
+    kCmyk,
+};
+
+constexpr option_spec kExtractOptions[] = {
+    {"image", "PNG or JPEG image (up to 8 MB)", option_kind::attachment,
+     true},
+    {"count", "Number of colors to extract (2-10)", option_kind::integer},
+};
+
+constexpr option_choice kGradientSpaces[] = {
+    {"sRGB", "srgb"},
+    {"linear RGB", "linear"},
+    {"OKLab", "oklab"},
+    {"OKLCH", "oklch"},
+};
+constexpr option_choice kGradientHues[] = {
+    {"shorter", "shorter"},
+    {"longer", "longer"},
+    {"increasing", "increasing"},
+    {"decreasing", "decreasing"},
+};
+constexpr option_spec kGradientOptions[] = {
+    {"hex", "Hex stops separated by ';' (example: #FF0000; 00AAFF)"},
+    {"rgb", "RGB stops separated by ';' (example: 255,0,0; rgb(0,128,255))"},
+    {"hsl",
+     "HSL stops separated by ';' (example: 0,100%,50%; hsl(210,100%,50%))"},
+    {"cmyk",
+     "CMYK stops separated by ';' (example: 0,100,100,0; cmyk(100,0,0,0))"},
+    {"steps", "Number of swatches (2-256, default 8)", option_kind::integer},
+    {"space", "Interpolation space (default: oklab)", option_kind::string,
+     false, kGradientSpaces},
+    {"hue", "OKLCH hue path (default: shorter)", option_kind::string, false,
+     kGradientHues},
+};
+
+constexpr option_choice kContrastMethods[] = {
+    {"WCAG 2", "wcag"},
+    {"APCA", "apca"},
+};
+constexpr option_spec kContrastMatrixOptions[] = {
+    {"hex", "Hex list separated by ';' (up to 32 colors)"},
+    kRgbList,
+    kHslList,
+    kCmykList,
+    {"backgrounds",
+     "Hex backgrounds separated by ';' (default: the palette itself)"},
+    {"method", "Contrast model (default: wcag)", option_kind::string, false,
+     kContrastMethods},
+};
+
+constexpr option_choice kAccessibleLevels[] = {
+    {"AA normal text", "aa"},
+    {"AA large text", "aa-large"},
+    {"AAA normal text", "aaa"},
+    {"AAA large text", "aaa-large"},
+};
+constexpr option_spec kAccessibleOptions[] = {
+    kHex,
+    kRgb,
+    kHsl,
+    kCmyk,
+    {"background", "Hex background (default: #FFFFFF)"},
+    {"level", "WCAG level to reach (default: aa)", option_kind::string, false,
+     kAccessibleLevels},
+    {"steps", "Tonal scale steps (3-12, default 10)", option_kind::integer},
+};
+
+constexpr option_spec kDistinctOptions[] = {
+    {"count", "Number of colors (2-256, default 8)", option_kind::integer},
+    {"min_lightness", "Minimum OKLCH lightness (0-100)",
+     option_kind::integer},
+    {"max_lightness", "Maximum OKLCH lightness (0-100)",
+     option_kind::integer},
+    {"min_chroma", "Minimum OKLCH chroma in % (0-100)", option_kind::integer},
+    {"max_chroma", "Maximum OKLCH chroma in % (0-100)", option_kind::integer},
+};
+
+constexpr std::array kCommands = {
+    command_spec{
+        .name = "color",
+        .description = "Identify a color via hex/rgb/hsl/cmyk",
+        .options = kSingleColorOptions,
+        .policy = {.isPrivate = false,
+                   .isWhitelist = false,
+                   .requiredVote = false,
+                   .ratelimit = 5000},
+        .handler = handle_color,
+        .single_color_input = true,
+    },
+    command_spec{
+        .name = "complementary",
+        .description = "Find the complementary color",
+        .options = kSingleColorOptions,
+        .policy = {.isPrivate = false,
+                   .isWhitelist = false,
+                   .requiredVote = false,
+                   .ratelimit = 2000},
+        .handler = handle_complementary,
+        .single_color_input = true,
+    },
+    command_spec{
+        .name = "scheme",
+        .description = "Generate a color scheme from a seed",
+        .options = kSchemeOptions,
+        .policy = {.isPrivate = false,
+                   .isWhitelist = false,
+                   .requiredVote = true,
+                   .ratelimit = 5000,
+                   .lane = task_class::render},
+        .handler = handle_scheme,
+    },
+    command_spec{
+        .name = "shades",
+        .description = "Generate numbered shades image (toward black)",
+        .options = kShadesOptions,
+        .policy = {.isPrivate = false,
+                   .isWhitelist = false,
+                   .requiredVote = true,
+                   .ratelimit = 5000,
+                   .lane = task_class::render},
+        .handler = handle_shades,
+    },
+    command_spec{
+        .name = "tints",
+        .description = "Generate numbered tints image (toward white)",
+        .options = kTintsOptions,
+        .policy = {.isPrivate = false,
+                   .isWhitelist = false,
+                   .requiredVote = true,
+                   .ratelimit = 5000,
+                   .lane = task_class::render},
+        .handler = handle_tints,
+    },
+    command_spec{
+        .name = "mix",
+        .description = "Mix up to 48 colors into one",
+        .options = kMixOptions,
+        .policy = {.isPrivate = false,
+                   .isWhitelist = false,
+                   .requiredVote = false,
+                   .ratelimit = 2000,
+                   .lane = task_class::render},
+        .handler = handle_mix,
+    },
+    command_spec{
+        .name = "splitcomplementary",
+        .description = "Generate a split complementary scheme (3 colors)",
+        .options = kSingleColorOptions,
+        .policy = {.isPrivate = false,
+                   .isWhitelist = false,
+                   .requiredVote = false,
+                   .ratelimit = 2000},
+        .handler = handle_splitcomplementary,
+        .single_color_input = true,
+    },
+    command_spec{
+        .name = "websafe",
+        .description = "Compare a color with its nearest web safe color",
+        .options = kSingleColorOptions,
+        .policy = {.isPrivate = false,
+                   .isWhitelist = false,
+                   .requiredVote = false,
+                   .ratelimit = 500},
+        .handler = handle_websafe,
+        .single_color_input = true,
+    },
+    command_spec{
+        .name = "contrast",
+        .description = "WCAG contrast test on black or white background",
+        .options = kContrastOptions,
+        .policy = {.isPrivate = false,
+                   .isWhitelist = false,
+                   .requiredVote = false,
+                   .ratelimit = 2000},
+        .handler = handle_contrast,
+        .single_color_input = true,
+    },
+    command_spec{
+        .name = "quantize",
+        .description = "Find the nearest color in a target palette",
+        .options = kQuantizeOptions,
+        .policy = {.isPrivate = false,
+                   .isWhitelist = false,
+                   .requiredVote = false,
+                   .ratelimit = 1000},
+        .handler = handle_quantize,
+        .single_color_input = true,
+    },
+    command_spec{
+        .name = "extract",
+        .description = "Extract the dominant colors of an image",
+        .options = kExtractOptions,
+        .policy = {.isPrivate = false,
+                   .isWhitelist = false,
+                   .requiredVote = false,
+                   .ratelimit = 5000,
+                   .lane = task_class::render},
+        .handler = handle_extract,
+    },
+    command_spec{
+        .name = "gradient",
+        .description = "Blend 2 or more colors into a gradient",
+        .options = kGradientOptions,
+        .policy = {.isPrivate = false,
+                   .isWhitelist = false,
+                   .requiredVote = false,
+                   .ratelimit = 1000,
+                   .lane = task_class::render},
+        .handler = handle_gradient,
+    },
+    command_spec{
+        .name = "contrastmatrix",
+        .description = "Contrast of every pair of colors in a palette",
+        .options = kContrastMatrixOptions,
+        .policy = {.isPrivate = false,
+                   .isWhitelist = false,
+                   .requiredVote = false,
+                   .ratelimit = 2000,
+                   .lane = task_class::render},
+        .handler = handle_contrast_matrix,
+    },
+    command_spec{
+        .name = "accessible",
+        .description = "Fix a color's contrast and build an accessible scale",
+        .options = kAccessibleOptions,
+        .policy = {.isPrivate = false,
+                   .isWhitelist = false,
+                   .requiredVote = false,
+                   .ratelimit = 2000,
+                   .lane = task_class::render},
+        .handler = handle_accessible,
+        .single_color_input = true,
+    },
+    command_spec{
+        .name = "distinct",
+        .description = "Generate colors that are as distinct as possible",
+        .options = kDistinctOptions,
+        .policy = {.isPrivate = false,
+                   .isWhitelist = false,
+                   .requiredVote = false,
+                   .ratelimit = 5000,
+                   .lane = task_class::render},
+        .handler = handle_distinct,
+    },
+    command_spec{
+        .name = "get_version",
+        .description = "Get palette's version",
+        .policy = {.isPrivate = true,
+                   .isWhitelist = false,
+                   .requiredVote = false,
+                   .ratelimit = 0},
+        .handler = handle_get_version,
+    },
+    command_spec{
+        .name = "get_server_count",
+        .description = "Get palette's server count",
+        .policy = {.isPrivate = true,
+                   .isWhitelist = false,
+                   .requiredVote = false,
+                   .ratelimit = 0},
+        .handler = handle_get_server_count,
+    },
+    command_spec{
+        .name = "get_queue_stats",
+        .description = "Get worker pool queue-wait statistics",
+        .policy = {.isPrivate = true,
+                   .isWhitelist = false,
+                   .requiredVote = false,
+                   .ratelimit = 0},
+        .handler = handle_get_queue_stats,
+    },
+};
+
+constexpr bool options_fit() {
+    for (const command_spec &spec : kCommands) {
+        if (spec.options.size() > kMaxCommandOptions) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(options_fit(), "raise kMaxCommandOptions");
+static_assert(kCommands.size() <= services::kMaxTrackedCommands,
+              "raise kMaxTrackedCommands");
+
+constexpr size_t kRouteSlots = 64;
+constexpr uint8_t kNoCommand = UINT8_MAX;
+static_assert(kCommands.size() < kNoCommand);
+
+constexpr size_t route_slot(std::string_view name, uint32_t seed) {
+    return services::perfect_hash_slot<kRouteSlots>(name, seed);
+}
+
+constexpr std::array<std::string_view, kCommands.size()> command_names() {
+    std::array<std::string_view, kCommands.size()> names{};
+    for (size_t i = 0; i < kCommands.size(); ++i) {
+        names[i] = kCommands[i].name;
+    }
+    return names;
+}
+
+constexpr uint32_t kRouteSeed =
+    services::find_perfect_hash_seed<kRouteSlots>(command_names());
+static_assert(kRouteSeed != UINT32_MAX, "no perfect hash for commands");
+
+constexpr std::array<uint8_t, kRouteSlots> build_routes() {
+    std::array<uint8_t, kRouteSlots> routes{};
+    routes.fill(kNoCommand);
+    for (size_t i = 0; i < kCommands.size(); ++i) {
+        routes[route_slot(kCommands[i].name, kRouteSeed)] =
+            static_cast<uint8_t>(i);
+    }
+    return routes;
+}
+
+constexpr std::array<uint8_t, kRouteSlots> kRoutes = build_routes();
+} // namespace
+
+std::span<const command_spec> command_table() { return kCommands; }
+
+const command_spec *find_command(std::string_view name) {
+    const uint8_t index = kRoutes[route_slot(name, kRouteSeed)];
+    if (index == kNoCommand || kCommands[index].name != name) {
+        return nullptr;
+    }
+    return &kCommands[index];
+}
+
+} // namespace palette::commands
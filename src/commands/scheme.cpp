@@ -1,11 +1,15 @@
 #include "palette/commands/scheme.hpp"
 #include "palette/services/color_api.hpp"
+#include "palette/services/cvd.hpp"
+#include "palette/services/detached_task.hpp"
 #include "palette/services/palette_image.hpp"
 #include <algorithm>
 #include <array>
 #include <cctype>
 #include <cstdint>
 #include <nlohmann/json.hpp>
+#include <optional>
+#include <utility>
 #include <vector>
 
 namespace palette::commands {
@@ -64,9 +68,113 @@ int parse_count(const nlohmann::json &json, int fallback) {
     }
     return fallback;
 }
+
+services::detached_task
+lookup_scheme(dpp::cluster &bot, services::interaction_handle context,
+              std::string hex, std::string mode, int count,
+              std::optional<services::cvd_simulation> simulation) {
+    const services::http_result response =
+        co_await services::fetch_scheme(bot, hex, mode, count);
+    if (!response.ok()) {
+        context->followup(dpp::message("API error: " + response.error()));
+        co_return;
+    }
+
+    try {
+        auto json = nlohmann::json::parse(response.body);
+        const auto &seed = json.at("seed");
+        const auto &colors = json.at("colors");
+
+        std::string scheme_mode = mode;
+        if (json.contains("mode") && json["mode"].is_string()) {
+            scheme_mode = json["mode"].get<std::string>();
+        }
+        int scheme_count = parse_count(json, count);
+
+        std::string seed_hex = seed.at("hex").at("clean").get<std::string>();
+        std::string seed_name = seed.at("name").at("value").get<std::string>();
+        std::string seed_rgb = seed.at("rgb").at("value").get<std::string>();
+
+        std::string url = build_scheme_url(seed_hex, scheme_mode, scheme_count);
+        if (json.contains("_links") &&
+            json["_links"].contains("self") &&
+            json["_links"]["self"].is_string()) {
+            const std::string self_path =
+                json["_links"]["self"].get<std::string>();
+            if (!self_path.empty() && self_path.front() == '/') {
+                url = "https://www.thecolorapi.com" + self_path;
+            }
+        }
+
+        std::vector<services::rgb_color> palette_colors;
+        palette_colors.reserve(colors.size());
+        std::string description =
+            "A monochromatic color scheme is based on a single color "
+            "and contains both shades and tints of that color.\n\n"
+            "**Scheme**\n"
+            "- **Seed:** #" +
+            seed_hex + " (" + seed_name +
+            ")\n"
+            "- **RGB:** " +
+            seed_rgb +
+            "\n"
+            "- **Mode:** " +
+            scheme_mode +
+            "\n"
+            "- **Count:** " +
+            std::to_string(colors.size()) +
+            "\n"
+            "- **URL:** [Open](" +
+            url + "&format=html" + ")\n\n";
+
+        size_t idx = 1;
+        for (const auto &color : colors) {
+            const std::string hex_value =
+                color.at("hex").at("value").get<std::string>();
+            const std::string name_value =
+                color.at("name").at("value").get<std::string>();
+            const std::string rgb_value =
+                color.at("rgb").at("value").get<std::string>();
+            const std::string hsl_value =
+                color.at("hsl").at("value").get<std::string>();
+            const int r = color.at("rgb").at("r").get<int>();
+            const int g = color.at("rgb").at("g").get<int>();
+            const int b = color.at("rgb").at("b").get<int>();
+
+            palette_colors.push_back({static_cast<uint8_t>(r),
+                                      static_cast<uint8_t>(g),
+                                      static_cast<uint8_t>(b)});
+
+            description += std::to_string(idx) + ". " + hex_value +
+                           " " + name_value + " | " + rgb_value +
+                           " | " + hsl_value + "\n";
+            ++idx;
+        }
+
+        if (simulation) {
+            description += "\n- **Simulated vision:** " +
+                           services::cvd_label(*simulation);
+        }
+
+        dpp::message msg(description);
+        const std::string image_data =
+            simulation ? services::generate_cvd_comparison_image(
+                             palette_colors, *simulation)
+                       : services::generate_palette_image(palette_colors, true);
+        if (!image_data.empty()) {
+            msg.add_file("scheme-palette.png", image_data);
+        }
+
+        context->followup(msg);
+    } catch (const std::exception &e) {
+        context->followup(dpp::message("Failed to parse scheme: " +
+                                       std::string(e.what())));
+    }
+}
 } // namespace
 
-void handle_scheme(dpp::cluster &bot, const dpp::slashcommand_t &event) {
+void handle_scheme(dpp::cluster &bot,
+                   const services::interaction_context &event) {
     auto hex_param = event.get_parameter("hex");
     auto mode_param = event.get_parameter("mode");
     auto count_param = event.get_parameter("count");
@@ -97,107 +205,17 @@ void handle_scheme(dpp::cluster &bot, const dpp::slashcommand_t &event) {
     }
     count = std::clamp(count, 1, 20);
 
+    const services::cvd_input_result cvd = services::parse_cvd_input(event);
+    if (!cvd.ok) {
+        event.reply(cvd.error);
+        return;
+    }
+    const std::optional<services::cvd_simulation> simulation = cvd.simulation;
+
     event.thinking();
-    const std::string token = event.command.token;
-
-    services::fetch_scheme(
-        bot, hex, mode, count,
-        [&bot, token, mode, count](bool ok, std::string body) {
-            if (!ok) {
-                bot.interaction_followup_create(
-                    token, dpp::message("API error: " + body));
-                return;
-            }
 
-            try {
-                auto json = nlohmann::json::parse(body);
-                const auto &seed = json.at("seed");
-                const auto &colors = json.at("colors");
-
-                std::string scheme_mode = mode;
-                if (json.contains("mode") && json["mode"].is_string()) {
-                    scheme_mode = json["mode"].get<std::string>();
-                }
-                int scheme_count = parse_count(json, count);
-
-                std::string seed_hex =
-                    seed.at("hex").at("clean").get<std::string>();
-                std::string seed_name =
-                    seed.at("name").at("value").get<std::string>();
-                std::string seed_rgb =
-                    seed.at("rgb").at("value").get<std::string>();
-
-                std::string url =
-                    build_scheme_url(seed_hex, scheme_mode, scheme_count);
-                if (json.contains("_links") &&
-                    json["_links"].contains("self") &&
-                    json["_links"]["self"].is_string()) {
-                    const std::string self_path =
-                        json["_links"]["self"].get<std::string>();
-                    if (!self_path.empty() && self_path.front() == '/') {
-                        url = "https://www.thecolorapi.com" + self_path;
-                    }
-                }
-
-                std::vector<services::rgb_color> palette_colors;
-                palette_colors.reserve(colors.size());
-                std::string description =
-                    "A monochromatic color scheme is based on a single color "
-                    "and contains both shades and tints of that color.\n\n"
-                    "**Scheme**\n"
-                    "- **Seed:** #" +
-                    seed_hex + " (" + seed_name +
-                    ")\n"
-                    "- **RGB:** " +
-                    seed_rgb +
-                    "\n"
-                    "- **Mode:** " +
-                    scheme_mode +
-                    "\n"
-                    "- **Count:** " +
-                    std::to_string(colors.size()) +
-                    "\n"
-                    "- **URL:** [Open](" +
-                    url + "&format=html" + ")\n\n";
-
-                size_t idx = 1;
-                for (const auto &color : colors) {
-                    const std::string hex_value =
-                        color.at("hex").at("value").get<std::string>();
-                    const std::string name_value =
-                        color.at("name").at("value").get<std::string>();
-                    const std::string rgb_value =
-                        color.at("rgb").at("value").get<std::string>();
-                    const std::string hsl_value =
-                        color.at("hsl").at("value").get<std::string>();
-                    const int r = color.at("rgb").at("r").get<int>();
-                    const int g = color.at("rgb").at("g").get<int>();
-                    const int b = color.at("rgb").at("b").get<int>();
-
-                    palette_colors.push_back({static_cast<uint8_t>(r),
-                                              static_cast<uint8_t>(g),
-                                              static_cast<uint8_t>(b)});
-
-                    description += std::to_string(idx) + ". " + hex_value +
-                                   " " + name_value + " | " + rgb_value +
-                                   " | " + hsl_value + "\n";
-                    ++idx;
-                }
-
-                dpp::message msg(description);
-                const std::string image_data =
-                    services::generate_palette_image(palette_colors, true);
-                if (!image_data.empty()) {
-                    msg.add_file("scheme-palette.png", image_data);
-                }
-
-                bot.interaction_followup_create(token, msg);
-            } catch (const std::exception &e) {
-                bot.interaction_followup_create(
-                    token, dpp::message("Failed to parse scheme: " +
-                                        std::string(e.what())));
-            }
-        });
+    lookup_scheme(bot, event.shared_from_this(), std::move(hex),
+                  std::move(mode), count, simulation);
 }
 
 } // namespace palette::commands
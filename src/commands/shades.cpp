@@ -1,10 +1,12 @@
 #include "palette/commands/shades.hpp"
 #include "palette/services/color_utils.hpp"
+#include "palette/services/cvd.hpp"
 #include "palette/services/palette_controls.hpp"
 
 namespace palette::commands {
 
-void handle_shades(dpp::cluster &bot, const dpp::slashcommand_t &event) {
+void handle_shades(dpp::cluster &bot,
+                   const services::interaction_context &event) {
     (void)bot;
 
     auto amount_param = event.get_parameter("amount");
@@ -27,24 +29,32 @@ void handle_shades(dpp::cluster &bot, const dpp::slashcommand_t &event) {
         return;
     }
 
-    const std::string token = services::create_palette_control_token(
-        services::palette_control_mode::shades, input.colors, amount);
-    if (token.empty()) {
+    const services::cvd_input_result cvd = services::parse_cvd_input(event);
+    if (!cvd.ok) {
+        event.reply(cvd.error);
+        return;
+    }
+
+    const std::optional<services::palette_control_state> state =
+        services::make_palette_control_state(
+            services::palette_control_mode::shades, input.colors, amount,
+            cvd.simulation);
+    if (!state) {
         event.reply("Failed to initialize shades session.");
         return;
     }
 
     const services::palette_render_result rendered =
         services::render_palette_with_controls(services::palette_control_mode::shades,
-                                               input.colors, amount);
+                                               input.colors, amount,
+                                               cvd.simulation);
     if (!rendered.ok) {
         event.reply(rendered.error);
         return;
     }
 
-    dpp::message msg(event.command.channel_id, rendered.description);
-    msg.add_component(services::build_palette_controls_row(
-        services::palette_control_mode::shades, amount, token));
+    dpp::message msg(event.channel_id, rendered.description);
+    msg.add_component(services::build_palette_controls_row(*state));
     msg.add_file("color-palette.png", rendered.image_data);
     event.reply(msg);
 }
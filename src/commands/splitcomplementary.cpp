@@ -25,11 +25,10 @@ std::string hsl_label(double h, double s, double l) {
 } // namespace
 
 void handle_splitcomplementary(dpp::cluster &bot,
-                               const dpp::slashcommand_t &event) {
+                               const services::interaction_context &event) {
     (void)bot;
 
-    const services::single_color_input_result input =
-        services::parse_single_color_input(event);
+    const services::single_color_input_result &input = event.color;
     if (!input.ok) {
         event.reply(input.error);
         return;
@@ -68,7 +67,7 @@ void handle_splitcomplementary(dpp::cluster &bot,
         "3. **Right of Complement:** " +
         services::rgb_to_hex(right) + " | " + hsl_label(right_h, s, l);
 
-    dpp::message msg(event.command.channel_id, description);
+    dpp::message msg(event.channel_id, description);
     const std::string image_data =
         services::generate_palette_image({base, left, right}, true);
     if (!image_data.empty()) {
@@ -5,11 +5,11 @@
 #include <vector>
 
 namespace palette::commands {
-void handle_websafe(dpp::cluster &bot, const dpp::slashcommand_t &event) {
+void handle_websafe(dpp::cluster &bot,
+                    const services::interaction_context &event) {
     (void)bot;
 
-    const services::single_color_input_result input =
-        services::parse_single_color_input(event);
+    const services::single_color_input_result &input = event.color;
     if (!input.ok) {
         event.reply(input.error);
         return;
@@ -39,7 +39,7 @@ void handle_websafe(dpp::cluster &bot, const dpp::slashcommand_t &event) {
         "- **Already web safe:** " +
         std::string(already_websafe ? "Yes" : "No");
 
-    dpp::message msg(event.command.channel_id, description);
+    dpp::message msg(event.channel_id, description);
     const std::string image_data =
         services::generate_palette_image({original, websafe}, true);
     if (!image_data.empty()) {
@@ -1,6 +1,7 @@
 #include "palette/events/ready.hpp"
 #include "palette/commands/registry.hpp"
 #include "palette/services/env_utils.hpp"
+#include "palette/services/ratelimit.hpp"
 #include "palette/services/topgg.hpp"
 
 namespace palette::events {
@@ -15,6 +16,10 @@ void wire_ready(dpp::cluster &bot) {
         if (dpp::run_once<struct register_commands_once>()) {
             commands::register_commands(bot); // overwrite commands
         }
+
+        if (dpp::run_once<struct sweep_ratelimits_once>()) {
+            palette::services::schedule_ratelimit_sweeps(bot);
+        }
     });
 }
 } // namespace palette::events
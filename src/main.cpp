@@ -1,7 +1,9 @@
 #include "palette/bot.hpp"
+#include "palette/services/color_transform.hpp"
 #include "palette/services/env_utils.hpp"
 #include "palette/services/thread_pool.hpp"
 #include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <dpp/dpp.h>
 #include <iostream>
@@ -25,12 +27,32 @@ int main() {
         2, static_cast<size_t>(hardware_threads == 0 ? 4 : hardware_threads));
     const size_t worker_count = palette::services::resolve_worker_thread_count(
         "BOT_WORKER_THREADS", default_workers);
+    // The pool starts at BOT_WORKER_THREADS and scales between these bounds.
+    const size_t min_workers = palette::services::resolve_worker_thread_count(
+        "BOT_WORKER_THREADS_MIN", std::max<size_t>(1, worker_count / 2));
+    const size_t max_workers = palette::services::resolve_worker_thread_count(
+        "BOT_WORKER_THREADS_MAX", std::min<size_t>(64, worker_count * 2));
+    const size_t queue_capacity = static_cast<size_t>(std::max<uint64_t>(
+        1, palette::services::get_env_u64("BOT_QUEUE_CAPACITY")
+               .value_or(palette::services::kDefaultLaneCapacity)));
     dpp::cluster bot(token);
-    palette::services::thread_pool command_pool(worker_count);
+    palette::services::thread_pool command_pool(
+        palette::services::thread_pool_options{.threads = worker_count,
+                                               .min_threads = min_workers,
+                                               .max_threads = max_workers,
+                                               .lane_capacity =
+                                                   queue_capacity});
 
-    std::cout << "Command worker threads: " << command_pool.size() << "\n";
+    const palette::services::scaling_stats scaling = command_pool.scaling();
+    std::cout << "Command worker threads: " << command_pool.size() << " ("
+              << scaling.min_workers << "-" << scaling.max_workers << ")\n";
+    std::cout << "Queue capacity per lane: " << queue_capacity << "\n";
     std::cout << "Environment: " << (production ? "production" : "development")
               << "\n";
+    // Loaded here rather than on the first CMYK lookup from a worker.
+    if (const auto cmyk = palette::services::cmyk_icc_profile()) {
+        std::cout << "CMYK profile: " << cmyk->name << "\n";
+    }
 
     palette::wire_listeners(bot, command_pool);
 
@@ -12,9 +12,8 @@ std::string clean_hex_code(std::string hex) {
 }
 } // namespace
 
-void fetch_color(dpp::cluster &bot, const std::string &query_key,
-                 const std::string &query_value,
-                 std::function<void(bool, std::string)> cb) {
+pending_request fetch_color(dpp::cluster &bot, const std::string &query_key,
+                            const std::string &query_value) {
     std::string value = query_value;
     if (query_key == "hex") {
         value = clean_hex_code(value);
@@ -22,20 +21,11 @@ void fetch_color(dpp::cluster &bot, const std::string &query_key,
 
     std::string url = "https://www.thecolorapi.com/id?" + query_key + "=" +
                       dpp::utility::url_encode(value) + "&format=json";
-
-    bot.request(url, dpp::http_method::m_get,
-                [cb](const dpp::http_request_completion_t &res) {
-                    if (res.status != 200) {
-                        cb(false, "HTTP " + std::to_string(res.status));
-                        return;
-                    }
-                    cb(true, res.body);
-                });
+    return start_request(bot, url);
 }
 
-void fetch_scheme(dpp::cluster &bot, const std::string &hex,
-                  const std::string &mode, int count,
-                  std::function<void(bool, std::string)> cb) {
+pending_request fetch_scheme(dpp::cluster &bot, const std::string &hex,
+                             const std::string &mode, int count) {
     std::string clean = clean_hex_code(hex);
     std::string resolved_mode = mode.empty() ? "monochrome" : mode;
     int resolved_count = std::clamp(count, 1, 20);
@@ -43,15 +33,7 @@ void fetch_scheme(dpp::cluster &bot, const std::string &hex,
     std::string url = "https://www.thecolorapi.com/scheme?hex=" + clean +
                       "&mode=" + dpp::utility::url_encode(resolved_mode) +
                       "&count=" + std::to_string(resolved_count);
-
-    bot.request(url, dpp::http_method::m_get,
-                [cb](const dpp::http_request_completion_t &res) {
-                    if (res.status != 200) {
-                        cb(false, "HTTP " + std::to_string(res.status));
-                        return;
-                    }
-                    cb(true, res.body);
-                });
+    return start_request(bot, url);
 }
 
 std::string name_distance_label(double d) {
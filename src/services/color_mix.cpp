@@ -0,0 +1,320 @@
+#include "palette/services/color_mix.hpp"
+#include "palette/services/color_space.hpp"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+
+namespace palette::services {
+namespace {
+// 380-730 nm in 10 nm steps.
+constexpr size_t kWavelengths = 36;
+constexpr double kFirstWavelength = 380.0;
+constexpr double kWavelengthStep = 10.0;
+// Real pigments never absorb everything; reflectances are lifted onto
+// [kReflectanceFloor, 1] for the mix and mapped back afterwards, which keeps
+// pure black finite without changing single-color results.
+constexpr double kReflectanceFloor = 0.03;
+
+using spectrum = std::array<double, kWavelengths>;
+
+// Piecewise Gaussian fit of the CIE 1931 observer (Wyman, Sloan and
+// Shirley 2013).
+double lobe(double lambda, double mean, double below, double above) {
+    const double t = (lambda - mean) / (lambda < mean ? below : above);
+    return std::exp(-0.5 * t * t);
+}
+
+void observer(double lambda, double &x, double &y, double &z) {
+    x = 1.056 * lobe(lambda, 599.8, 37.9, 31.0) +
+        0.362 * lobe(lambda, 442.0, 16.0, 26.7) -
+        0.065 * lobe(lambda, 501.1, 20.4, 26.2);
+    y = 0.821 * lobe(lambda, 568.8, 46.9, 40.5) +
+        0.286 * lobe(lambda, 530.9, 16.3, 31.1);
+    z = 1.217 * lobe(lambda, 437.0, 11.8, 36.0) +
+        0.681 * lobe(lambda, 459.0, 26.0, 13.8);
+}
+
+// D65 approximated by a 6504 K black body; only the relative weighting of
+// wavelengths matters because white is renormalized below.
+double illuminant(double lambda) {
+    const double meters = lambda * 1e-9;
+    return 1.0 / (std::pow(meters, 5.0) *
+                  (std::exp(1.4388e-2 / (meters * 6504.0)) - 1.0));
+}
+
+double smoothstep_edge(double lambda, double center) {
+    return 1.0 / (1.0 + std::exp(-(lambda - center) / 12.0));
+}
+
+// Everything the pigment mix needs, computed once: reflectance basis
+// curves for the linear red, green and blue primaries (smooth, in [0, 1]
+// and summing to one, so white is a perfect reflector), the projection of
+// a spectrum to linear RGB, and the 3x3 correction that makes
+// basis-then-projection the identity.
+struct spectral_tables {
+    std::array<spectrum, 3> basis{};
+    std::array<spectrum, 3> projection{};
+
+    spectral_tables() {
+        std::array<spectrum, 3> xyz{};
+        for (size_t i = 0; i < kWavelengths; ++i) {
+            const double lambda =
+                kFirstWavelength + kWavelengthStep * static_cast<double>(i);
+            const double blue = 1.0 - smoothstep_edge(lambda, 500.0);
+            const double red = smoothstep_edge(lambda, 600.0);
+            basis[0][i] = red;
+            basis[1][i] = std::max(0.0, 1.0 - red - blue);
+            basis[2][i] = blue;
+
+            double x = 0.0;
+            double y = 0.0;
+            double z = 0.0;
+            observer(lambda, x, y, z);
+            const double power = illuminant(lambda);
+            xyz[0][i] = x * power;
+            xyz[1][i] = y * power;
+            xyz[2][i] = z * power;
+        }
+
+        // XYZ to linear sRGB (D65).
+        static constexpr double kToRgb[3][3] = {
+            {3.2404542, -1.5371385, -0.4985314},
+            {-0.9692660, 1.8760108, 0.0415560},
+            {0.0556434, -0.2040259, 1.0572252}};
+        std::array<spectrum, 3> raw{};
+        for (size_t row = 0; row < 3; ++row) {
+            for (size_t i = 0; i < kWavelengths; ++i) {
+                raw[row][i] = kToRgb[row][0] * xyz[0][i] +
+                              kToRgb[row][1] * xyz[1][i] +
+                              kToRgb[row][2] * xyz[2][i];
+            }
+        }
+
+        // correction = (raw * basis)^-1, folded into the projection.
+        double m[3][3] = {};
+        for (size_t row = 0; row < 3; ++row) {
+            for (size_t col = 0; col < 3; ++col) {
+                for (size_t i = 0; i < kWavelengths; ++i) {
+                    m[row][col] += raw[row][i] * basis[col][i];
+                }
+            }
+        }
+        const double det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+                           m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+                           m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+        const double inverse[3][3] = {
+            {(m[1][1] * m[2][2] - m[1][2] * m[2][1]) / det,
+             (m[0][2] * m[2][1] - m[0][1] * m[2][2]) / det,
+             (m[0][1] * m[1][2] - m[0][2] * m[1][1]) / det},
+            {(m[1][2] * m[2][0] - m[1][0] * m[2][2]) / det,
+             (m[0][0] * m[2][2] - m[0][2] * m[2][0]) / det,
+             (m[0][2] * m[1][0] - m[0][0] * m[1][2]) / det},
+            {(m[1][0] * m[2][1] - m[1][1] * m[2][0]) / det,
+             (m[0][1] * m[2][0] - m[0][0] * m[2][1]) / det,
+             (m[0][0] * m[1][1] - m[0][1] * m[1][0]) / det}};
+        for (size_t row = 0; row < 3; ++row) {
+            for (size_t i = 0; i < kWavelengths; ++i) {
+                projection[row][i] = inverse[row][0] * raw[0][i] +
+                                     inverse[row][1] * raw[1][i] +
+                                     inverse[row][2] * raw[2][i];
+            }
+        }
+    }
+};
+
+const spectral_tables &tables() {
+    static const spectral_tables instance;
+    return instance;
+}
+
+// Kubelka-Munk K/S of a reflectance and its inverse.
+double absorption_ratio(double reflectance) {
+    const double r =
+        kReflectanceFloor + (1.0 - kReflectanceFloor) * reflectance;
+    return (1.0 - r) * (1.0 - r) / (2.0 * r);
+}
+
+double reflectance_from_ratio(double ks) {
+    const double r = 1.0 + ks - std::sqrt(ks * ks + 2.0 * ks);
+    return (r - kReflectanceFloor) / (1.0 - kReflectanceFloor);
+}
+
+rgb_color mix_pigment(const std::vector<rgb_color> &colors,
+                      const std::vector<double> &weights) {
+    const spectral_tables &t = tables();
+    const auto &to_linear = srgb_to_linear_table();
+    spectrum ks{};
+    double total = 0.0;
+    for (size_t c = 0; c < colors.size(); ++c) {
+        const double r = to_linear[colors[c].r];
+        const double g = to_linear[colors[c].g];
+        const double b = to_linear[colors[c].b];
+        // Light pigments scatter more and tint harder than their share
+        // suggests; weighting by the square root of (lifted) luminance
+        // keeps dark colors from swamping every mix.
+        const double luminance =
+            kReflectanceFloor + (1.0 - kReflectanceFloor) *
+                                    (0.2126 * r + 0.7152 * g + 0.0722 * b);
+        const double w = weights[c] * std::sqrt(luminance);
+        total += w;
+        // Straight loops over fixed-size arrays; the compiler vectorizes
+        // them across wavelengths.
+        for (size_t i = 0; i < kWavelengths; ++i) {
+            const double reflectance =
+                r * t.basis[0][i] + g * t.basis[1][i] + b * t.basis[2][i];
+            ks[i] += w * absorption_ratio(reflectance);
+        }
+    }
+
+    double linear[3] = {};
+    for (size_t i = 0; i < kWavelengths; ++i) {
+        const double reflectance = reflectance_from_ratio(ks[i] / total);
+        linear[0] += t.projection[0][i] * reflectance;
+        linear[1] += t.projection[1][i] * reflectance;
+        linear[2] += t.projection[2][i] * reflectance;
+    }
+    return {linear_to_srgb8(linear[0]), linear_to_srgb8(linear[1]),
+            linear_to_srgb8(linear[2])};
+}
+
+uint8_t round_channel(double value) {
+    return static_cast<uint8_t>(
+        std::clamp(static_cast<int>(std::round(value)), 0, 255));
+}
+} // namespace
+
+bool parse_mix_mode(std::string_view name, mix_mode &out) {
+    if (name == "srgb") {
+        out = mix_mode::srgb;
+    } else if (name == "linear") {
+        out = mix_mode::linear;
+    } else if (name == "oklab") {
+        out = mix_mode::oklab;
+    } else if (name == "pigment") {
+        out = mix_mode::pigment;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char *mix_mode_label(mix_mode mode) {
+    switch (mode) {
+    case mix_mode::srgb:
+        return "sRGB average";
+    case mix_mode::linear:
+        return "linear light";
+    case mix_mode::oklab:
+        return "OKLab";
+    case mix_mode::pigment:
+        return "pigment (Kubelka-Munk)";
+    }
+    return "sRGB average";
+}
+
+bool parse_mix_weights(const std::string &raw, size_t count,
+                       std::vector<double> &out, std::string &error) {
+    out.clear();
+    size_t start = 0;
+    while (start <= raw.size()) {
+        const size_t delimiter = raw.find(';', start);
+        const std::string token =
+            raw.substr(start, delimiter == std::string::npos
+                                  ? std::string::npos
+                                  : delimiter - start);
+        size_t consumed = 0;
+        double value = 0.0;
+        try {
+            value = std::stod(token, &consumed);
+        } catch (...) {
+            consumed = 0;
+        }
+        while (consumed < token.size() &&
+               std::isspace(static_cast<unsigned char>(token[consumed]))) {
+            ++consumed;
+        }
+        if (consumed == 0 || consumed != token.size() ||
+            !std::isfinite(value) || value <= 0.0) {
+            error = "`weights` must be positive numbers separated by ';'.";
+            return false;
+        }
+        out.push_back(value);
+
+        if (delimiter == std::string::npos) {
+            break;
+        }
+        start = delimiter + 1;
+    }
+
+    if (out.size() != count) {
+        error = "Provide one weight per color (" + std::to_string(count) +
+                " expected, got " + std::to_string(out.size()) + ").";
+        return false;
+    }
+    return true;
+}
+
+rgb_color mix_colors_weighted(const std::vector<rgb_color> &colors,
+                              const std::vector<double> &weights,
+                              mix_mode mode) {
+    if (colors.empty()) {
+        return {0, 0, 0};
+    }
+
+    // Parts are scaled so the largest is 1; huge weights would otherwise
+    // overflow the sums to inf and mix to black.
+    std::vector<double> parts = weights;
+    const double largest = parts.size() == colors.size()
+                               ? *std::max_element(parts.begin(), parts.end())
+                               : 0.0;
+    if (!std::isfinite(largest) || largest <= 0.0) {
+        parts.assign(colors.size(), 1.0);
+    } else {
+        for (double &part : parts) {
+            part /= largest;
+        }
+    }
+    double total = 0.0;
+    for (const double part : parts) {
+        total += part;
+    }
+
+    if (mode == mix_mode::pigment) {
+        return mix_pigment(colors, parts);
+    }
+
+    const auto &to_linear = srgb_to_linear_table();
+    double sum[3] = {};
+    for (size_t c = 0; c < colors.size(); ++c) {
+        const double w = parts[c] / total;
+        const rgb_color value = colors[c];
+        if (mode == mix_mode::srgb) {
+            sum[0] += w * value.r;
+            sum[1] += w * value.g;
+            sum[2] += w * value.b;
+        } else if (mode == mix_mode::linear) {
+            sum[0] += w * to_linear[value.r];
+            sum[1] += w * to_linear[value.g];
+            sum[2] += w * to_linear[value.b];
+        } else {
+            const oklab_color lab = rgb_to_oklab(value);
+            sum[0] += w * lab.l;
+            sum[1] += w * lab.a;
+            sum[2] += w * lab.b;
+        }
+    }
+
+    switch (mode) {
+    case mix_mode::srgb:
+        return {round_channel(sum[0]), round_channel(sum[1]),
+                round_channel(sum[2])};
+    case mix_mode::linear:
+        return {linear_to_srgb8(sum[0]), linear_to_srgb8(sum[1]),
+                linear_to_srgb8(sum[2])};
+    default:
+        return oklab_to_rgb({sum[0], sum[1], sum[2]});
+    }
+}
+
+} // namespace palette::services
@@ -0,0 +1,143 @@
+#include "palette/services/color_space.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace palette::services {
+namespace {
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kGamutEpsilon = 1e-4;
+
+void linear_to_lms_cbrt(double r, double g, double b, double &l, double &m,
+                        double &s) {
+    l = std::cbrt(0.4122214708 * r + 0.5363325363 * g + 0.0514459929 * b);
+    m = std::cbrt(0.2119034982 * r + 0.6806995451 * g + 0.1073969566 * b);
+    s = std::cbrt(0.0883024619 * r + 0.2817188376 * g + 0.6299787005 * b);
+}
+} // namespace
+
+const std::array<float, 256> &srgb_to_linear_table() {
+    static const std::array<float, 256> table = [] {
+        std::array<float, 256> out{};
+        for (size_t i = 0; i < out.size(); ++i) {
+            out[i] = static_cast<float>(
+                srgb_to_linear(static_cast<double>(i) / 255.0));
+        }
+        return out;
+    }();
+    return table;
+}
+
+const std::array<uint8_t, kLinearToSrgbTableSize> &linear_to_srgb8_table() {
+    static const std::array<uint8_t, kLinearToSrgbTableSize> table = [] {
+        std::array<uint8_t, kLinearToSrgbTableSize> out{};
+        for (size_t i = 0; i < out.size(); ++i) {
+            out[i] = linear_to_srgb8(static_cast<double>(i) /
+                                     static_cast<double>(out.size() - 1));
+        }
+        return out;
+    }();
+    return table;
+}
+
+double srgb_to_linear(double encoded) {
+    if (encoded <= 0.04045) {
+        return encoded / 12.92;
+    }
+    return std::pow((encoded + 0.055) / 1.055, 2.4);
+}
+
+double linear_to_srgb(double linear) {
+    if (linear <= 0.0031308) {
+        return linear * 12.92;
+    }
+    return 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+}
+
+uint8_t linear_to_srgb8(double linear) {
+    const double encoded = linear_to_srgb(std::clamp(linear, 0.0, 1.0));
+    return static_cast<uint8_t>(
+        std::clamp(static_cast<int>(std::round(encoded * 255.0)), 0, 255));
+}
+
+oklab_color linear_rgb_to_oklab(double r, double g, double b) {
+    double l = 0.0;
+    double m = 0.0;
+    double s = 0.0;
+    linear_to_lms_cbrt(r, g, b, l, m, s);
+    return {
+        0.2104542553 * l + 0.7936177850 * m - 0.0040720468 * s,
+        1.9779984951 * l - 2.4285922050 * m + 0.4505937099 * s,
+        0.0259040371 * l + 0.7827717662 * m - 0.8086757660 * s,
+    };
+}
+
+void oklab_to_linear_rgb(oklab_color value, double &r, double &g, double &b) {
+    const double l_ = value.l + 0.3963377774 * value.a + 0.2158037573 * value.b;
+    const double m_ = value.l - 0.1055613458 * value.a - 0.0638541728 * value.b;
+    const double s_ = value.l - 0.0894841775 * value.a - 1.2914855480 * value.b;
+
+    const double l = l_ * l_ * l_;
+    const double m = m_ * m_ * m_;
+    const double s = s_ * s_ * s_;
+
+    r = 4.0767416621 * l - 3.3077115913 * m + 0.2309699292 * s;
+    g = -1.2684380046 * l + 2.6097574011 * m - 0.3413193965 * s;
+    b = -0.0041960863 * l - 0.7034186147 * m + 1.7076147010 * s;
+}
+
+oklab_color rgb_to_oklab(rgb_color value) {
+    const auto &table = srgb_to_linear_table();
+    return linear_rgb_to_oklab(table[value.r], table[value.g], table[value.b]);
+}
+
+rgb_color oklab_to_rgb(oklab_color value) {
+    double r = 0.0;
+    double g = 0.0;
+    double b = 0.0;
+    oklab_to_linear_rgb(value, r, g, b);
+    return {linear_to_srgb8(r), linear_to_srgb8(g), linear_to_srgb8(b)};
+}
+
+bool oklab_in_srgb_gamut(oklab_color value) {
+    double r = 0.0;
+    double g = 0.0;
+    double b = 0.0;
+    oklab_to_linear_rgb(value, r, g, b);
+    return r >= -kGamutEpsilon && r <= 1.0 + kGamutEpsilon &&
+           g >= -kGamutEpsilon && g <= 1.0 + kGamutEpsilon &&
+           b >= -kGamutEpsilon && b <= 1.0 + kGamutEpsilon;
+}
+
+oklch_color oklab_to_oklch(oklab_color value) {
+    double h = std::atan2(value.b, value.a) * 180.0 / kPi;
+    if (h < 0.0) {
+        h += 360.0;
+    }
+    return {value.l, std::hypot(value.a, value.b), h};
+}
+
+oklab_color oklch_to_oklab(oklch_color value) {
+    const double radians = value.h * kPi / 180.0;
+    return {value.l, value.c * std::cos(radians), value.c * std::sin(radians)};
+}
+
+double oklab_distance_squared(oklab_color x, oklab_color y) {
+    const double dl = x.l - y.l;
+    const double da = x.a - y.a;
+    const double db = x.b - y.b;
+    return dl * dl + da * da + db * db;
+}
+
+void rgb_to_oklab_batch(const rgb_color *in, size_t count, float *l, float *a,
+                        float *b) {
+    const auto &table = srgb_to_linear_table();
+    for (size_t i = 0; i < count; ++i) {
+        const oklab_color lab = linear_rgb_to_oklab(
+            table[in[i].r], table[in[i].g], table[in[i].b]);
+        l[i] = static_cast<float>(lab.l);
+        a[i] = static_cast<float>(lab.a);
+        b[i] = static_cast<float>(lab.b);
+    }
+}
+
+} // namespace palette::services
@@ -0,0 +1,334 @@
+#include "palette/services/color_transform.hpp"
+#include "palette/services/env_utils.hpp"
+#include "palette/services/thread_pool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace palette::services {
+namespace {
+constexpr size_t kParallelChunk = 1024;
+constexpr const char *kDefaultCmykProfilePath = "profiles/cmyk.icc";
+
+using profile_pair = std::pair<uint64_t, uint64_t>;
+
+struct profile_pair_hash {
+    size_t operator()(const profile_pair &key) const {
+        return static_cast<size_t>(key.first * 1099511628211ULL ^ key.second);
+    }
+};
+
+// The profiles are kept with their transform, so a hit can be checked
+// against the exact pair it was compiled for.
+struct cached_transform {
+    std::shared_ptr<const icc_profile> source;
+    std::shared_ptr<const icc_profile> destination;
+    std::shared_ptr<const color_transform> transform;
+};
+
+std::mutex transform_mutex;
+std::unordered_map<profile_pair, cached_transform, profile_pair_hash>
+    transform_by_pair;
+
+void compile_node(const icc_profile &source, const icc_profile &destination,
+                  const color_transform &transform, size_t node, float *out) {
+    double device[4] = {};
+    size_t remainder = node;
+    for (int i = transform.inputs - 1; i >= 0; --i) {
+        device[i] = static_cast<double>(remainder % transform.grid) /
+                    (transform.grid - 1);
+        remainder /= static_cast<size_t>(transform.grid);
+    }
+    double xyz[3];
+    double result[4] = {};
+    icc_device_to_pcs(source, device, xyz);
+    icc_pcs_to_device(destination, xyz, result);
+    for (int o = 0; o < transform.outputs; ++o) {
+        out[o] = static_cast<float>(std::clamp(result[o], 0.0, 1.0));
+    }
+}
+
+// Tetrahedral interpolation inside one cube of a 3D node grid, given the
+// first node and the x/y/z node strides. The traversal order follows the
+// ordering of the fractions.
+template <int Outputs>
+void tetrahedral(const float *c000, size_t sx, size_t sy, size_t sz, float rx,
+                 float ry, float rz, float *out) {
+    const float *c111 = c000 + sx + sy + sz;
+    const float *first;
+    const float *second;
+    float r1;
+    float r2;
+    float r3;
+    if (rx >= ry) {
+        if (ry >= rz) {
+            first = c000 + sx;
+            second = first + sy;
+            r1 = rx, r2 = ry, r3 = rz;
+        } else if (rx >= rz) {
+            first = c000 + sx;
+            second = first + sz;
+            r1 = rx, r2 = rz, r3 = ry;
+        } else {
+            first = c000 + sz;
+            second = first + sx;
+            r1 = rz, r2 = rx, r3 = ry;
+        }
+    } else {
+        if (rx >= rz) {
+            first = c000 + sy;
+            second = first + sx;
+            r1 = ry, r2 = rx, r3 = rz;
+        } else if (ry >= rz) {
+            first = c000 + sy;
+            second = first + sz;
+            r1 = ry, r2 = rz, r3 = rx;
+        } else {
+            first = c000 + sz;
+            second = first + sy;
+            r1 = rz, r2 = ry, r3 = rx;
+        }
+    }
+    for (int o = 0; o < Outputs; ++o) {
+        out[o] = c000[o] + (first[o] - c000[o]) * r1 +
+                 (second[o] - first[o]) * r2 + (c111[o] - second[o]) * r3;
+    }
+}
+
+template <int Outputs>
+void lookup(const color_transform &t, const uint32_t *offset,
+            const float *fraction, float *out) {
+    const float *origin = t.nodes.data() + offset[0] + offset[1] + offset[2];
+    if (t.inputs == 3) {
+        tetrahedral<Outputs>(origin, t.strides[0], t.strides[1], t.strides[2],
+                             fraction[0], fraction[1], fraction[2], out);
+        return;
+    }
+    // CMYK: interpolate CMY in the two K slices around the input, then
+    // blend the slices.
+    float low[Outputs];
+    float high[Outputs];
+    origin += offset[3];
+    tetrahedral<Outputs>(origin, t.strides[0], t.strides[1], t.strides[2],
+                         fraction[0], fraction[1], fraction[2], low);
+    tetrahedral<Outputs>(origin + t.strides[3], t.strides[0], t.strides[1],
+                         t.strides[2], fraction[0], fraction[1], fraction[2],
+                         high);
+    for (int o = 0; o < Outputs; ++o) {
+        out[o] = low[o] + (high[o] - low[o]) * fraction[3];
+    }
+}
+
+template <int Outputs>
+void apply_bytes(const color_transform &t, const uint8_t *in, uint8_t *out,
+                 size_t count) {
+    uint32_t offset[4] = {};
+    float fraction[4] = {};
+    float values[Outputs];
+    for (size_t p = 0; p < count; ++p) {
+        for (int i = 0; i < t.inputs; ++i) {
+            offset[i] = t.offsets[static_cast<size_t>(i)][in[i]];
+            fraction[i] = t.fractions[static_cast<size_t>(i)][in[i]];
+        }
+        lookup<Outputs>(t, offset, fraction, values);
+        for (int o = 0; o < Outputs; ++o) {
+            out[o] = static_cast<uint8_t>(values[o] * 255.0F + 0.5F);
+        }
+        in += t.inputs;
+        out += Outputs;
+    }
+}
+
+std::shared_ptr<const icc_profile> load_configured_cmyk_profile() {
+    const std::string path =
+        get_env_value_or("BOT_CMYK_PROFILE", kDefaultCmykProfilePath);
+    std::string error;
+    std::shared_ptr<const icc_profile> profile = load_icc_profile(path, error);
+    if (!profile) {
+        // A missing default profile is normal; only report explicit ones.
+        if (!get_env_value("BOT_CMYK_PROFILE").empty()) {
+            std::cerr << "CMYK profile not loaded: " << error << "\n";
+        }
+        return nullptr;
+    }
+    if (profile->space != icc_device_space::cmyk ||
+        !icc_profile_is_output_capable(*profile)) {
+        std::cerr << "CMYK profile not loaded: " << path
+                  << " is not a CMYK output profile.\n";
+        return nullptr;
+    }
+    return profile;
+}
+
+uint8_t percent_to_byte(double percent) {
+    return static_cast<uint8_t>(std::clamp(
+        static_cast<int>(std::lround(percent / 100.0 * 255.0)), 0, 255));
+}
+} // namespace
+
+std::shared_ptr<const color_transform>
+build_color_transform(const icc_profile &source,
+                      const icc_profile &destination) {
+    if (!icc_profile_is_output_capable(destination)) {
+        return nullptr;
+    }
+
+    auto transform = std::make_shared<color_transform>();
+    transform->inputs = icc_channel_count(source.space);
+    transform->outputs = icc_channel_count(destination.space);
+    transform->grid =
+        transform->inputs == 4 ? kCmykTransformGrid : kRgbTransformGrid;
+
+    const size_t grid = static_cast<size_t>(transform->grid);
+    size_t step = static_cast<size_t>(transform->outputs);
+    for (int i = transform->inputs - 1; i >= 0; --i) {
+        transform->strides[static_cast<size_t>(i)] = step;
+        step *= grid;
+    }
+    const size_t node_count = step / static_cast<size_t>(transform->outputs);
+    transform->nodes.resize(step);
+
+    for (int i = 0; i < transform->inputs; ++i) {
+        const size_t axis = static_cast<size_t>(i);
+        for (size_t v = 0; v < 256; ++v) {
+            const double position =
+                static_cast<double>(v) * static_cast<double>(grid - 1) / 255.0;
+            const size_t cell =
+                std::min(static_cast<size_t>(position), grid - 2);
+            transform->offsets[axis][v] =
+                static_cast<uint32_t>(cell * transform->strides[axis]);
+            transform->fractions[axis][v] =
+                static_cast<float>(position - static_cast<double>(cell));
+        }
+    }
+
+    const auto compile_range = [&](size_t begin, size_t end) {
+        for (size_t node = begin; node < end; ++node) {
+            compile_node(source, destination, *transform, node,
+                         transform->nodes.data() +
+                             node * static_cast<size_t>(transform->outputs));
+        }
+    };
+    thread_pool *const pool = thread_pool::current();
+    if (pool) {
+        pool->parallel_for(node_count, kParallelChunk, compile_range);
+    } else {
+        compile_range(0, node_count);
+    }
+    return transform;
+}
+
+std::shared_ptr<const color_transform>
+get_color_transform(const std::shared_ptr<const icc_profile> &source,
+                    const std::shared_ptr<const icc_profile> &destination) {
+    if (!source || !destination) {
+        return nullptr;
+    }
+
+    const profile_pair key{source->hash, destination->hash};
+    {
+        std::lock_guard<std::mutex> lock(transform_mutex);
+        auto it = transform_by_pair.find(key);
+        if (it != transform_by_pair.end() &&
+            it->second.source == source &&
+            it->second.destination == destination) {
+            return it->second.transform;
+        }
+    }
+
+    std::shared_ptr<const color_transform> transform =
+        build_color_transform(*source, *destination);
+    if (!transform) {
+        return nullptr;
+    }
+    // Other profiles with the same hashes lose their entry to this pair.
+    std::lock_guard<std::mutex> lock(transform_mutex);
+    transform_by_pair[key] = {source, destination, transform};
+    return transform;
+}
+
+void apply_color_transform(const color_transform &transform,
+                           const uint8_t *in, uint8_t *out, size_t count) {
+    if (transform.outputs == 4) {
+        apply_bytes<4>(transform, in, out, count);
+    } else {
+        apply_bytes<3>(transform, in, out, count);
+    }
+}
+
+void apply_color_transform(const color_transform &transform, const double *in,
+                           double *out) {
+    uint32_t offset[4] = {};
+    float fraction[4] = {};
+    const size_t grid = static_cast<size_t>(transform.grid);
+    for (int i = 0; i < transform.inputs; ++i) {
+        const size_t axis = static_cast<size_t>(i);
+        const double position =
+            std::clamp(in[i], 0.0, 1.0) * static_cast<double>(grid - 1);
+        const size_t cell = std::min(static_cast<size_t>(position), grid - 2);
+        offset[i] = static_cast<uint32_t>(cell * transform.strides[axis]);
+        fraction[i] = static_cast<float>(position - static_cast<double>(cell));
+    }
+
+    float values[4] = {};
+    if (transform.outputs == 4) {
+        lookup<4>(transform, offset, fraction, values);
+    } else {
+        lookup<3>(transform, offset, fraction, values);
+    }
+    for (int o = 0; o < transform.outputs; ++o) {
+        out[o] = values[o];
+    }
+}
+
+std::shared_ptr<const icc_profile> cmyk_icc_profile() {
+    static const std::shared_ptr<const icc_profile> profile =
+        load_configured_cmyk_profile();
+    return profile;
+}
+
+bool profiled_cmyk_to_rgb(const std::array<double, 4> &cmyk, rgb_color &out) {
+    const std::shared_ptr<const color_transform> transform =
+        get_color_transform(cmyk_icc_profile(), srgb_icc_profile());
+    if (!transform) {
+        return false;
+    }
+    const uint8_t in[4] = {percent_to_byte(cmyk[0]), percent_to_byte(cmyk[1]),
+                           percent_to_byte(cmyk[2]), percent_to_byte(cmyk[3])};
+    uint8_t rgb[3];
+    apply_color_transform(*transform, in, rgb, 1);
+    out = {rgb[0], rgb[1], rgb[2]};
+    return true;
+}
+
+bool profiled_rgb_to_cmyk(rgb_color in, std::array<double, 4> &cmyk) {
+    const std::shared_ptr<const color_transform> transform =
+        get_color_transform(srgb_icc_profile(), cmyk_icc_profile());
+    if (!transform) {
+        return false;
+    }
+    const double rgb[3] = {in.r / 255.0, in.g / 255.0, in.b / 255.0};
+    double values[4];
+    apply_color_transform(*transform, rgb, values);
+    for (size_t i = 0; i < 4; ++i) {
+        cmyk[i] = values[i] * 100.0;
+    }
+    return true;
+}
+
+bool rgb_to_display_p3(rgb_color in, std::array<double, 3> &p3) {
+    const std::shared_ptr<const color_transform> transform =
+        get_color_transform(srgb_icc_profile(), display_p3_icc_profile());
+    if (!transform) {
+        return false;
+    }
+    const double rgb[3] = {in.r / 255.0, in.g / 255.0, in.b / 255.0};
+    apply_color_transform(*transform, rgb, p3.data());
+    return true;
+}
+
+} // namespace palette::services
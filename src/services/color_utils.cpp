@@ -1,4 +1,6 @@
 #include "palette/services/color_utils.hpp"
+#include "palette/services/color_transform.hpp"
+#include "palette/services/interaction_context.hpp"
 #include <algorithm>
 #include <cmath>
 #include <cctype>
@@ -176,7 +178,7 @@ bool read_optional_string(const dpp::command_value &value, std::string &out) {
 }
 
 single_color_input_result
-parse_single_color_input(const dpp::slashcommand_t &event) {
+parse_single_color_input(const interaction_context &event) {
     single_color_input_result result;
 
     std::string hex;
@@ -221,7 +223,7 @@ parse_single_color_input(const dpp::slashcommand_t &event) {
 }
 
 multi_color_input_result
-parse_multi_color_input(const dpp::slashcommand_t &event, size_t max_colors) {
+parse_multi_color_input(const interaction_context &event, size_t max_colors) {
     multi_color_input_result result;
 
     std::string hex;
@@ -433,6 +435,12 @@ bool parse_cmyk_to_rgb(const std::string &value, rgb_color &out) {
         return false;
     }
 
+    // Print-accurate when a CMYK profile is configured; otherwise the
+    // naive device conversion.
+    if (profiled_cmyk_to_rgb({c, m, y, k}, out)) {
+        return true;
+    }
+
     const double c01 = c / 100.0;
     const double m01 = m / 100.0;
     const double y01 = y / 100.0;
@@ -541,11 +549,21 @@ bool parse_color_list(const std::string &raw, color_model model,
     return !out.empty();
 }
 
+const std::array<double, 256> &wcag_channel_linear_table() {
+    static const std::array<double, 256> table = [] {
+        std::array<double, 256> out{};
+        for (size_t i = 0; i < out.size(); ++i) {
+            out[i] = srgb_channel_to_linear(static_cast<uint8_t>(i));
+        }
+        return out;
+    }();
+    return table;
+}
+
 double relative_luminance(rgb_color value) {
-    const double r = srgb_channel_to_linear(value.r);
-    const double g = srgb_channel_to_linear(value.g);
-    const double b = srgb_channel_to_linear(value.b);
-    return 0.2126 * r + 0.7152 * g + 0.0722 * b;
+    const auto &table = wcag_channel_linear_table();
+    return 0.2126 * table[value.r] + 0.7152 * table[value.g] +
+           0.0722 * table[value.b];
 }
 
 double contrast_ratio(rgb_color a, rgb_color b) {
@@ -589,34 +607,6 @@ rgb_color nearest_web_safe_color(rgb_color value) {
     };
 }
 
-rgb_color mix_colors(const std::vector<rgb_color> &colors) {
-    if (colors.empty()) {
-        return {0, 0, 0};
-    }
-
-    int sum_r = 0;
-    int sum_g = 0;
-    int sum_b = 0;
-    for (const rgb_color value : colors) {
-        sum_r += static_cast<int>(value.r);
-        sum_g += static_cast<int>(value.g);
-        sum_b += static_cast<int>(value.b);
-    }
-
-    const int count = static_cast<int>(colors.size());
-    return {
-        static_cast<uint8_t>(std::clamp(static_cast<int>(std::round(
-                                 static_cast<double>(sum_r) / count)),
-                                         0, 255)),
-        static_cast<uint8_t>(std::clamp(static_cast<int>(std::round(
-                                 static_cast<double>(sum_g) / count)),
-                                         0, 255)),
-        static_cast<uint8_t>(std::clamp(static_cast<int>(std::round(
-                                 static_cast<double>(sum_b) / count)),
-                                         0, 255)),
-    };
-}
-
 std::string rgb_to_hex(rgb_color value) {
     return "#" + to_hex_pair(value.r) + to_hex_pair(value.g) + to_hex_pair(value.b);
 }
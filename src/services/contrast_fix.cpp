@@ -0,0 +1,200 @@
+#include "palette/services/contrast_fix.hpp"
+#include "palette/services/color_space.hpp"
+#include "palette/services/color_utils.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace palette::services {
+namespace {
+// Fixed iteration counts keep every solve bounded: 24 halvings resolve
+// lightness far below one 8-bit step.
+constexpr int kLightnessIterations = 24;
+constexpr int kChromaIterations = 16;
+constexpr int kRoundingNudges = 64;
+constexpr double kRoundingNudge = 0.002;
+
+// Reduces chroma until the OKLCH color fits in sRGB, keeping lightness and
+// hue.
+rgb_color oklch_to_rgb_in_gamut(double l, double c, double h) {
+    const oklch_color wanted{std::clamp(l, 0.0, 1.0), c, h};
+    if (oklab_in_srgb_gamut(oklch_to_oklab(wanted))) {
+        return oklab_to_rgb(oklch_to_oklab(wanted));
+    }
+
+    double low = 0.0;
+    double high = c;
+    for (int i = 0; i < kChromaIterations; ++i) {
+        const double mid = (low + high) / 2.0;
+        if (oklab_in_srgb_gamut(oklch_to_oklab({wanted.l, mid, h}))) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    return oklab_to_rgb(oklch_to_oklab({wanted.l, low, h}));
+}
+
+// Lightness in [low, high] where luminance crosses `target`. Luminance
+// rises with lightness, so this is a plain bisection; `want_above` picks
+// the side of the crossing that is returned.
+double solve_lightness(const oklch_color &base, double target, double low,
+                       double high, bool want_above) {
+    for (int i = 0; i < kLightnessIterations; ++i) {
+        const double mid = (low + high) / 2.0;
+        const double y =
+            relative_luminance(oklch_to_rgb_in_gamut(mid, base.c, base.h));
+        if (y >= target) {
+            high = mid;
+        } else {
+            low = mid;
+        }
+    }
+    return want_above ? high : low;
+}
+
+double delta_e(rgb_color a, rgb_color b) {
+    return std::sqrt(oklab_distance_squared(rgb_to_oklab(a), rgb_to_oklab(b))) *
+           100.0;
+}
+
+// Minimal step distance k such that all pairs at least k apart reach
+// `ratio`.
+int separation_for(const std::vector<rgb_color> &colors, double ratio) {
+    const int n = static_cast<int>(colors.size());
+    for (int k = 1; k < n; ++k) {
+        bool all = true;
+        for (int i = 0; i + k < n && all; ++i) {
+            for (int j = i + k; j < n; ++j) {
+                if (contrast_ratio(colors[static_cast<size_t>(i)],
+                                   colors[static_cast<size_t>(j)]) < ratio) {
+                    all = false;
+                    break;
+                }
+            }
+        }
+        if (all) {
+            return k;
+        }
+    }
+    return 0;
+}
+} // namespace
+
+bool parse_contrast_level(std::string_view name, contrast_level &out) {
+    if (name == "aa") {
+        out = contrast_level::aa_normal;
+    } else if (name == "aa-large") {
+        out = contrast_level::aa_large;
+    } else if (name == "aaa") {
+        out = contrast_level::aaa_normal;
+    } else if (name == "aaa-large") {
+        out = contrast_level::aaa_large;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+double contrast_level_ratio(contrast_level level) {
+    switch (level) {
+    case contrast_level::aa_normal:
+        return 4.5;
+    case contrast_level::aa_large:
+        return 3.0;
+    case contrast_level::aaa_normal:
+        return 7.0;
+    case contrast_level::aaa_large:
+        return 4.5;
+    }
+    return 4.5;
+}
+
+const char *contrast_level_label(contrast_level level) {
+    switch (level) {
+    case contrast_level::aa_normal:
+        return "AA normal text";
+    case contrast_level::aa_large:
+        return "AA large text";
+    case contrast_level::aaa_normal:
+        return "AAA normal text";
+    case contrast_level::aaa_large:
+        return "AAA large text";
+    }
+    return "AA normal text";
+}
+
+std::vector<contrast_fix> find_contrast_fixes(rgb_color text,
+                                              rgb_color background,
+                                              double target_ratio) {
+    const double background_y = relative_luminance(background);
+    const double text_y = relative_luminance(text);
+    const oklch_color base = oklab_to_oklch(rgb_to_oklab(text));
+
+    // Luminances the text has to reach on either side of the background.
+    const double lighter_y = target_ratio * (background_y + 0.05) - 0.05;
+    const double darker_y = (background_y + 0.05) / target_ratio - 0.05;
+
+    std::vector<contrast_fix> fixes;
+    const auto add_fix = [&](bool lighter, double start) {
+        // A side the text already reaches needs no fix.
+        if (lighter ? text_y >= lighter_y : text_y <= darker_y) {
+            return;
+        }
+        double l = lighter
+                       ? solve_lightness(base, lighter_y, start, 1.0, true)
+                       : solve_lightness(base, darker_y, 0.0, start, false);
+        rgb_color candidate = oklch_to_rgb_in_gamut(l, base.c, base.h);
+        // Rounding to 8 bits can land just short of the target.
+        for (int i = 0;
+             i < kRoundingNudges &&
+             contrast_ratio(candidate, background) < target_ratio;
+             ++i) {
+            l += lighter ? kRoundingNudge : -kRoundingNudge;
+            candidate = oklch_to_rgb_in_gamut(l, base.c, base.h);
+        }
+
+        const double ratio = contrast_ratio(candidate, background);
+        if (ratio >= target_ratio) {
+            fixes.push_back(
+                {candidate, ratio, delta_e(text, candidate), lighter});
+        }
+    };
+
+    if (lighter_y <= 1.0) {
+        add_fix(true, base.l);
+    }
+    if (darker_y >= 0.0) {
+        add_fix(false, base.l);
+    }
+
+    std::sort(fixes.begin(), fixes.end(),
+              [](const contrast_fix &a, const contrast_fix &b) {
+                  return a.distance < b.distance;
+              });
+    return fixes;
+}
+
+tonal_scale generate_tonal_scale(rgb_color seed, int steps) {
+    tonal_scale scale;
+    const int count = std::clamp(steps, kMinTonalScaleSteps,
+                                 kMaxTonalScaleSteps);
+    const oklch_color base = oklab_to_oklch(rgb_to_oklab(seed));
+
+    // Pure white and black sit one step beyond either end, so the ends of
+    // the scale still contrast with plain backgrounds.
+    const double top = std::log(1.05);
+    const double step = std::log(21.0) / static_cast<double>(count + 1);
+    scale.colors.reserve(static_cast<size_t>(count));
+    for (int i = 0; i < count; ++i) {
+        const double target =
+            std::exp(top - step * static_cast<double>(i + 1)) - 0.05;
+        const double l = solve_lightness(base, target, 0.0, 1.0, true);
+        scale.colors.push_back(oklch_to_rgb_in_gamut(l, base.c, base.h));
+    }
+
+    scale.aa_separation = separation_for(scale.colors, 4.5);
+    scale.aaa_separation = separation_for(scale.colors, 7.0);
+    return scale;
+}
+
+} // namespace palette::services
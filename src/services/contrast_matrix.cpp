@@ -0,0 +1,175 @@
+#include "palette/services/contrast_matrix.hpp"
+#include "palette/services/color_utils.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace palette::services {
+namespace {
+// APCA-W3 0.0.98G-4g constants.
+constexpr double kApcaExponent = 2.4;
+constexpr double kApcaRed = 0.2126729;
+constexpr double kApcaGreen = 0.7151522;
+constexpr double kApcaBlue = 0.0721750;
+constexpr double kApcaBlackThreshold = 0.022;
+constexpr double kApcaBlackClamp = 1.414;
+constexpr double kApcaNormalBackground = 0.56;
+constexpr double kApcaNormalText = 0.57;
+constexpr double kApcaReverseBackground = 0.65;
+constexpr double kApcaReverseText = 0.62;
+constexpr float kApcaScale = 1.14F;
+constexpr float kApcaOffset = 0.027F;
+constexpr float kApcaLowClip = 0.1F;
+constexpr float kApcaMinDeltaY = 0.0005F;
+
+double apca_luminance(rgb_color c) {
+    const double y =
+        kApcaRed * std::pow(c.r / 255.0, kApcaExponent) +
+        kApcaGreen * std::pow(c.g / 255.0, kApcaExponent) +
+        kApcaBlue * std::pow(c.b / 255.0, kApcaExponent);
+    if (y < kApcaBlackThreshold) {
+        return y + std::pow(kApcaBlackThreshold - y, kApcaBlackClamp);
+    }
+    return y;
+}
+
+void fill_wcag(const std::vector<rgb_color> &texts,
+               const std::vector<rgb_color> &backgrounds, float *out) {
+    std::vector<float> background_l(backgrounds.size());
+    for (size_t i = 0; i < backgrounds.size(); ++i) {
+        background_l[i] =
+            static_cast<float>(relative_luminance(backgrounds[i]) + 0.05);
+    }
+
+    for (size_t row = 0; row < texts.size(); ++row) {
+        const float text_l =
+            static_cast<float>(relative_luminance(texts[row]) + 0.05);
+        float *const line = out + row * backgrounds.size();
+        for (size_t col = 0; col < backgrounds.size(); ++col) {
+            const float lighter = std::max(text_l, background_l[col]);
+            const float darker = std::min(text_l, background_l[col]);
+            line[col] = lighter / darker;
+        }
+    }
+}
+
+void fill_apca(const std::vector<rgb_color> &texts,
+               const std::vector<rgb_color> &backgrounds, float *out) {
+    // The power terms depend on one side of the pair only, so they are
+    // hoisted out of the pair loop.
+    const size_t columns = backgrounds.size();
+    std::vector<float> background_y(columns);
+    std::vector<float> background_normal(columns);
+    std::vector<float> background_reverse(columns);
+    for (size_t i = 0; i < columns; ++i) {
+        const double y = apca_luminance(backgrounds[i]);
+        background_y[i] = static_cast<float>(y);
+        background_normal[i] =
+            static_cast<float>(std::pow(y, kApcaNormalBackground));
+        background_reverse[i] =
+            static_cast<float>(std::pow(y, kApcaReverseBackground));
+    }
+
+    for (size_t row = 0; row < texts.size(); ++row) {
+        const double y = apca_luminance(texts[row]);
+        const float text_y = static_cast<float>(y);
+        const float text_normal =
+            static_cast<float>(std::pow(y, kApcaNormalText));
+        const float text_reverse =
+            static_cast<float>(std::pow(y, kApcaReverseText));
+
+        float *const line = out + row * columns;
+        for (size_t col = 0; col < columns; ++col) {
+            const bool normal = background_y[col] > text_y;
+            const float sapc =
+                normal ? (background_normal[col] - text_normal) * kApcaScale
+                       : (background_reverse[col] - text_reverse) * kApcaScale;
+            float lc = 0.0F;
+            if (normal && sapc >= kApcaLowClip) {
+                lc = sapc - kApcaOffset;
+            } else if (!normal && sapc <= -kApcaLowClip) {
+                lc = sapc + kApcaOffset;
+            }
+            if (std::fabs(background_y[col] - text_y) < kApcaMinDeltaY) {
+                lc = 0.0F;
+            }
+            line[col] = lc * 100.0F;
+        }
+    }
+}
+} // namespace
+
+bool parse_contrast_method(std::string_view name, contrast_method &out) {
+    if (name == "wcag") {
+        out = contrast_method::wcag;
+        return true;
+    }
+    if (name == "apca") {
+        out = contrast_method::apca;
+        return true;
+    }
+    return false;
+}
+
+contrast_matrix
+compute_contrast_matrix(const std::vector<rgb_color> &texts,
+                        const std::vector<rgb_color> &backgrounds,
+                        contrast_method method) {
+    contrast_matrix matrix;
+    matrix.method = method;
+    matrix.rows = texts.size();
+    matrix.columns = backgrounds.size();
+    matrix.values.assign(matrix.rows * matrix.columns, 0.0F);
+    if (matrix.values.empty()) {
+        return matrix;
+    }
+
+    if (method == contrast_method::apca) {
+        fill_apca(texts, backgrounds, matrix.values.data());
+    } else {
+        fill_wcag(texts, backgrounds, matrix.values.data());
+    }
+    return matrix;
+}
+
+contrast_grade grade_contrast(contrast_method method, float value) {
+    if (method == contrast_method::apca) {
+        const float lc = std::fabs(value);
+        if (lc >= 90.0F) {
+            return contrast_grade::aaa;
+        }
+        if (lc >= 75.0F) {
+            return contrast_grade::aa;
+        }
+        if (lc >= 60.0F) {
+            return contrast_grade::large_text;
+        }
+        return contrast_grade::fail;
+    }
+
+    if (value >= 7.0F) {
+        return contrast_grade::aaa;
+    }
+    if (value >= 4.5F) {
+        return contrast_grade::aa;
+    }
+    if (value >= 3.0F) {
+        return contrast_grade::large_text;
+    }
+    return contrast_grade::fail;
+}
+
+const char *contrast_grade_label(contrast_grade grade) {
+    switch (grade) {
+    case contrast_grade::aaa:
+        return "AAA";
+    case contrast_grade::aa:
+        return "AA";
+    case contrast_grade::large_text:
+        return "AA18";
+    case contrast_grade::fail:
+        return "FAIL";
+    }
+    return "FAIL";
+}
+
+} // namespace palette::services
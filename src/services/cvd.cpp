@@ -0,0 +1,287 @@
+#include "palette/services/cvd.hpp"
+#include "palette/services/color_space.hpp"
+#include "palette/services/color_utils.hpp"
+#include "palette/services/env_utils.hpp"
+#include "palette/services/interaction_context.hpp"
+#include <algorithm>
+#include <array>
+
+namespace palette::services {
+namespace {
+constexpr size_t kBlockSize = 64;
+constexpr size_t kComparisonColumns = 5;
+
+// Row-major 3x3 matrix applied to linear RGB.
+using cvd_matrix = std::array<float, 9>;
+
+// Machado, Oliveira and Fernandes (2009), severity 0.0 to 1.0 in steps of
+// 0.1. Row sums are 1 so neutral grays stay neutral.
+constexpr std::array<cvd_matrix, 11> kProtanMatrices = {{
+    {1.0, 0.0, 0.0,
+     0.0, 1.0, 0.0,
+     0.0, 0.0, 1.0},
+    {0.856167, 0.182038, -0.038205,
+     0.029342, 0.955115, 0.015544,
+     -0.002880, -0.001563, 1.004443},
+    {0.734766, 0.334872, -0.069637,
+     0.051840, 0.919198, 0.028963,
+     -0.004928, -0.004209, 1.009137},
+    {0.630323, 0.465641, -0.095964,
+     0.069181, 0.890046, 0.040773,
+     -0.006308, -0.007724, 1.014032},
+    {0.539009, 0.579343, -0.118352,
+     0.082546, 0.866121, 0.051332,
+     -0.007136, -0.011959, 1.019095},
+    {0.458064, 0.679578, -0.137642,
+     0.092785, 0.846313, 0.060902,
+     -0.007494, -0.016807, 1.024301},
+    {0.385450, 0.769005, -0.154455,
+     0.100526, 0.829802, 0.069673,
+     -0.007442, -0.022190, 1.029632},
+    {0.319627, 0.849633, -0.169261,
+     0.106241, 0.815969, 0.077790,
+     -0.007025, -0.028051, 1.035076},
+    {0.259411, 0.923008, -0.182420,
+     0.110296, 0.804340, 0.085364,
+     -0.006276, -0.034346, 1.040622},
+    {0.203876, 0.990338, -0.194214,
+     0.112975, 0.794542, 0.092483,
+     -0.005222, -0.041043, 1.046265},
+    {0.152286, 1.052583, -0.204868,
+     0.114503, 0.786281, 0.099216,
+     -0.003882, -0.048116, 1.051998},
+}};
+
+constexpr std::array<cvd_matrix, 11> kDeutanMatrices = {{
+    {1.0, 0.0, 0.0,
+     0.0, 1.0, 0.0,
+     0.0, 0.0, 1.0},
+    {0.866435, 0.177704, -0.044139,
+     0.049567, 0.939063, 0.011370,
+     -0.003453, 0.007233, 0.996220},
+    {0.760729, 0.319078, -0.079807,
+     0.090568, 0.889315, 0.020117,
+     -0.006027, 0.013325, 0.992702},
+    {0.675425, 0.433850, -0.109275,
+     0.125303, 0.847755, 0.026942,
+     -0.007950, 0.018572, 0.989378},
+    {0.605511, 0.528560, -0.134071,
+     0.155318, 0.812366, 0.032316,
+     -0.009376, 0.023176, 0.986200},
+    {0.547494, 0.607765, -0.155259,
+     0.181692, 0.781742, 0.036566,
+     -0.010410, 0.027275, 0.983136},
+    {0.498864, 0.674741, -0.173604,
+     0.205199, 0.754872, 0.039929,
+     -0.011131, 0.030969, 0.980162},
+    {0.457771, 0.731899, -0.189670,
+     0.226409, 0.731012, 0.042579,
+     -0.011595, 0.034333, 0.977261},
+    {0.422823, 0.781057, -0.203881,
+     0.245752, 0.709602, 0.044646,
+     -0.011843, 0.037423, 0.974421},
+    {0.392952, 0.823610, -0.216562,
+     0.263559, 0.690210, 0.046232,
+     -0.011910, 0.040281, 0.971630},
+    {0.367322, 0.860646, -0.227968,
+     0.280085, 0.672501, 0.047413,
+     -0.011820, 0.042940, 0.968881},
+}};
+
+constexpr std::array<cvd_matrix, 11> kTritanMatrices = {{
+    {1.0, 0.0, 0.0,
+     0.0, 1.0, 0.0,
+     0.0, 0.0, 1.0},
+    {0.926670, 0.092514, -0.019184,
+     0.021191, 0.964503, 0.014306,
+     0.008437, 0.054813, 0.936750},
+    {0.895720, 0.133330, -0.029050,
+     0.029997, 0.945400, 0.024603,
+     0.013027, 0.104707, 0.882266},
+    {0.905871, 0.127791, -0.033662,
+     0.026856, 0.941251, 0.031893,
+     0.013410, 0.148296, 0.838294},
+    {0.948035, 0.089490, -0.037526,
+     0.014364, 0.946792, 0.038844,
+     0.010853, 0.193991, 0.795156},
+    {1.017277, 0.027029, -0.044306,
+     -0.006113, 0.958479, 0.047634,
+     0.006379, 0.248708, 0.744913},
+    {1.104996, -0.046633, -0.058363,
+     -0.032137, 0.971635, 0.060503,
+     0.001336, 0.317922, 0.680742},
+    {1.193214, -0.109812, -0.083402,
+     -0.058496, 0.979410, 0.079086,
+     -0.002346, 0.403492, 0.598854},
+    {1.257728, -0.139648, -0.118081,
+     -0.078003, 0.975409, 0.102594,
+     -0.003316, 0.501214, 0.502102},
+    {1.278864, -0.125333, -0.153531,
+     -0.084748, 0.957674, 0.127074,
+     -0.000989, 0.601151, 0.399838},
+    {1.255528, -0.076749, -0.178779,
+     -0.078411, 0.930809, 0.147602,
+     0.004733, 0.691367, 0.303900},
+}};
+cvd_matrix matrix_for(const cvd_simulation &simulation) {
+    const auto &table = simulation.type == cvd_type::protan
+                            ? kProtanMatrices
+                            : simulation.type == cvd_type::deutan
+                                  ? kDeutanMatrices
+                                  : kTritanMatrices;
+
+    const int severity = std::clamp(simulation.severity, 0, 100);
+    const size_t low = static_cast<size_t>(severity / 10);
+    if (low + 1 >= table.size()) {
+        return table.back();
+    }
+
+    const float t = static_cast<float>(severity % 10) / 10.0F;
+    cvd_matrix out{};
+    for (size_t i = 0; i < out.size(); ++i) {
+        out[i] = table[low][i] + (table[low + 1][i] - table[low][i]) * t;
+    }
+    return out;
+}
+
+std::vector<std::vector<rgb_color>>
+split_rows(const std::vector<rgb_color> &colors, size_t columns) {
+    std::vector<std::vector<rgb_color>> rows;
+    for (size_t i = 0; i < colors.size(); i += columns) {
+        rows.emplace_back(colors.begin() + static_cast<long>(i),
+                          colors.begin() + static_cast<long>(std::min(
+                                               colors.size(), i + columns)));
+    }
+    return rows;
+}
+} // namespace
+
+cvd_input_result parse_cvd_input(const interaction_context &event) {
+    cvd_input_result result;
+
+    std::string type_name;
+    if (!read_optional_string(event.get_parameter("cvd"), type_name)) {
+        result.ok = true;
+        return result;
+    }
+
+    cvd_simulation simulation;
+    if (!parse_cvd_type(normalize_ascii_lower(type_name), simulation.type)) {
+        result.error =
+            "`cvd` must be one of: protanopia, deuteranopia, tritanopia.";
+        return result;
+    }
+
+    const auto severity_param = event.get_parameter("severity");
+    if (const auto *p = std::get_if<int64_t>(&severity_param)) {
+        if (*p < 1 || *p > 100) {
+            result.error = "`severity` must be an integer from 1 to 100.";
+            return result;
+        }
+        simulation.severity = static_cast<int>(*p);
+    }
+
+    result.simulation = simulation;
+    result.ok = true;
+    return result;
+}
+
+bool parse_cvd_type(std::string_view name, cvd_type &out) {
+    if (name == "protanopia" || name == "protanomaly" || name == "protan") {
+        out = cvd_type::protan;
+        return true;
+    }
+    if (name == "deuteranopia" || name == "deuteranomaly" ||
+        name == "deutan") {
+        out = cvd_type::deutan;
+        return true;
+    }
+    if (name == "tritanopia" || name == "tritanomaly" || name == "tritan") {
+        out = cvd_type::tritan;
+        return true;
+    }
+    return false;
+}
+
+std::string cvd_label(const cvd_simulation &simulation) {
+    const char *stem = simulation.type == cvd_type::protan   ? "Protan"
+                       : simulation.type == cvd_type::deutan ? "Deuteran"
+                                                             : "Tritan";
+    if (simulation.severity >= 100) {
+        return std::string(stem) + "opia";
+    }
+    return std::string(stem) + "omaly " + std::to_string(simulation.severity);
+}
+
+void simulate_cvd(const rgb_color *in, size_t count,
+                  const cvd_simulation &simulation, rgb_color *out) {
+    const cvd_matrix m = matrix_for(simulation);
+    const auto &to_linear = srgb_to_linear_table();
+
+    std::array<float, kBlockSize> r{};
+    std::array<float, kBlockSize> g{};
+    std::array<float, kBlockSize> b{};
+    for (size_t base = 0; base < count; base += kBlockSize) {
+        const size_t n = std::min(kBlockSize, count - base);
+        for (size_t i = 0; i < n; ++i) {
+            r[i] = to_linear[in[base + i].r];
+            g[i] = to_linear[in[base + i].g];
+            b[i] = to_linear[in[base + i].b];
+        }
+
+        // Plain loops over the block so the compiler can vectorize the
+        // matrix product.
+        for (size_t i = 0; i < n; ++i) {
+            const float sr = m[0] * r[i] + m[1] * g[i] + m[2] * b[i];
+            const float sg = m[3] * r[i] + m[4] * g[i] + m[5] * b[i];
+            const float sb = m[6] * r[i] + m[7] * g[i] + m[8] * b[i];
+            r[i] = sr;
+            g[i] = sg;
+            b[i] = sb;
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            out[base + i] = {linear_to_srgb8_fast(r[i]),
+                             linear_to_srgb8_fast(g[i]),
+                             linear_to_srgb8_fast(b[i])};
+        }
+    }
+}
+
+std::vector<std::vector<rgb_color>>
+simulate_cvd_grid(const std::vector<std::vector<rgb_color>> &grid,
+                  const cvd_simulation &simulation) {
+    std::vector<rgb_color> flat;
+    for (const auto &row : grid) {
+        flat.insert(flat.end(), row.begin(), row.end());
+    }
+    simulate_cvd(flat.data(), flat.size(), simulation, flat.data());
+
+    std::vector<std::vector<rgb_color>> out;
+    out.reserve(grid.size());
+    size_t offset = 0;
+    for (const auto &row : grid) {
+        out.emplace_back(flat.begin() + static_cast<long>(offset),
+                         flat.begin() + static_cast<long>(offset + row.size()));
+        offset += row.size();
+    }
+    return out;
+}
+
+std::string generate_cvd_comparison_image(const std::vector<rgb_color> &colors,
+                                          const cvd_simulation &simulation) {
+    return generate_comparison_palette_image(
+        split_rows(colors, kComparisonColumns),
+        simulate_cvd_grid(split_rows(colors, kComparisonColumns), simulation),
+        "Original", cvd_label(simulation), true);
+}
+
+std::string generate_cvd_comparison_image(
+    const std::vector<std::vector<rgb_color>> &grid,
+    const cvd_simulation &simulation) {
+    return generate_comparison_palette_image(
+        grid, simulate_cvd_grid(grid, simulation), "Original",
+        cvd_label(simulation), false);
+}
+
+} // namespace palette::services
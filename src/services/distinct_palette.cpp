@@ -0,0 +1,390 @@
+#include "palette/services/distinct_palette.hpp"
+#include "palette/services/color_space.hpp"
+#include "palette/services/thread_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+
+namespace palette::services {
+namespace {
+// Channel levels of the candidate lattice. The finer lattice is used when
+// the constraints leave too few candidates per requested color.
+constexpr int kCoarseLevels = 32;
+constexpr int kFineLevels = 64;
+constexpr size_t kMinCandidatesPerColor = 256;
+constexpr int kGridCellsPerAxis = 24;
+constexpr size_t kParallelChunk = 4096;
+// Relocation stops after this many moves or this much time, whichever
+// comes first, so large requests stay inside the interaction deadline.
+constexpr int kMaxRelocationsPerColor = 4;
+constexpr auto kRefinementBudget = std::chrono::milliseconds(800);
+
+struct candidate_set {
+    std::vector<rgb_color> colors;
+    std::vector<float> l;
+    std::vector<float> a;
+    std::vector<float> b;
+
+    size_t size() const { return colors.size(); }
+};
+
+float distance_squared(const candidate_set &set, size_t i, size_t j) {
+    const float dl = set.l[i] - set.l[j];
+    const float da = set.a[i] - set.a[j];
+    const float db = set.b[i] - set.b[j];
+    return dl * dl + da * da + db * db;
+}
+
+candidate_set build_candidates(int levels, const distinct_constraints &limits) {
+    std::vector<rgb_color> lattice;
+    lattice.reserve(static_cast<size_t>(levels) * levels * levels);
+    for (int r = 0; r < levels; ++r) {
+        for (int g = 0; g < levels; ++g) {
+            for (int b = 0; b < levels; ++b) {
+                lattice.push_back({static_cast<uint8_t>(r * 255 / (levels - 1)),
+                                   static_cast<uint8_t>(g * 255 / (levels - 1)),
+                                   static_cast<uint8_t>(b * 255 /
+                                                        (levels - 1))});
+            }
+        }
+    }
+
+    std::vector<float> l(lattice.size());
+    std::vector<float> a(lattice.size());
+    std::vector<float> b(lattice.size());
+    rgb_to_oklab_batch(lattice.data(), lattice.size(), l.data(), a.data(),
+                       b.data());
+
+    candidate_set set;
+    const double min_chroma2 = limits.min_chroma * limits.min_chroma;
+    const double max_chroma2 = limits.max_chroma * limits.max_chroma;
+    for (size_t i = 0; i < lattice.size(); ++i) {
+        const double chroma2 = static_cast<double>(a[i]) * a[i] +
+                               static_cast<double>(b[i]) * b[i];
+        if (l[i] < limits.min_lightness || l[i] > limits.max_lightness ||
+            chroma2 < min_chroma2 || chroma2 > max_chroma2) {
+            continue;
+        }
+        set.colors.push_back(lattice[i]);
+        set.l.push_back(l[i]);
+        set.a.push_back(a[i]);
+        set.b.push_back(b[i]);
+    }
+    return set;
+}
+
+// Candidates bucketed by a uniform OKLab grid. Each cell also tracks its
+// candidate farthest from the chosen set, so a new pick only has to touch
+// the cells within its own radius.
+class candidate_grid {
+  public:
+    explicit candidate_grid(const candidate_set &set) : set_(set) {
+        float lo[3] = {set.l[0], set.a[0], set.b[0]};
+        float hi[3] = {lo[0], lo[1], lo[2]};
+        for (size_t i = 1; i < set.size(); ++i) {
+            const float p[3] = {set.l[i], set.a[i], set.b[i]};
+            for (int k = 0; k < 3; ++k) {
+                lo[k] = std::min(lo[k], p[k]);
+                hi[k] = std::max(hi[k], p[k]);
+            }
+        }
+        const float extent =
+            std::max({hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2], 1e-3F});
+        cell_size_ = extent / static_cast<float>(kGridCellsPerAxis);
+        for (int k = 0; k < 3; ++k) {
+            origin_[k] = lo[k];
+            dims_[k] = static_cast<int>((hi[k] - lo[k]) / cell_size_) + 1;
+        }
+
+        const size_t cells =
+            static_cast<size_t>(dims_[0]) * dims_[1] * dims_[2];
+        std::vector<uint32_t> cell_of(set.size());
+        cell_start_.assign(cells + 1, 0);
+        for (size_t i = 0; i < set.size(); ++i) {
+            cell_of[i] = static_cast<uint32_t>(
+                cell_index(axis_cell(0, set.l[i]), axis_cell(1, set.a[i]),
+                           axis_cell(2, set.b[i])));
+            ++cell_start_[cell_of[i] + 1];
+        }
+        for (size_t c = 0; c < cells; ++c) {
+            cell_start_[c + 1] += cell_start_[c];
+        }
+        members_.resize(set.size());
+        std::vector<uint32_t> fill(cell_start_.begin(), cell_start_.end() - 1);
+        for (size_t i = 0; i < set.size(); ++i) {
+            members_[fill[cell_of[i]]++] = static_cast<uint32_t>(i);
+        }
+
+        nearest_.assign(set.size(), std::numeric_limits<float>::max());
+        cell_best_.assign(cells, 0);
+        for (size_t c = 0; c < cells; ++c) {
+            refresh_cell(c);
+        }
+    }
+
+    // Candidate farthest from everything picked so far.
+    size_t farthest(float &distance2) const {
+        size_t best = 0;
+        distance2 = -1.0F;
+        for (size_t c = 0; c < cell_best_.size(); ++c) {
+            if (cell_start_[c] == cell_start_[c + 1]) {
+                continue;
+            }
+            const float d = nearest_[cell_best_[c]];
+            if (d > distance2) {
+                distance2 = d;
+                best = cell_best_[c];
+            }
+        }
+        return best;
+    }
+
+    // Records a pick. No candidate is farther than `radius2` from the
+    // earlier picks, so only cells within that radius can change.
+    void add(size_t pick, float radius2) {
+        int lo[3];
+        int hi[3];
+        const float p[3] = {set_.l[pick], set_.a[pick], set_.b[pick]};
+        const float radius = std::sqrt(radius2);
+        for (int k = 0; k < 3; ++k) {
+            if (!std::isfinite(radius)) {
+                lo[k] = 0;
+                hi[k] = dims_[k] - 1;
+                continue;
+            }
+            lo[k] = axis_cell(k, p[k] - radius);
+            hi[k] = axis_cell(k, p[k] + radius);
+        }
+
+        for (int x = lo[0]; x <= hi[0]; ++x) {
+            for (int y = lo[1]; y <= hi[1]; ++y) {
+                for (int z = lo[2]; z <= hi[2]; ++z) {
+                    const size_t c = cell_index(x, y, z);
+                    bool changed = false;
+                    for (uint32_t m = cell_start_[c]; m < cell_start_[c + 1];
+                         ++m) {
+                        const uint32_t i = members_[m];
+                        const float d = distance_squared(set_, i, pick);
+                        if (d < nearest_[i]) {
+                            nearest_[i] = d;
+                            changed = true;
+                        }
+                    }
+                    if (changed) {
+                        refresh_cell(c);
+                    }
+                }
+            }
+        }
+    }
+
+  private:
+    int axis_cell(int axis, float value) const {
+        const int cell =
+            static_cast<int>((value - origin_[axis]) / cell_size_);
+        return std::clamp(cell, 0, dims_[axis] - 1);
+    }
+
+    size_t cell_index(int x, int y, int z) const {
+        return (static_cast<size_t>(x) * dims_[1] + y) * dims_[2] + z;
+    }
+
+    void refresh_cell(size_t c) {
+        float best = -1.0F;
+        for (uint32_t m = cell_start_[c]; m < cell_start_[c + 1]; ++m) {
+            if (nearest_[members_[m]] > best) {
+                best = nearest_[members_[m]];
+                cell_best_[c] = members_[m];
+            }
+        }
+    }
+
+    const candidate_set &set_;
+    float origin_[3] = {};
+    int dims_[3] = {};
+    float cell_size_ = 1.0F;
+    std::vector<uint32_t> cell_start_;
+    std::vector<uint32_t> members_;
+    std::vector<float> nearest_;
+    std::vector<uint32_t> cell_best_;
+};
+
+std::vector<size_t> farthest_point_sample(const candidate_set &set,
+                                          size_t count) {
+    // Start from the candidate farthest from the centroid, which lands on
+    // the boundary of the allowed region.
+    double center[3] = {};
+    for (size_t i = 0; i < set.size(); ++i) {
+        center[0] += set.l[i];
+        center[1] += set.a[i];
+        center[2] += set.b[i];
+    }
+    for (double &axis : center) {
+        axis /= static_cast<double>(set.size());
+    }
+    size_t first = 0;
+    double first_distance = -1.0;
+    for (size_t i = 0; i < set.size(); ++i) {
+        const double dl = set.l[i] - center[0];
+        const double da = set.a[i] - center[1];
+        const double db = set.b[i] - center[2];
+        const double d = dl * dl + da * da + db * db;
+        if (d > first_distance) {
+            first_distance = d;
+            first = i;
+        }
+    }
+
+    candidate_grid grid(set);
+    std::vector<size_t> picks{first};
+    grid.add(first, std::numeric_limits<float>::infinity());
+    while (picks.size() < count) {
+        float radius2 = 0.0F;
+        const size_t next = grid.farthest(radius2);
+        if (radius2 <= 0.0F) {
+            break;
+        }
+        picks.push_back(next);
+        grid.add(next, radius2);
+    }
+    return picks;
+}
+
+// Distance from candidate `i` to the closest pick other than `skip`.
+// Returns early once it is known to be below `floor`.
+float clearance(const candidate_set &set, const std::vector<size_t> &picks,
+                size_t skip, size_t i, float floor) {
+    float nearest = std::numeric_limits<float>::max();
+    for (size_t p = 0; p < picks.size(); ++p) {
+        if (p == skip) {
+            continue;
+        }
+        nearest = std::min(nearest, distance_squared(set, i, picks[p]));
+        if (nearest <= floor) {
+            break;
+        }
+    }
+    return nearest;
+}
+
+// Moves pick `index` to the candidate with the most clearance from the
+// other picks, if that beats `current`. The candidate scan is the hot path
+// and is split over the pool when there is one.
+bool relocate(const candidate_set &set, std::vector<size_t> &picks,
+              size_t index, float current, thread_pool *pool) {
+    std::mutex best_mutex;
+    float best_distance = current;
+    size_t best = picks[index];
+
+    const auto scan = [&](size_t begin, size_t end) {
+        float local_distance = current;
+        size_t local = std::numeric_limits<size_t>::max();
+        for (size_t i = begin; i < end; ++i) {
+            const float d = clearance(set, picks, index, i, local_distance);
+            if (d > local_distance) {
+                local_distance = d;
+                local = i;
+            }
+        }
+        if (local == std::numeric_limits<size_t>::max()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(best_mutex);
+        if (local_distance > best_distance ||
+            (local_distance == best_distance && local < best)) {
+            best_distance = local_distance;
+            best = local;
+        }
+    };
+
+    if (pool && set.size() > kParallelChunk) {
+        pool->parallel_for(set.size(), kParallelChunk, scan);
+    } else {
+        scan(0, set.size());
+    }
+
+    if (best_distance <= current) {
+        return false;
+    }
+    picks[index] = best;
+    return true;
+}
+
+// Closest pair among the picks, as their positions in `picks`.
+float closest_pair(const candidate_set &set, const std::vector<size_t> &picks,
+                   size_t &first, size_t &second) {
+    float best = std::numeric_limits<float>::max();
+    for (size_t i = 0; i < picks.size(); ++i) {
+        for (size_t j = i + 1; j < picks.size(); ++j) {
+            const float d = distance_squared(set, picks[i], picks[j]);
+            if (d < best) {
+                best = d;
+                first = i;
+                second = j;
+            }
+        }
+    }
+    return best;
+}
+
+void refine(const candidate_set &set, std::vector<size_t> &picks) {
+    if (picks.size() < 3) {
+        return;
+    }
+
+    thread_pool *const pool = thread_pool::current();
+    const auto deadline = std::chrono::steady_clock::now() + kRefinementBudget;
+    const size_t max_moves = picks.size() * kMaxRelocationsPerColor;
+    for (size_t move = 0; move < max_moves; ++move) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            break;
+        }
+        size_t first = 0;
+        size_t second = 0;
+        const float current = closest_pair(set, picks, first, second);
+        // Prefer moving the later pick so the head of the list stays put.
+        if (!relocate(set, picks, second, current, pool) &&
+            !relocate(set, picks, first, current, pool)) {
+            break;
+        }
+    }
+}
+} // namespace
+
+distinct_palette generate_distinct_palette(int count,
+                                           const distinct_constraints &limits) {
+    distinct_palette result;
+    const size_t wanted = static_cast<size_t>(
+        std::clamp(count, kMinDistinctColors, kMaxDistinctColors));
+
+    candidate_set set = build_candidates(kCoarseLevels, limits);
+    if (set.size() < wanted * kMinCandidatesPerColor) {
+        set = build_candidates(kFineLevels, limits);
+    }
+    if (set.size() == 0) {
+        return result;
+    }
+
+    std::vector<size_t> picks =
+        farthest_point_sample(set, std::min(wanted, set.size()));
+    refine(set, picks);
+
+    result.colors.reserve(picks.size());
+    for (const size_t pick : picks) {
+        result.colors.push_back(set.colors[pick]);
+    }
+    if (picks.size() > 1) {
+        size_t first = 0;
+        size_t second = 0;
+        result.min_distance =
+            std::sqrt(static_cast<double>(closest_pair(set, picks, first,
+                                                       second))) *
+            100.0;
+    }
+    return result;
+}
+
+} // namespace palette::services
@@ -0,0 +1,252 @@
+#include "palette/services/gradient.hpp"
+#include "palette/services/color_space.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace palette::services {
+namespace {
+constexpr size_t kBlockSize = 64;
+constexpr float kPi = 3.14159265358979323846F;
+// Below this OKLCH chroma a stop is treated as gray and has no hue of its
+// own ("powerless" hue in CSS terms).
+constexpr double kAchromaticChroma = 1e-4;
+
+// Interpolation endpoints of every segment, one array per channel. OKLCH
+// hues can differ between the end of one segment and the start of the next,
+// so endpoints are stored per segment rather than per stop.
+struct segment_channels {
+    std::array<std::vector<float>, 3> from;
+    std::array<std::vector<float>, 3> to;
+};
+
+std::array<float, 3> convert_stop(rgb_color c, gradient_space space) {
+    const auto &to_linear = srgb_to_linear_table();
+    switch (space) {
+    case gradient_space::srgb:
+        return {c.r / 255.0F, c.g / 255.0F, c.b / 255.0F};
+    case gradient_space::linear:
+        return {to_linear[c.r], to_linear[c.g], to_linear[c.b]};
+    case gradient_space::oklab:
+    case gradient_space::oklch: {
+        const oklab_color lab = rgb_to_oklab(c);
+        return {static_cast<float>(lab.l), static_cast<float>(lab.a),
+                static_cast<float>(lab.b)};
+    }
+    }
+    return {};
+}
+
+// Hue difference from `from` to `to` (degrees) along the chosen path.
+double hue_delta(double from, double to, hue_path path) {
+    double delta = std::fmod(to - from, 360.0);
+    if (delta < 0.0) {
+        delta += 360.0;
+    }
+    switch (path) {
+    case hue_path::shorter:
+        return delta > 180.0 ? delta - 360.0 : delta;
+    case hue_path::longer:
+        // Equal hues go all the way round, as in CSS.
+        if (delta == 0.0) {
+            return 360.0;
+        }
+        return delta < 180.0 ? delta - 360.0 : delta;
+    case hue_path::increasing:
+        return delta;
+    case hue_path::decreasing:
+        return delta > 0.0 ? delta - 360.0 : delta;
+    }
+    return delta;
+}
+
+segment_channels build_segments(const std::vector<rgb_color> &stops,
+                                gradient_space space, hue_path path) {
+    const size_t segments = stops.size() - 1;
+    segment_channels out;
+    for (size_t c = 0; c < 3; ++c) {
+        out.from[c].resize(segments);
+        out.to[c].resize(segments);
+    }
+
+    for (size_t i = 0; i < segments; ++i) {
+        const std::array<float, 3> a = convert_stop(stops[i], space);
+        const std::array<float, 3> b = convert_stop(stops[i + 1], space);
+        if (space != gradient_space::oklch) {
+            for (size_t c = 0; c < 3; ++c) {
+                out.from[c][i] = a[c];
+                out.to[c][i] = b[c];
+            }
+            continue;
+        }
+
+        oklch_color lch_a = oklab_to_oklch({a[0], a[1], a[2]});
+        oklch_color lch_b = oklab_to_oklch({b[0], b[1], b[2]});
+        // A gray endpoint has no hue of its own; it takes the other one so
+        // a fade to white keeps its hue (CSS "powerless" hue).
+        if (lch_a.c < kAchromaticChroma) {
+            lch_a.h = lch_b.h;
+        }
+        if (lch_b.c < kAchromaticChroma) {
+            lch_b.h = lch_a.h;
+        }
+        const double end_hue = lch_a.h + hue_delta(lch_a.h, lch_b.h, path);
+
+        out.from[0][i] = static_cast<float>(lch_a.l);
+        out.from[1][i] = static_cast<float>(lch_a.c);
+        out.from[2][i] = static_cast<float>(lch_a.h * kPi / 180.0);
+        out.to[0][i] = static_cast<float>(lch_b.l);
+        out.to[1][i] = static_cast<float>(lch_b.c);
+        out.to[2][i] = static_cast<float>(end_hue * kPi / 180.0);
+    }
+    return out;
+}
+
+uint8_t encode_unit(float value) {
+    const float clamped = std::clamp(value, 0.0F, 1.0F);
+    return static_cast<uint8_t>(clamped * 255.0F + 0.5F);
+}
+
+// Converts one block of interpolated channels back to sRGB in place.
+void encode_block(gradient_space space, size_t n, float *c0, float *c1,
+                  float *c2, rgb_color *out) {
+    if (space == gradient_space::srgb) {
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = {encode_unit(c0[i]), encode_unit(c1[i]),
+                      encode_unit(c2[i])};
+        }
+        return;
+    }
+
+    if (space == gradient_space::oklch) {
+        for (size_t i = 0; i < n; ++i) {
+            const float chroma = c1[i];
+            c1[i] = chroma * std::cos(c2[i]);
+            c2[i] = chroma * std::sin(c2[i]);
+        }
+    }
+
+    if (space == gradient_space::oklab || space == gradient_space::oklch) {
+        for (size_t i = 0; i < n; ++i) {
+            const float l_ = c0[i] + 0.3963377774F * c1[i] +
+                             0.2158037573F * c2[i];
+            const float m_ = c0[i] - 0.1055613458F * c1[i] -
+                             0.0638541728F * c2[i];
+            const float s_ = c0[i] - 0.0894841775F * c1[i] -
+                             1.2914855480F * c2[i];
+            const float l = l_ * l_ * l_;
+            const float m = m_ * m_ * m_;
+            const float s = s_ * s_ * s_;
+            c0[i] = 4.0767416621F * l - 3.3077115913F * m + 0.2309699292F * s;
+            c1[i] = -1.2684380046F * l + 2.6097574011F * m - 0.3413193965F * s;
+            c2[i] = -0.0041960863F * l - 0.7034186147F * m + 1.7076147010F * s;
+        }
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = {linear_to_srgb8_fast(c0[i]), linear_to_srgb8_fast(c1[i]),
+                  linear_to_srgb8_fast(c2[i])};
+    }
+}
+} // namespace
+
+bool parse_gradient_space(std::string_view name, gradient_space &out) {
+    if (name == "srgb") {
+        out = gradient_space::srgb;
+    } else if (name == "linear") {
+        out = gradient_space::linear;
+    } else if (name == "oklab") {
+        out = gradient_space::oklab;
+    } else if (name == "oklch") {
+        out = gradient_space::oklch;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool parse_hue_path(std::string_view name, hue_path &out) {
+    if (name == "shorter") {
+        out = hue_path::shorter;
+    } else if (name == "longer") {
+        out = hue_path::longer;
+    } else if (name == "increasing") {
+        out = hue_path::increasing;
+    } else if (name == "decreasing") {
+        out = hue_path::decreasing;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char *gradient_space_label(gradient_space space) {
+    switch (space) {
+    case gradient_space::srgb:
+        return "sRGB";
+    case gradient_space::linear:
+        return "linear RGB";
+    case gradient_space::oklab:
+        return "OKLab";
+    case gradient_space::oklch:
+        return "OKLCH";
+    }
+    return "sRGB";
+}
+
+void interpolate_gradient(const std::vector<rgb_color> &stops,
+                          gradient_space space, hue_path path, size_t count,
+                          rgb_color *out) {
+    if (count == 0 || stops.empty()) {
+        return;
+    }
+    if (stops.size() == 1) {
+        std::fill(out, out + count, stops.front());
+        return;
+    }
+
+    const segment_channels segments = build_segments(stops, space, path);
+    const size_t last_segment = stops.size() - 2;
+    const float scale = count > 1 ? static_cast<float>(stops.size() - 1) /
+                                        static_cast<float>(count - 1)
+                                  : 0.0F;
+
+    std::array<std::array<float, kBlockSize>, 3> block{};
+    std::array<uint32_t, kBlockSize> segment{};
+    std::array<float, kBlockSize> t{};
+    for (size_t base = 0; base < count; base += kBlockSize) {
+        const size_t n = std::min(kBlockSize, count - base);
+        for (size_t i = 0; i < n; ++i) {
+            const float position = static_cast<float>(base + i) * scale;
+            segment[i] = static_cast<uint32_t>(
+                std::min(static_cast<size_t>(position), last_segment));
+            t[i] = position - static_cast<float>(segment[i]);
+        }
+        for (size_t c = 0; c < 3; ++c) {
+            const float *from = segments.from[c].data();
+            const float *to = segments.to[c].data();
+            for (size_t i = 0; i < n; ++i) {
+                block[c][i] = from[segment[i]] +
+                              (to[segment[i]] - from[segment[i]]) * t[i];
+            }
+        }
+        encode_block(space, n, block[0].data(), block[1].data(),
+                     block[2].data(), out + base);
+    }
+
+    // Endpoints are exact rather than round-tripped.
+    out[0] = stops.front();
+    if (count > 1) {
+        out[count - 1] = stops.back();
+    }
+}
+
+std::vector<rgb_color> interpolate_gradient(const std::vector<rgb_color> &stops,
+                                            gradient_space space,
+                                            hue_path path, size_t count) {
+    std::vector<rgb_color> out(count);
+    interpolate_gradient(stops, space, path, count, out.data());
+    return out;
+}
+
+} // namespace palette::services
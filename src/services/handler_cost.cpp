@@ -0,0 +1,73 @@
+#include "palette/services/handler_cost.hpp"
+#include <array>
+#include <atomic>
+#include <cstdlib>
+
+namespace palette::services {
+namespace {
+// Gains as in RFC 6298: 1/8 for the mean, 1/4 for the deviation.
+constexpr int64_t kMeanShift = 3;
+constexpr int64_t kDeviationShift = 2;
+constexpr int64_t kDeviationWeight = 4;
+
+// Updates race benignly: two handlers finishing at once may lose one
+// sample, which the smoothing makes up for on the next.
+struct cost_entry {
+    std::atomic<int64_t> mean_us{-1};
+    std::atomic<int64_t> deviation_us{0};
+};
+
+std::array<cost_entry, kMaxTrackedCommands> entries;
+std::atomic<uint64_t> samples{0};
+std::atomic<uint64_t> auto_deferred{0};
+} // namespace
+
+std::chrono::microseconds handler_cost_estimate(size_t command) {
+    if (command >= kMaxTrackedCommands) {
+        return std::chrono::microseconds::zero();
+    }
+    const cost_entry &entry = entries[command];
+    const int64_t mean = entry.mean_us.load(std::memory_order_relaxed);
+    if (mean < 0) {
+        return std::chrono::microseconds::zero();
+    }
+    return std::chrono::microseconds(
+        mean +
+        kDeviationWeight * entry.deviation_us.load(std::memory_order_relaxed));
+}
+
+void record_handler_cost(size_t command,
+                         std::chrono::steady_clock::duration took) {
+    if (command >= kMaxTrackedCommands) {
+        return;
+    }
+    cost_entry &entry = entries[command];
+    const int64_t sample =
+        std::chrono::duration_cast<std::chrono::microseconds>(took).count();
+    const int64_t mean = entry.mean_us.load(std::memory_order_relaxed);
+    if (mean < 0) {
+        entry.mean_us.store(sample, std::memory_order_relaxed);
+        entry.deviation_us.store(sample / 2, std::memory_order_relaxed);
+    } else {
+        const int64_t deviation =
+            entry.deviation_us.load(std::memory_order_relaxed);
+        entry.deviation_us.store(
+            deviation +
+                ((std::llabs(sample - mean) - deviation) >> kDeviationShift),
+            std::memory_order_relaxed);
+        entry.mean_us.store(mean + ((sample - mean) >> kMeanShift),
+                            std::memory_order_relaxed);
+    }
+    samples.fetch_add(1, std::memory_order_relaxed);
+}
+
+void record_auto_defer() {
+    auto_deferred.fetch_add(1, std::memory_order_relaxed);
+}
+
+handler_cost_stats handler_costs() {
+    return {samples.load(std::memory_order_relaxed),
+            auto_deferred.load(std::memory_order_relaxed)};
+}
+
+} // namespace palette::services
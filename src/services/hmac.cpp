@@ -0,0 +1,167 @@
+#include "palette/services/hmac.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace palette::services {
+namespace {
+constexpr size_t kSha256BlockBytes = 64;
+
+constexpr std::array<uint32_t, 64> kRoundConstants = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+uint32_t rotate_right(uint32_t value, int bits) {
+    return (value >> bits) | (value << (32 - bits));
+}
+
+class sha256_state {
+  public:
+    void update(const uint8_t *data, size_t size) {
+        length_ += size;
+        while (size > 0) {
+            const size_t take = std::min(size, kSha256BlockBytes - buffered_);
+            std::memcpy(buffer_.data() + buffered_, data, take);
+            buffered_ += take;
+            data += take;
+            size -= take;
+            if (buffered_ == kSha256BlockBytes) {
+                compress(buffer_.data());
+                buffered_ = 0;
+            }
+        }
+    }
+
+    sha256_digest finish() {
+        const uint64_t bits = length_ * 8;
+        const uint8_t pad = 0x80;
+        update(&pad, 1);
+        const uint8_t zero = 0;
+        while (buffered_ != kSha256BlockBytes - 8) {
+            update(&zero, 1);
+        }
+        uint8_t length_bytes[8];
+        for (int i = 0; i < 8; ++i) {
+            length_bytes[i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+        }
+        update(length_bytes, sizeof(length_bytes));
+
+        sha256_digest digest{};
+        for (size_t i = 0; i < hash_.size(); ++i) {
+            for (size_t b = 0; b < 4; ++b) {
+                digest[i * 4 + b] =
+                    static_cast<uint8_t>(hash_[i] >> (24 - 8 * b));
+            }
+        }
+        return digest;
+    }
+
+  private:
+    void compress(const uint8_t *block) {
+        std::array<uint32_t, 64> w{};
+        for (size_t i = 0; i < 16; ++i) {
+            w[i] = (static_cast<uint32_t>(block[i * 4]) << 24) |
+                   (static_cast<uint32_t>(block[i * 4 + 1]) << 16) |
+                   (static_cast<uint32_t>(block[i * 4 + 2]) << 8) |
+                   static_cast<uint32_t>(block[i * 4 + 3]);
+        }
+        for (size_t i = 16; i < 64; ++i) {
+            const uint32_t s0 = rotate_right(w[i - 15], 7) ^
+                                rotate_right(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            const uint32_t s1 = rotate_right(w[i - 2], 17) ^
+                                rotate_right(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = hash_[0], b = hash_[1], c = hash_[2], d = hash_[3];
+        uint32_t e = hash_[4], f = hash_[5], g = hash_[6], h = hash_[7];
+        for (size_t i = 0; i < 64; ++i) {
+            const uint32_t s1 =
+                rotate_right(e, 6) ^ rotate_right(e, 11) ^ rotate_right(e, 25);
+            const uint32_t choice = (e & f) ^ (~e & g);
+            const uint32_t t1 = h + s1 + choice + kRoundConstants[i] + w[i];
+            const uint32_t s0 =
+                rotate_right(a, 2) ^ rotate_right(a, 13) ^ rotate_right(a, 22);
+            const uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+            const uint32_t t2 = s0 + majority;
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        hash_[0] += a;
+        hash_[1] += b;
+        hash_[2] += c;
+        hash_[3] += d;
+        hash_[4] += e;
+        hash_[5] += f;
+        hash_[6] += g;
+        hash_[7] += h;
+    }
+
+    std::array<uint32_t, 8> hash_ = {0x6a09e667, 0xbb67ae85, 0x3c6ef372,
+                                     0xa54ff53a, 0x510e527f, 0x9b05688c,
+                                     0x1f83d9ab, 0x5be0cd19};
+    std::array<uint8_t, kSha256BlockBytes> buffer_{};
+    size_t buffered_ = 0;
+    uint64_t length_ = 0;
+};
+} // namespace
+
+sha256_digest sha256(const uint8_t *data, size_t size) {
+    sha256_state state;
+    state.update(data, size);
+    return state.finish();
+}
+
+sha256_digest hmac_sha256(std::string_view key, const uint8_t *data,
+                          size_t size) {
+    std::array<uint8_t, kSha256BlockBytes> block_key{};
+    if (key.size() > kSha256BlockBytes) {
+        const sha256_digest hashed = sha256(
+            reinterpret_cast<const uint8_t *>(key.data()), key.size());
+        std::memcpy(block_key.data(), hashed.data(), hashed.size());
+    } else {
+        std::memcpy(block_key.data(), key.data(), key.size());
+    }
+
+    std::array<uint8_t, kSha256BlockBytes> pad{};
+    for (size_t i = 0; i < pad.size(); ++i) {
+        pad[i] = block_key[i] ^ 0x36U;
+    }
+    sha256_state inner;
+    inner.update(pad.data(), pad.size());
+    inner.update(data, size);
+    const sha256_digest inner_digest = inner.finish();
+
+    for (size_t i = 0; i < pad.size(); ++i) {
+        pad[i] = block_key[i] ^ 0x5cU;
+    }
+    sha256_state outer;
+    outer.update(pad.data(), pad.size());
+    outer.update(inner_digest.data(), inner_digest.size());
+    return outer.finish();
+}
+
+bool constant_time_equal(const uint8_t *a, const uint8_t *b, size_t size) {
+    uint8_t difference = 0;
+    for (size_t i = 0; i < size; ++i) {
+        difference |= a[i] ^ b[i];
+    }
+    return difference == 0;
+}
+
+} // namespace palette::services
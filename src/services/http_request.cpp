@@ -0,0 +1,105 @@
+#include "palette/services/http_request.hpp"
+#include "palette/services/thread_pool.hpp"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <utility>
+
+namespace palette::services {
+
+struct pending_request::state {
+    std::mutex mutex;
+    bool done = false;
+    http_result result;
+    std::coroutine_handle<> waiter;
+    // Where the waiter resumes; nullptr resumes it on the D++ thread.
+    thread_pool *executor = nullptr;
+    task_class lane = task_class::render;
+};
+
+namespace {
+std::atomic<uint64_t> completion_count{0};
+std::atomic<uint64_t> completion_total_ns{0};
+std::atomic<uint64_t> completion_max_ns{0};
+
+void record_completion(task_clock::duration elapsed) {
+    const auto ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+            .count());
+    completion_count.fetch_add(1, std::memory_order_relaxed);
+    completion_total_ns.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t seen = completion_max_ns.load(std::memory_order_relaxed);
+    while (ns > seen && !completion_max_ns.compare_exchange_weak(
+                            seen, ns, std::memory_order_relaxed)) {
+    }
+}
+} // namespace
+
+std::string http_result::error() const {
+    return "HTTP " + std::to_string(status);
+}
+
+pending_request::pending_request(std::shared_ptr<state> shared)
+    : state_(std::move(shared)) {}
+
+bool pending_request::await_suspend(std::coroutine_handle<> waiter) {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    if (state_->done) {
+        return false;
+    }
+    state_->waiter = waiter;
+    return true;
+}
+
+http_result pending_request::await_resume() {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return std::move(state_->result);
+}
+
+pending_request start_request(dpp::cluster &bot, const std::string &url,
+                              task_class lane) {
+    auto shared = std::make_shared<pending_request::state>();
+    shared->executor = thread_pool::current();
+    shared->lane = lane;
+    bot.request(url, dpp::http_method::m_get,
+                [shared](const dpp::http_request_completion_t &res) {
+                    const task_clock::time_point started = task_clock::now();
+                    std::coroutine_handle<> waiter;
+                    {
+                        std::lock_guard<std::mutex> lock(shared->mutex);
+                        shared->result.status = res.status;
+                        shared->result.body = res.body;
+                        shared->done = true;
+                        waiter = std::exchange(shared->waiter, nullptr);
+                    }
+                    // The command was admitted when it started, so its
+                    // continuation is queued unbounded. Only a stopping
+                    // pool refuses it; it then runs here, since dropping
+                    // it would leak the suspended frame and never answer.
+                    if (waiter && shared->executor &&
+                        shared->executor->enqueue(
+                            [waiter]() { waiter.resume(); }, shared->lane) ==
+                            admission::accepted) {
+                        waiter = nullptr;
+                    }
+                    if (waiter) {
+                        waiter.resume();
+                    }
+                    record_completion(task_clock::now() - started);
+                });
+    return pending_request(std::move(shared));
+}
+
+http_completion_stats completion_stats() {
+    http_completion_stats out;
+    out.completions = completion_count.load(std::memory_order_relaxed);
+    out.total_ms = static_cast<double>(completion_total_ns.load(
+                       std::memory_order_relaxed)) /
+                   1e6;
+    out.max_ms = static_cast<double>(
+                     completion_max_ns.load(std::memory_order_relaxed)) /
+                 1e6;
+    return out;
+}
+
+} // namespace palette::services
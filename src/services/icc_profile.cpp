@@ -0,0 +1,763 @@
+#include "palette/services/icc_profile.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+
+namespace palette::services {
+namespace {
+constexpr size_t kHeaderSize = 128;
+constexpr size_t kMaxProfileSize = 16 * 1024 * 1024;
+constexpr size_t kMaxClutNodes = 1 << 20;
+constexpr int kInverseIterations = 32;
+constexpr double kD50[3] = {0.9642, 1.0, 0.8249};
+
+uint32_t signature(const char (&text)[5]) {
+    return (static_cast<uint32_t>(static_cast<uint8_t>(text[0])) << 24) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(text[1])) << 16) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(text[2])) << 8) |
+           static_cast<uint32_t>(static_cast<uint8_t>(text[3]));
+}
+
+// Bounds-checked big-endian reads over the profile bytes. Any read past
+// the end marks the reader failed and returns zero.
+class byte_reader {
+  public:
+    explicit byte_reader(std::string_view data) : data_(data) {}
+
+    bool ok() const { return ok_; }
+    size_t size() const { return data_.size(); }
+    void fail() { ok_ = false; }
+
+    bool has(size_t offset, size_t length) const {
+        return offset <= data_.size() && length <= data_.size() - offset;
+    }
+
+    uint8_t u8(size_t offset) {
+        if (!has(offset, 1)) {
+            ok_ = false;
+            return 0;
+        }
+        return static_cast<uint8_t>(data_[offset]);
+    }
+
+    uint16_t u16(size_t offset) {
+        return static_cast<uint16_t>((u8(offset) << 8) | u8(offset + 1));
+    }
+
+    uint32_t u32(size_t offset) {
+        return (static_cast<uint32_t>(u16(offset)) << 16) | u16(offset + 2);
+    }
+
+    double s15f16(size_t offset) {
+        return static_cast<double>(static_cast<int32_t>(u32(offset))) /
+               65536.0;
+    }
+
+  private:
+    std::string_view data_;
+    bool ok_ = true;
+};
+
+struct tag_entry {
+    uint32_t offset = 0;
+    uint32_t size = 0;
+};
+
+double clamp01(double value) { return std::clamp(value, 0.0, 1.0); }
+
+void multiply_matrix(const std::array<double, 12> &m, const double *in,
+                     double *out) {
+    for (int row = 0; row < 3; ++row) {
+        out[row] = m[static_cast<size_t>(row * 3)] * in[0] +
+                   m[static_cast<size_t>(row * 3 + 1)] * in[1] +
+                   m[static_cast<size_t>(row * 3 + 2)] * in[2] +
+                   m[static_cast<size_t>(9 + row)];
+    }
+}
+
+bool invert_3x3(const std::array<double, 9> &m, std::array<double, 9> &out) {
+    const double det = m[0] * (m[4] * m[8] - m[5] * m[7]) -
+                       m[1] * (m[3] * m[8] - m[5] * m[6]) +
+                       m[2] * (m[3] * m[7] - m[4] * m[6]);
+    if (std::abs(det) < 1e-12) {
+        return false;
+    }
+    const double inv = 1.0 / det;
+    out = {(m[4] * m[8] - m[5] * m[7]) * inv,
+           (m[2] * m[7] - m[1] * m[8]) * inv,
+           (m[1] * m[5] - m[2] * m[4]) * inv,
+           (m[5] * m[6] - m[3] * m[8]) * inv,
+           (m[0] * m[8] - m[2] * m[6]) * inv,
+           (m[2] * m[3] - m[0] * m[5]) * inv,
+           (m[3] * m[7] - m[4] * m[6]) * inv,
+           (m[1] * m[6] - m[0] * m[7]) * inv,
+           (m[0] * m[4] - m[1] * m[3]) * inv};
+    return true;
+}
+
+double lab_f(double t) {
+    constexpr double epsilon = 216.0 / 24389.0;
+    constexpr double kappa = 24389.0 / 27.0;
+    return t > epsilon ? std::cbrt(t) : (kappa * t + 16.0) / 116.0;
+}
+
+double lab_f_inverse(double t) {
+    constexpr double kappa = 24389.0 / 27.0;
+    const double cube = t * t * t;
+    return cube > 216.0 / 24389.0 ? cube : (116.0 * t - 16.0) / kappa;
+}
+
+void xyz_to_lab(const double xyz[3], double lab[3]) {
+    const double fx = lab_f(xyz[0] / kD50[0]);
+    const double fy = lab_f(xyz[1] / kD50[1]);
+    const double fz = lab_f(xyz[2] / kD50[2]);
+    lab[0] = 116.0 * fy - 16.0;
+    lab[1] = 500.0 * (fx - fy);
+    lab[2] = 200.0 * (fy - fz);
+}
+
+void lab_to_xyz(const double lab[3], double xyz[3]) {
+    const double fy = (lab[0] + 16.0) / 116.0;
+    xyz[0] = kD50[0] * lab_f_inverse(fy + lab[1] / 500.0);
+    xyz[1] = kD50[1] * lab_f_inverse(fy);
+    xyz[2] = kD50[2] * lab_f_inverse(fy - lab[2] / 200.0);
+}
+
+// Normalized PCS values of a LUT pipeline to and from D50 XYZ. XYZ uses
+// u1Fixed15 (1.0 at 0x8000); legacy Lab is the v2 16-bit encoding where
+// 0xFF00 is the top of the range.
+void decode_pcs(icc_pcs_encoding encoding, const double *in, double xyz[3]) {
+    if (encoding == icc_pcs_encoding::xyz) {
+        for (int i = 0; i < 3; ++i) {
+            xyz[i] = in[i] * 65535.0 / 32768.0;
+        }
+        return;
+    }
+    const double scale =
+        encoding == icc_pcs_encoding::lab_legacy ? 65535.0 / 65280.0 : 1.0;
+    const double lab[3] = {in[0] * scale * 100.0,
+                           in[1] * scale * 255.0 - 128.0,
+                           in[2] * scale * 255.0 - 128.0};
+    lab_to_xyz(lab, xyz);
+}
+
+void encode_pcs(icc_pcs_encoding encoding, const double xyz[3], double *out) {
+    if (encoding == icc_pcs_encoding::xyz) {
+        for (int i = 0; i < 3; ++i) {
+            out[i] = clamp01(xyz[i] * 32768.0 / 65535.0);
+        }
+        return;
+    }
+    const double scale =
+        encoding == icc_pcs_encoding::lab_legacy ? 65280.0 / 65535.0 : 1.0;
+    double lab[3];
+    xyz_to_lab(xyz, lab);
+    out[0] = clamp01(lab[0] / 100.0 * scale);
+    out[1] = clamp01((lab[1] + 128.0) / 255.0 * scale);
+    out[2] = clamp01((lab[2] + 128.0) / 255.0 * scale);
+}
+
+void apply_curves(const std::vector<icc_curve> &curves, double *values) {
+    for (size_t i = 0; i < curves.size(); ++i) {
+        values[i] = curves[i].evaluate(clamp01(values[i]));
+    }
+}
+
+// Reads a curv or para element at `offset`; `consumed` is its size
+// rounded up to the 4-byte alignment used inside lutAtoB/lutBtoA.
+bool parse_curve(byte_reader &in, size_t offset, icc_curve &out,
+                 size_t &consumed) {
+    const uint32_t type = in.u32(offset);
+    if (type == signature("curv")) {
+        const uint32_t count = in.u32(offset + 8);
+        if (!in.has(offset + 12, static_cast<size_t>(count) * 2)) {
+            return false;
+        }
+        consumed = 12 + static_cast<size_t>(count) * 2;
+        if (count == 0) {
+            out.type = icc_curve::kind::identity;
+        } else if (count == 1) {
+            out.type = icc_curve::kind::gamma;
+            out.params[0] = in.u16(offset + 12) / 256.0;
+        } else {
+            out.type = icc_curve::kind::table;
+            out.samples.resize(count);
+            for (uint32_t i = 0; i < count; ++i) {
+                out.samples[i] = in.u16(offset + 12 + i * 2) / 65535.0;
+            }
+        }
+    } else if (type == signature("para")) {
+        static constexpr int kParamCounts[5] = {1, 3, 4, 5, 7};
+        const uint16_t function = in.u16(offset + 8);
+        if (function > 4) {
+            return false;
+        }
+        out.type = icc_curve::kind::parametric;
+        out.function = function;
+        for (int i = 0; i < kParamCounts[function]; ++i) {
+            out.params[static_cast<size_t>(i)] =
+                in.s15f16(offset + 12 + static_cast<size_t>(i) * 4);
+        }
+        consumed = 12 + static_cast<size_t>(kParamCounts[function]) * 4;
+    } else {
+        return false;
+    }
+    consumed = (consumed + 3) & ~size_t{3};
+    return in.ok();
+}
+
+bool parse_curve_set(byte_reader &in, size_t offset, int count,
+                     std::vector<icc_curve> &out) {
+    out.resize(static_cast<size_t>(count));
+    for (icc_curve &curve : out) {
+        size_t consumed = 0;
+        if (!parse_curve(in, offset, curve, consumed)) {
+            return false;
+        }
+        offset += consumed;
+    }
+    return true;
+}
+
+// Node values of a CLUT with `bytes` per sample, normalized to [0, 1].
+bool read_clut_values(byte_reader &in, size_t offset, int bytes,
+                      icc_clut &clut) {
+    size_t nodes = 1;
+    for (int i = 0; i < clut.inputs; ++i) {
+        const int points = clut.grid[static_cast<size_t>(i)];
+        if (points < 2) {
+            return false;
+        }
+        nodes *= static_cast<size_t>(points);
+        if (nodes > kMaxClutNodes) {
+            return false;
+        }
+    }
+    const size_t count = nodes * static_cast<size_t>(clut.outputs);
+    if (!in.has(offset, count * static_cast<size_t>(bytes))) {
+        return false;
+    }
+    clut.values.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        clut.values[i] =
+            bytes == 1 ? static_cast<float>(in.u8(offset + i) / 255.0)
+                       : static_cast<float>(in.u16(offset + i * 2) / 65535.0);
+    }
+    return true;
+}
+
+// Sampled tables of a lut8/lut16 tag, one per channel.
+bool read_lut_tables(byte_reader &in, size_t offset, int channels,
+                     size_t entries, int bytes, std::vector<icc_curve> &out,
+                     size_t &consumed) {
+    if (entries < 2 || !in.has(offset, static_cast<size_t>(channels) *
+                                           entries *
+                                           static_cast<size_t>(bytes))) {
+        return false;
+    }
+    out.resize(static_cast<size_t>(channels));
+    for (icc_curve &curve : out) {
+        curve.type = icc_curve::kind::table;
+        curve.samples.resize(entries);
+        for (size_t i = 0; i < entries; ++i) {
+            curve.samples[i] = bytes == 1 ? in.u8(offset) / 255.0
+                                          : in.u16(offset) / 65535.0;
+            offset += static_cast<size_t>(bytes);
+        }
+    }
+    consumed = static_cast<size_t>(channels) * entries *
+               static_cast<size_t>(bytes);
+    return true;
+}
+
+bool parse_lut_tag(byte_reader &in, const tag_entry &tag, bool to_pcs,
+                   bool pcs_is_xyz, icc_lut &out) {
+    const size_t base = tag.offset;
+    const uint32_t type = in.u32(base);
+    out.inputs = in.u8(base + 8);
+    out.outputs = in.u8(base + 9);
+    const int device_channels = to_pcs ? out.inputs : out.outputs;
+    const int pcs_channels = to_pcs ? out.outputs : out.inputs;
+    if (pcs_channels != 3 || device_channels < 1 ||
+        device_channels > static_cast<int>(icc_clut{}.grid.size())) {
+        return false;
+    }
+
+    if (type == signature("mft1") || type == signature("mft2")) {
+        const bool lut16 = type == signature("mft2");
+        const int bytes = lut16 ? 2 : 1;
+        out.encoding = pcs_is_xyz ? icc_pcs_encoding::xyz
+                                  : (lut16 ? icc_pcs_encoding::lab_legacy
+                                           : icc_pcs_encoding::lab);
+        const int points = in.u8(base + 10);
+        // The matrix only applies when the input is PCS XYZ.
+        if (!to_pcs && pcs_is_xyz) {
+            out.has_matrix1 = true;
+            for (size_t i = 0; i < 9; ++i) {
+                out.matrix1[i] = in.s15f16(base + 12 + i * 4);
+            }
+        }
+
+        size_t offset = base + 48;
+        size_t input_entries = 256;
+        size_t output_entries = 256;
+        if (lut16) {
+            input_entries = in.u16(offset);
+            output_entries = in.u16(offset + 2);
+            offset += 4;
+        }
+        size_t consumed = 0;
+        if (!read_lut_tables(in, offset, out.inputs, input_entries, bytes,
+                             out.curves2, consumed)) {
+            return false;
+        }
+        offset += consumed;
+
+        out.clut.inputs = out.inputs;
+        out.clut.outputs = out.outputs;
+        std::fill(out.clut.grid.begin(), out.clut.grid.end(), points);
+        if (!read_clut_values(in, offset, bytes, out.clut)) {
+            return false;
+        }
+        offset += out.clut.values.size() * static_cast<size_t>(bytes);
+        return read_lut_tables(in, offset, out.outputs, output_entries, bytes,
+                               out.curves3, consumed) &&
+               in.ok();
+    }
+
+    if (type != signature("mAB ") && type != signature("mBA ")) {
+        return false;
+    }
+    const bool a_to_b = type == signature("mAB ");
+    if (a_to_b != to_pcs) {
+        return false;
+    }
+    out.encoding =
+        pcs_is_xyz ? icc_pcs_encoding::xyz : icc_pcs_encoding::lab;
+    const uint32_t b_offset = in.u32(base + 12);
+    const uint32_t matrix_offset = in.u32(base + 16);
+    const uint32_t m_offset = in.u32(base + 20);
+    const uint32_t clut_offset = in.u32(base + 24);
+    const uint32_t a_offset = in.u32(base + 28);
+
+    // lutAtoB: A, CLUT, M, matrix, B. lutBtoA: B, matrix, M, CLUT, A.
+    std::vector<icc_curve> &b_curves = a_to_b ? out.curves4 : out.curves1;
+    std::vector<icc_curve> &m_curves = a_to_b ? out.curves3 : out.curves2;
+    std::vector<icc_curve> &a_curves = a_to_b ? out.curves2 : out.curves3;
+    std::array<double, 12> &matrix = a_to_b ? out.matrix2 : out.matrix1;
+    bool &has_matrix = a_to_b ? out.has_matrix2 : out.has_matrix1;
+
+    if (b_offset == 0 ||
+        !parse_curve_set(in, base + b_offset, 3, b_curves)) {
+        return false;
+    }
+    if (m_offset != 0 && !parse_curve_set(in, base + m_offset, 3, m_curves)) {
+        return false;
+    }
+    if (matrix_offset != 0) {
+        has_matrix = true;
+        for (size_t i = 0; i < 12; ++i) {
+            matrix[i] = in.s15f16(base + matrix_offset + i * 4);
+        }
+    }
+    if (a_offset != 0 &&
+        !parse_curve_set(in, base + a_offset, device_channels, a_curves)) {
+        return false;
+    }
+    if (clut_offset != 0) {
+        const size_t clut_base = base + clut_offset;
+        out.clut.inputs = out.inputs;
+        out.clut.outputs = out.outputs;
+        for (int i = 0; i < out.inputs; ++i) {
+            out.clut.grid[static_cast<size_t>(i)] =
+                in.u8(clut_base + static_cast<size_t>(i));
+        }
+        const int precision = in.u8(clut_base + 16);
+        if ((precision != 1 && precision != 2) ||
+            !read_clut_values(in, clut_base + 20, precision, out.clut)) {
+            return false;
+        }
+    } else if (out.inputs != out.outputs) {
+        return false;
+    }
+    return in.ok();
+}
+
+bool parse_xyz_tag(byte_reader &in, const tag_entry &tag, double out[3]) {
+    if (in.u32(tag.offset) != signature("XYZ ")) {
+        return false;
+    }
+    for (size_t i = 0; i < 3; ++i) {
+        out[i] = in.s15f16(tag.offset + 8 + i * 4);
+    }
+    return in.ok();
+}
+
+std::string parse_description(byte_reader &in, const tag_entry &tag) {
+    std::string out;
+    const uint32_t type = in.u32(tag.offset);
+    if (type == signature("desc")) {
+        const uint32_t length = in.u32(tag.offset + 8);
+        for (uint32_t i = 0; i < length && i < 256; ++i) {
+            const char c = static_cast<char>(in.u8(tag.offset + 12 + i));
+            if (c == '\0') {
+                break;
+            }
+            out.push_back(c);
+        }
+    } else if (type == signature("mluc") && in.u32(tag.offset + 8) > 0) {
+        // First record only; non-ASCII code units become '?'.
+        const uint32_t length = in.u32(tag.offset + 20);
+        const uint32_t offset = in.u32(tag.offset + 24);
+        for (uint32_t i = 0; i + 1 < length && i < 512; i += 2) {
+            const uint16_t unit = in.u16(tag.offset + offset + i);
+            if (unit == 0) {
+                break;
+            }
+            out.push_back(unit < 0x80 ? static_cast<char>(unit) : '?');
+        }
+    }
+    return in.ok() ? out : std::string();
+}
+
+uint64_t fnv1a(std::string_view data) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (const char c : data) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+icc_curve srgb_trc() {
+    icc_curve curve;
+    curve.type = icc_curve::kind::parametric;
+    curve.function = 3;
+    curve.params = {2.4, 1.0 / 1.055, 0.055 / 1.055, 1.0 / 12.92, 0.04045};
+    return curve;
+}
+
+// Matrix/TRC profile with the sRGB transfer curve. Columns are the
+// D50-adapted red, green and blue colorants.
+std::shared_ptr<const icc_profile>
+make_builtin_profile(const char *name, const std::array<double, 9> &matrix) {
+    auto profile = std::make_shared<icc_profile>();
+    profile->name = name;
+    profile->space = icc_device_space::rgb;
+    profile->hash = fnv1a(name);
+    profile->has_matrix_trc = true;
+    profile->matrix = matrix;
+    invert_3x3(profile->matrix, profile->inverse_matrix);
+    profile->trc = {srgb_trc(), srgb_trc(), srgb_trc()};
+    return profile;
+}
+} // namespace
+
+double icc_curve::evaluate(double x) const {
+    switch (type) {
+    case kind::identity:
+        return x;
+    case kind::gamma:
+        return std::pow(x, params[0]);
+    case kind::table: {
+        const double position = x * static_cast<double>(samples.size() - 1);
+        const size_t index = std::min(static_cast<size_t>(position),
+                                      samples.size() - 2);
+        const double t = position - static_cast<double>(index);
+        return samples[index] + (samples[index + 1] - samples[index]) * t;
+    }
+    case kind::parametric: {
+        const double g = params[0];
+        const double a = params[1];
+        const double b = params[2];
+        const double c = params[3];
+        const double d = params[4];
+        const auto power = [&](double base) {
+            return base > 0.0 ? std::pow(base, g) : 0.0;
+        };
+        switch (function) {
+        case 0:
+            return power(x);
+        case 1:
+            return x >= -b / a ? power(a * x + b) : 0.0;
+        case 2:
+            return x >= -b / a ? power(a * x + b) + c : c;
+        case 3:
+            return x >= d ? power(a * x + b) : c * x;
+        default:
+            return x >= d ? power(a * x + b) + params[5] : c * x + params[6];
+        }
+    }
+    }
+    return x;
+}
+
+double icc_curve::invert(double y) const {
+    if (type == kind::identity) {
+        return y;
+    }
+    const bool rising = evaluate(1.0) >= evaluate(0.0);
+    double low = 0.0;
+    double high = 1.0;
+    for (int i = 0; i < kInverseIterations; ++i) {
+        const double mid = (low + high) / 2.0;
+        if ((evaluate(mid) < y) == rising) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    return (low + high) / 2.0;
+}
+
+void icc_clut::evaluate(const double *in, double *out) const {
+    std::array<size_t, 8> base{};
+    std::array<double, 8> fraction{};
+    std::array<size_t, 8> stride{};
+    size_t step = static_cast<size_t>(outputs);
+    for (int i = inputs - 1; i >= 0; --i) {
+        const size_t axis = static_cast<size_t>(i);
+        const int points = grid[axis];
+        const double position = clamp01(in[i]) * (points - 1);
+        base[axis] = std::min(static_cast<size_t>(position),
+                              static_cast<size_t>(points - 2));
+        fraction[axis] = position - static_cast<double>(base[axis]);
+        stride[axis] = step;
+        step *= static_cast<size_t>(points);
+    }
+
+    size_t origin = 0;
+    for (int i = 0; i < inputs; ++i) {
+        origin += base[static_cast<size_t>(i)] * stride[static_cast<size_t>(i)];
+    }
+    std::fill(out, out + outputs, 0.0);
+    // Multilinear blend of the 2^inputs surrounding nodes. Only used while
+    // compiling transforms, so clarity wins over speed here.
+    for (unsigned corner = 0; corner < (1U << inputs); ++corner) {
+        double weight = 1.0;
+        size_t offset = origin;
+        for (int i = 0; i < inputs; ++i) {
+            const size_t axis = static_cast<size_t>(i);
+            if (corner & (1U << i)) {
+                weight *= fraction[axis];
+                offset += stride[axis];
+            } else {
+                weight *= 1.0 - fraction[axis];
+            }
+        }
+        if (weight == 0.0) {
+            continue;
+        }
+        for (int o = 0; o < outputs; ++o) {
+            out[o] += weight * values[offset + static_cast<size_t>(o)];
+        }
+    }
+}
+
+void icc_lut::evaluate(const double *in, double *out) const {
+    std::array<double, 8> values{};
+    std::copy(in, in + inputs, values.begin());
+    apply_curves(curves1, values.data());
+    if (has_matrix1) {
+        double mixed[3];
+        multiply_matrix(matrix1, values.data(), mixed);
+        std::copy(mixed, mixed + 3, values.begin());
+    }
+    apply_curves(curves2, values.data());
+    if (!clut.values.empty()) {
+        std::array<double, 8> looked_up{};
+        clut.evaluate(values.data(), looked_up.data());
+        values = looked_up;
+    }
+    apply_curves(curves3, values.data());
+    if (has_matrix2) {
+        double mixed[3];
+        multiply_matrix(matrix2, values.data(), mixed);
+        std::copy(mixed, mixed + 3, values.begin());
+    }
+    apply_curves(curves4, values.data());
+    for (int i = 0; i < outputs; ++i) {
+        out[i] = clamp01(values[static_cast<size_t>(i)]);
+    }
+}
+
+int icc_channel_count(icc_device_space space) {
+    return space == icc_device_space::cmyk ? 4 : 3;
+}
+
+std::shared_ptr<const icc_profile> parse_icc_profile(std::string_view data,
+                                                     std::string &error) {
+    byte_reader in(data);
+    if (data.size() < kHeaderSize + 4 || data.size() > kMaxProfileSize ||
+        in.u32(36) != signature("acsp")) {
+        error = "Not an ICC profile.";
+        return nullptr;
+    }
+    const uint8_t major = in.u8(8);
+    if (major != 2 && major != 4) {
+        error = "Only ICC v2 and v4 profiles are supported.";
+        return nullptr;
+    }
+
+    auto profile = std::make_shared<icc_profile>();
+    const uint32_t space = in.u32(16);
+    if (space == signature("RGB ")) {
+        profile->space = icc_device_space::rgb;
+    } else if (space == signature("CMYK")) {
+        profile->space = icc_device_space::cmyk;
+    } else {
+        error = "Only RGB and CMYK profiles are supported.";
+        return nullptr;
+    }
+    const uint32_t pcs = in.u32(20);
+    if (pcs != signature("XYZ ") && pcs != signature("Lab ")) {
+        error = "Unknown profile connection space.";
+        return nullptr;
+    }
+    const bool pcs_is_xyz = pcs == signature("XYZ ");
+
+    const auto find_tag = [&](const char(&name)[5], tag_entry &out) {
+        const uint32_t wanted = signature(name);
+        const uint32_t count = in.u32(kHeaderSize);
+        for (uint32_t i = 0; i < count && in.ok(); ++i) {
+            const size_t entry = kHeaderSize + 4 + static_cast<size_t>(i) * 12;
+            if (in.u32(entry) != wanted) {
+                continue;
+            }
+            out.offset = in.u32(entry + 4);
+            out.size = in.u32(entry + 8);
+            return in.has(out.offset, out.size) && out.size >= 12;
+        }
+        return false;
+    };
+
+    tag_entry tag;
+    const int channels = icc_channel_count(profile->space);
+    if (find_tag("A2B1", tag) || find_tag("A2B0", tag)) {
+        profile->has_a2b = parse_lut_tag(in, tag, true, pcs_is_xyz,
+                                         profile->a2b) &&
+                           profile->a2b.inputs == channels;
+        if (!profile->has_a2b) {
+            error = "Unsupported or malformed A2B tag.";
+            return nullptr;
+        }
+    }
+    if (find_tag("B2A1", tag) || find_tag("B2A0", tag)) {
+        profile->has_b2a = parse_lut_tag(in, tag, false, pcs_is_xyz,
+                                         profile->b2a) &&
+                           profile->b2a.outputs == channels;
+        if (!profile->has_b2a) {
+            error = "Unsupported or malformed B2A tag.";
+            return nullptr;
+        }
+    }
+
+    if (profile->space == icc_device_space::rgb) {
+        static constexpr const char kColorants[3][5] = {"rXYZ", "gXYZ",
+                                                        "bXYZ"};
+        static constexpr const char kCurves[3][5] = {"rTRC", "gTRC", "bTRC"};
+        bool complete = true;
+        for (size_t i = 0; i < 3 && complete; ++i) {
+            double colorant[3];
+            size_t consumed = 0;
+            complete = find_tag(kColorants[i], tag) &&
+                       parse_xyz_tag(in, tag, colorant) &&
+                       find_tag(kCurves[i], tag) &&
+                       parse_curve(in, tag.offset, profile->trc[i], consumed);
+            for (size_t row = 0; row < 3 && complete; ++row) {
+                profile->matrix[row * 3 + i] = colorant[row];
+            }
+        }
+        profile->has_matrix_trc =
+            complete && invert_3x3(profile->matrix, profile->inverse_matrix);
+    }
+
+    if (!profile->has_a2b && !profile->has_matrix_trc) {
+        error = "The profile has no device-to-PCS transform.";
+        return nullptr;
+    }
+    if (find_tag("desc", tag)) {
+        profile->name = parse_description(in, tag);
+    }
+    if (profile->name.empty()) {
+        profile->name = "Unnamed profile";
+    }
+    profile->hash = fnv1a(data);
+    return profile;
+}
+
+std::shared_ptr<const icc_profile> load_icc_profile(const std::string &path,
+                                                    std::string &error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "Could not open " + path + ".";
+        return nullptr;
+    }
+    const std::string data((std::istreambuf_iterator<char>(file)),
+                           std::istreambuf_iterator<char>());
+    return parse_icc_profile(data, error);
+}
+
+const std::shared_ptr<const icc_profile> &srgb_icc_profile() {
+    static const std::shared_ptr<const icc_profile> profile =
+        make_builtin_profile("sRGB IEC61966-2.1",
+                             {0.4360747, 0.3850649, 0.1430804, 0.2225045,
+                              0.7168786, 0.0606169, 0.0139322, 0.0971045,
+                              0.7141733});
+    return profile;
+}
+
+const std::shared_ptr<const icc_profile> &display_p3_icc_profile() {
+    static const std::shared_ptr<const icc_profile> profile =
+        make_builtin_profile("Display P3",
+                             {0.515121, 0.291977, 0.157104, 0.241196,
+                              0.692245, 0.066574, -0.001053, 0.041885,
+                              0.784073});
+    return profile;
+}
+
+void icc_device_to_pcs(const icc_profile &profile, const double *device,
+                       double xyz[3]) {
+    if (profile.has_a2b) {
+        double pcs[3];
+        profile.a2b.evaluate(device, pcs);
+        decode_pcs(profile.a2b.encoding, pcs, xyz);
+        return;
+    }
+    double linear[3];
+    for (size_t i = 0; i < 3; ++i) {
+        linear[i] = profile.trc[i].evaluate(clamp01(device[i]));
+    }
+    for (size_t row = 0; row < 3; ++row) {
+        xyz[row] = profile.matrix[row * 3] * linear[0] +
+                   profile.matrix[row * 3 + 1] * linear[1] +
+                   profile.matrix[row * 3 + 2] * linear[2];
+    }
+}
+
+bool icc_pcs_to_device(const icc_profile &profile, const double xyz[3],
+                       double *device) {
+    if (profile.has_b2a) {
+        double pcs[3];
+        encode_pcs(profile.b2a.encoding, xyz, pcs);
+        profile.b2a.evaluate(pcs, device);
+        return true;
+    }
+    if (!profile.has_matrix_trc) {
+        return false;
+    }
+    for (size_t row = 0; row < 3; ++row) {
+        const double linear = profile.inverse_matrix[row * 3] * xyz[0] +
+                              profile.inverse_matrix[row * 3 + 1] * xyz[1] +
+                              profile.inverse_matrix[row * 3 + 2] * xyz[2];
+        device[row] = profile.trc[row].invert(clamp01(linear));
+    }
+    return true;
+}
+
+bool icc_profile_is_output_capable(const icc_profile &profile) {
+    return profile.has_b2a || profile.has_matrix_trc;
+}
+
+} // namespace palette::services
@@ -0,0 +1,41 @@
+#include "palette/services/image_decode.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace palette::services {
+
+int sample_stride(int width, int height, size_t max_samples) {
+    if (width <= 0 || height <= 0 || max_samples == 0) {
+        return 1;
+    }
+
+    const double pixels =
+        static_cast<double>(width) * static_cast<double>(height);
+    const double ratio = pixels / static_cast<double>(max_samples);
+    if (ratio <= 1.0) {
+        return 1;
+    }
+    return std::max(1, static_cast<int>(std::ceil(std::sqrt(ratio))));
+}
+
+image_sample_result sample_image_pixels(std::string_view data,
+                                        size_t max_samples) {
+    static constexpr unsigned char kPngSignature[8] = {137, 80, 78, 71,
+                                                       13,  10, 26, 10};
+    if (data.size() >= 8 &&
+        std::equal(data.begin(), data.begin() + 8,
+                   reinterpret_cast<const char *>(kPngSignature))) {
+        return sample_png_pixels(data, max_samples);
+    }
+    if (data.size() >= 3 && static_cast<uint8_t>(data[0]) == 0xFF &&
+        static_cast<uint8_t>(data[1]) == 0xD8 &&
+        static_cast<uint8_t>(data[2]) == 0xFF) {
+        return sample_jpeg_pixels(data, max_samples);
+    }
+
+    image_sample_result result;
+    result.error = "Unsupported image format. Upload a PNG or JPEG.";
+    return result;
+}
+
+} // namespace palette::services
@@ -0,0 +1,264 @@
+#include "palette/services/interaction_context.hpp"
+#include "palette/services/interaction_deadline.hpp"
+#include <stdexcept>
+#include <vector>
+
+namespace palette::services {
+namespace {
+// Position of the option in the schema, or the schema's size.
+size_t schema_index(std::span<const option_spec> schema,
+                    std::string_view name) {
+    size_t index = 0;
+    while (index < schema.size() && schema[index].name != name) {
+        ++index;
+    }
+    return index;
+}
+
+void decode_options(const std::vector<dpp::command_data_option> &source,
+                    std::span<const option_spec> schema,
+                    std::array<dpp::command_value, kMaxCommandOptions> &out) {
+    for (const dpp::command_data_option &option : source) {
+        const size_t index = schema_index(schema, option.name);
+        if (index < schema.size()) {
+            out[index] = option.value;
+        }
+        decode_options(option.options, schema, out);
+    }
+}
+} // namespace
+
+interaction_context::interaction_context(
+    dpp::cluster &bot, const dpp::slashcommand_t &event,
+    const command_spec &spec, std::span<const response_decorator> decorators)
+    : id(event.command.id), channel_id(event.command.channel_id),
+      guild_id(event.command.guild_id), user_id(event.command.usr.id),
+      token(event.command.token),
+      command_name(event.command.get_command_name()),
+      response_deadline(interaction_response_deadline(event.command)),
+      bot_(&bot),
+      schema_(spec.options), attachments_(event.command.resolved.attachments) {
+    decode_options(event.command.get_command_interaction().options, schema_,
+                   values_);
+    for (const response_decorator decorator : decorators) {
+        if (decorator_count_ < decorators_.size()) {
+            decorators_[decorator_count_++] = decorator;
+        }
+    }
+    if (spec.single_color_input) {
+        color = parse_single_color_input(*this);
+    }
+}
+
+const dpp::command_value &
+interaction_context::get_parameter(std::string_view name) const {
+    static const dpp::command_value missing;
+    const size_t index = schema_index(schema_, name);
+    return index < schema_.size() ? values_[index] : missing;
+}
+
+const dpp::attachment &
+interaction_context::get_resolved_attachment(dpp::snowflake id) const {
+    const auto it = attachments_.find(id);
+    if (it == attachments_.end()) {
+        throw std::out_of_range("attachment not resolved");
+    }
+    return it->second;
+}
+
+void interaction_context::reply(
+    const std::string &text, dpp::command_completion_event_t callback) const {
+    reply(dpp::ir_channel_message_with_source, dpp::message(channel_id, text),
+          std::move(callback));
+}
+
+void interaction_context::reply(
+    const dpp::message &msg, dpp::command_completion_event_t callback) const {
+    reply(dpp::ir_channel_message_with_source, msg, std::move(callback));
+}
+
+void interaction_context::reply(
+    dpp::interaction_response_type type, const dpp::message &msg,
+    dpp::command_completion_event_t callback) const {
+    bool after_deferral = false;
+    {
+        std::lock_guard<std::mutex> lock(response_mutex_);
+        if (response_ == response_state::deferring) {
+            held_.push_back({msg, std::move(callback)});
+            return;
+        }
+        after_deferral = response_ == response_state::deferred;
+        if (response_ == response_state::none) {
+            response_ = response_state::answered;
+        }
+    }
+    if (after_deferral) {
+        answer_deferred(msg, std::move(callback));
+        return;
+    }
+    send_answer(msg, [&](const dpp::message &answer) {
+        bot_->interaction_response_create(
+            id, token, dpp::interaction_response(type, answer),
+            std::move(callback));
+    });
+}
+
+void interaction_context::thinking(
+    bool ephemeral, dpp::command_completion_event_t callback) const {
+    if (!begin_deferral()) {
+        return;
+    }
+    dpp::message msg;
+    msg.content = "*";
+    msg.guild_id = guild_id;
+    msg.channel_id = channel_id;
+    if (ephemeral) {
+        msg.set_flags(dpp::m_ephemeral);
+    }
+    bot_->interaction_response_create(
+        id, token,
+        dpp::interaction_response(dpp::ir_deferred_channel_message_with_source,
+                                  msg),
+        [self = shared_from_this(), callback = std::move(callback)](
+            const dpp::confirmation_callback_t &cc) {
+            if (cc.is_error()) {
+                self->deferral_failed(cc.get_error().message);
+            } else {
+                self->deferral_acknowledged();
+            }
+            if (callback) {
+                callback(cc);
+            }
+        });
+}
+
+bool interaction_context::deferred() const {
+    std::lock_guard<std::mutex> lock(response_mutex_);
+    return response_ == response_state::deferring ||
+           response_ == response_state::deferred;
+}
+
+bool interaction_context::begin_deferral() const {
+    std::lock_guard<std::mutex> lock(response_mutex_);
+    if (response_ != response_state::none) {
+        return false;
+    }
+    response_ = response_state::deferring;
+    return true;
+}
+
+void interaction_context::deferral_acknowledged() const {
+    std::vector<held_reply> held;
+    {
+        std::lock_guard<std::mutex> lock(response_mutex_);
+        response_ = response_state::deferred;
+        held.swap(held_);
+    }
+    for (held_reply &reply : held) {
+        answer_deferred(reply.msg, std::move(reply.callback));
+    }
+}
+
+void interaction_context::deferral_failed(const std::string &error) const {
+    std::vector<held_reply> held;
+    {
+        std::lock_guard<std::mutex> lock(response_mutex_);
+        held.swap(held_);
+        response_ =
+            held.empty() ? response_state::none : response_state::answered;
+    }
+    bot_->log(dpp::ll_warning,
+              "Deferring /" + command_name + " failed: " + error);
+    // There is no deferred response to edit: the first held reply answers
+    // the interaction itself and any others follow it up.
+    for (size_t i = 0; i < held.size(); ++i) {
+        if (i > 0) {
+            send_followup(held[i].msg, std::move(held[i].callback));
+            continue;
+        }
+        send_answer(held[i].msg, [&](const dpp::message &answer) {
+            bot_->interaction_response_create(
+                id, token,
+                dpp::interaction_response(
+                    dpp::ir_channel_message_with_source, answer),
+                std::move(held[i].callback));
+        });
+    }
+}
+
+void interaction_context::answer_deferred(
+    const dpp::message &msg, dpp::command_completion_event_t callback) const {
+    bool first = false;
+    {
+        std::lock_guard<std::mutex> lock(response_mutex_);
+        first = !original_edited_;
+        original_edited_ = true;
+    }
+    if (first) {
+        send_answer(msg, [&](const dpp::message &answer) {
+            edit_original_response(answer, std::move(callback));
+        });
+    } else {
+        send_followup(msg, std::move(callback));
+    }
+}
+
+void interaction_context::followup(
+    const dpp::message &msg, dpp::command_completion_event_t callback) const {
+    bool after_deferral = false;
+    {
+        std::lock_guard<std::mutex> lock(response_mutex_);
+        if (response_ == response_state::deferring) {
+            held_.push_back({msg, std::move(callback)});
+            return;
+        }
+        after_deferral = response_ == response_state::deferred;
+    }
+    if (after_deferral) {
+        answer_deferred(msg, std::move(callback));
+        return;
+    }
+    send_followup(msg, std::move(callback));
+}
+
+void interaction_context::send_followup(
+    const dpp::message &msg, dpp::command_completion_event_t callback) const {
+    send_answer(msg, [&](const dpp::message &answer) {
+        bot_->interaction_followup_create(token, answer, std::move(callback));
+    });
+}
+
+void interaction_context::send_answer(
+    const dpp::message &msg,
+    const std::function<void(const dpp::message &)> &send) const {
+    bool decorate = false;
+    if (decorator_count_ > 0) {
+        std::lock_guard<std::mutex> lock(response_mutex_);
+        decorate = !decorated_;
+        decorated_ = true;
+    }
+    if (!decorate) {
+        send(msg);
+        return;
+    }
+    dpp::message decorated = msg;
+    for (size_t i = 0; i < decorator_count_; ++i) {
+        decorators_[i](*this, decorated);
+    }
+    send(decorated);
+}
+
+void interaction_context::edit_original_response(
+    const dpp::message &msg, dpp::command_completion_event_t callback) const {
+    bot_->interaction_response_edit(token, msg, std::move(callback));
+}
+
+interaction_handle
+make_interaction_context(dpp::cluster &bot, const dpp::slashcommand_t &event,
+                         const command_spec &spec,
+                         std::span<const response_decorator> decorators) {
+    return std::make_shared<const interaction_context>(bot, event, spec,
+                                                       decorators);
+}
+
+} // namespace palette::services
@@ -0,0 +1,42 @@
+#include "palette/services/interaction_deadline.hpp"
+#include <algorithm>
+
+namespace palette::services {
+namespace {
+// Ages beyond this are treated as clock skew between Discord and this host
+// rather than gateway delay, so a fast local clock cannot expire every
+// interaction on arrival.
+constexpr std::chrono::milliseconds kMaxTrustedAge{1000};
+} // namespace
+
+std::chrono::steady_clock::time_point
+interaction_created_at(const dpp::interaction &command) {
+    const auto steady_now = std::chrono::steady_clock::now();
+    const double created = command.id.get_creation_time();
+    if (created <= 0.0) {
+        return steady_now;
+    }
+
+    const auto created_at = std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            std::chrono::duration<double>(created)));
+    const auto age =
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::system_clock::now() - created_at);
+    return steady_now - std::clamp<std::chrono::steady_clock::duration>(
+                            age, std::chrono::steady_clock::duration::zero(),
+                            kMaxTrustedAge);
+}
+
+std::chrono::steady_clock::time_point
+interaction_response_deadline(const dpp::interaction &command) {
+    return interaction_created_at(command) + kInteractionResponseWindow -
+           kInteractionResponseMargin;
+}
+
+std::chrono::steady_clock::time_point
+interaction_response_expiry(const dpp::interaction &command) {
+    return interaction_created_at(command) + kInteractionResponseWindow;
+}
+
+} // namespace palette::services
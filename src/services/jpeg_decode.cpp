@@ -0,0 +1,612 @@
+#include "palette/services/image_decode.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace palette::services {
+namespace {
+constexpr int kFastBits = 9;
+constexpr int kMaxComponents = 3;
+
+constexpr std::array<uint8_t, 64> kZigzag = {
+    0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6,  7,  14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63};
+
+struct huffman_table {
+    bool present = false;
+    // Entries are (symbol << 8) | length; zero length means slow path.
+    std::array<uint16_t, 1 << kFastBits> fast{};
+    std::array<int32_t, 18> max_code{};
+    std::array<int32_t, 17> value_offset{};
+    std::array<uint8_t, 256> values{};
+
+    bool build(const uint8_t *counts, const uint8_t *symbols, int total) {
+        fast.fill(0);
+        std::copy(symbols, symbols + total, values.begin());
+
+        int code = 0;
+        int k = 0;
+        for (int len = 1; len <= 16; ++len) {
+            value_offset[len] = k - code;
+            // Too many codes for this length would run past the fast table.
+            if (code + counts[len - 1] > (1 << len)) {
+                return false;
+            }
+            for (int i = 0; i < counts[len - 1]; ++i, ++k, ++code) {
+                if (len <= kFastBits) {
+                    const int shift = kFastBits - len;
+                    for (int fill = 0; fill < (1 << shift); ++fill) {
+                        fast[(code << shift) | fill] =
+                            static_cast<uint16_t>((values[k] << 8) | len);
+                    }
+                }
+            }
+            max_code[len] = counts[len - 1] ? code - 1 : -1;
+            code <<= 1;
+        }
+        max_code[17] = 0x7FFFFFFF;
+        present = true;
+        return true;
+    }
+};
+
+struct component {
+    int id = 0;
+    int h = 1;
+    int v = 1;
+    int quant = 0;
+    int dc_table = 0;
+    int ac_table = 0;
+    int dc_prediction = 0;
+    int plane_width = 0;
+    std::vector<uint8_t> plane;
+};
+
+// Entropy-coded data is read MSB first with 0xFF00 byte stuffing; a real
+// marker ends the segment and feeds zeros from then on.
+class bit_reader {
+  public:
+    bit_reader(const uint8_t *data, size_t size, size_t position)
+        : data_(data), size_(size), position_(position) {}
+
+    uint32_t peek(int count) {
+        fill();
+        return buffer_ >> (32 - count);
+    }
+
+    void consume(int count) {
+        buffer_ <<= count;
+        available_ -= count;
+    }
+
+    int read(int count) {
+        if (count == 0) {
+            return 0;
+        }
+        const int value = static_cast<int>(peek(count));
+        consume(count);
+        return value;
+    }
+
+    int decode(const huffman_table &table) {
+        const uint16_t entry = table.fast[peek(kFastBits)];
+        if ((entry & 0xFF) != 0) {
+            consume(entry & 0xFF);
+            return entry >> 8;
+        }
+
+        const uint32_t bits = peek(16);
+        for (int len = kFastBits + 1; len <= 16; ++len) {
+            const int code = static_cast<int>(bits >> (16 - len));
+            if (code <= table.max_code[len]) {
+                consume(len);
+                return table.values[(code + table.value_offset[len]) & 0xFF];
+            }
+        }
+        consume(16);
+        return -1;
+    }
+
+    // Returns true after skipping an RSTn marker.
+    bool restart() {
+        buffer_ = 0;
+        available_ = 0;
+        if (!marker_) {
+            while (position_ + 1 < size_ &&
+                   !(data_[position_] == 0xFF && data_[position_ + 1] != 0 &&
+                     data_[position_ + 1] != 0xFF)) {
+                ++position_;
+            }
+        }
+        marker_ = false;
+        if (position_ + 1 >= size_ || data_[position_] != 0xFF ||
+            data_[position_ + 1] < 0xD0 || data_[position_ + 1] > 0xD7) {
+            return false;
+        }
+        position_ += 2;
+        return true;
+    }
+
+  private:
+    void fill() {
+        while (available_ <= 24) {
+            uint32_t byte = 0;
+            if (!marker_ && position_ < size_) {
+                byte = data_[position_];
+                if (byte == 0xFF) {
+                    const uint8_t next =
+                        position_ + 1 < size_ ? data_[position_ + 1] : 0;
+                    if (next == 0x00) {
+                        position_ += 2;
+                    } else {
+                        marker_ = true;
+                        byte = 0;
+                    }
+                } else {
+                    ++position_;
+                }
+            }
+            buffer_ |= byte << (24 - available_);
+            available_ += 8;
+        }
+    }
+
+    const uint8_t *data_;
+    size_t size_;
+    size_t position_;
+    uint32_t buffer_ = 0;
+    int available_ = 0;
+    bool marker_ = false;
+};
+
+int extend(int value, int bits) {
+    return value < (1 << (bits - 1)) ? value - (1 << bits) + 1 : value;
+}
+
+const std::array<float, 64> &idct_table() {
+    static const std::array<float, 64> table = [] {
+        std::array<float, 64> out{};
+        const double pi = 3.14159265358979323846;
+        for (int x = 0; x < 8; ++x) {
+            for (int u = 0; u < 8; ++u) {
+                const double scale = u == 0 ? std::sqrt(0.5) : 1.0;
+                out[x * 8 + u] = static_cast<float>(
+                    scale * std::cos((2.0 * x + 1.0) * u * pi / 16.0) / 2.0);
+            }
+        }
+        return out;
+    }();
+    return table;
+}
+
+// Separable float IDCT; rows then columns, 128 level shift, clamped.
+void inverse_dct(const std::array<int, 64> &in, uint8_t *out, int stride) {
+    const auto &c = idct_table();
+    std::array<float, 64> tmp{};
+    for (int y = 0; y < 8; ++y) {
+        for (int x = 0; x < 8; ++x) {
+            float sum = 0.0F;
+            for (int u = 0; u < 8; ++u) {
+                sum += c[x * 8 + u] * static_cast<float>(in[y * 8 + u]);
+            }
+            tmp[y * 8 + x] = sum;
+        }
+    }
+    for (int x = 0; x < 8; ++x) {
+        for (int y = 0; y < 8; ++y) {
+            float sum = 0.0F;
+            for (int v = 0; v < 8; ++v) {
+                sum += c[y * 8 + v] * tmp[v * 8 + x];
+            }
+            const int value = static_cast<int>(std::lround(sum + 128.0F));
+            out[y * stride + x] =
+                static_cast<uint8_t>(std::clamp(value, 0, 255));
+        }
+    }
+}
+
+uint8_t clamp_channel(float value) {
+    return static_cast<uint8_t>(
+        std::clamp(static_cast<int>(std::lround(value)), 0, 255));
+}
+
+class jpeg_decoder {
+  public:
+    jpeg_decoder(std::string_view data, size_t max_samples,
+                 image_sample_result &result)
+        : data_(reinterpret_cast<const uint8_t *>(data.data())),
+          size_(data.size()), max_samples_(max_samples), result_(result) {}
+
+    bool run() {
+        size_t offset = 2;
+        while (offset + 4 <= size_) {
+            if (data_[offset] != 0xFF) {
+                return fail("The JPEG file is corrupt.");
+            }
+            const uint8_t marker = data_[offset + 1];
+            if (marker == 0xFF) {
+                ++offset;
+                continue;
+            }
+            if (marker == 0xD9) {
+                break;
+            }
+
+            const size_t length =
+                (static_cast<size_t>(data_[offset + 2]) << 8) |
+                data_[offset + 3];
+            if (length < 2 || offset + 2 + length > size_) {
+                return fail("The JPEG file is truncated.");
+            }
+            const uint8_t *segment = data_ + offset + 4;
+            const size_t segment_size = length - 2;
+            offset += 2 + length;
+
+            bool ok = true;
+            switch (marker) {
+            case 0xC0:
+            case 0xC1:
+                ok = read_frame(segment, segment_size);
+                break;
+            case 0xC2:
+            case 0xC3:
+            case 0xC5:
+            case 0xC6:
+            case 0xC7:
+            case 0xC9:
+            case 0xCA:
+            case 0xCB:
+            case 0xCD:
+            case 0xCE:
+            case 0xCF:
+                return fail("Only baseline JPEG images are supported.");
+            case 0xC4:
+                ok = read_huffman_tables(segment, segment_size);
+                break;
+            case 0xDB:
+                ok = read_quant_tables(segment, segment_size);
+                break;
+            case 0xDD:
+                ok = segment_size >= 2;
+                if (ok) {
+                    restart_interval_ = (segment[0] << 8) | segment[1];
+                }
+                break;
+            case 0xEE:
+                if (segment_size >= 12 &&
+                    std::string_view(reinterpret_cast<const char *>(segment),
+                                     5) == "Adobe") {
+                    adobe_transform_ = segment[11];
+                }
+                break;
+            case 0xDA:
+                return read_scan(segment, segment_size, offset);
+            default:
+                break;
+            }
+            if (!ok) {
+                return false;
+            }
+        }
+        return fail("The JPEG file has no image data.");
+    }
+
+  private:
+    bool fail(const char *message) {
+        if (result_.error.empty()) {
+            result_.error = message;
+        }
+        return false;
+    }
+
+    bool read_quant_tables(const uint8_t *p, size_t size) {
+        size_t i = 0;
+        while (i < size) {
+            const int precision = p[i] >> 4;
+            const int id = p[i] & 0x0F;
+            ++i;
+            if (id > 3 || i + (precision ? 128U : 64U) > size) {
+                return fail("The JPEG quantization table is invalid.");
+            }
+            for (int k = 0; k < 64; ++k) {
+                int value = p[i];
+                if (precision) {
+                    value = (p[i] << 8) | p[i + 1];
+                    i += 2;
+                } else {
+                    ++i;
+                }
+                quant_[id][kZigzag[k]] = value;
+            }
+        }
+        return true;
+    }
+
+    bool read_huffman_tables(const uint8_t *p, size_t size) {
+        size_t i = 0;
+        while (i + 17 <= size) {
+            const int table_class = p[i] >> 4;
+            const int id = p[i] & 0x0F;
+            if (table_class > 1 || id > 3) {
+                return fail("The JPEG Huffman table is invalid.");
+            }
+            const uint8_t *counts = p + i + 1;
+            int total = 0;
+            for (int k = 0; k < 16; ++k) {
+                total += counts[k];
+            }
+            i += 17;
+            if (total > 256 || i + static_cast<size_t>(total) > size) {
+                return fail("The JPEG Huffman table is invalid.");
+            }
+
+            huffman_table &table =
+                table_class == 0 ? dc_tables_[id] : ac_tables_[id];
+            if (!table.build(counts, p + i, total)) {
+                return fail("The JPEG Huffman table is invalid.");
+            }
+            i += static_cast<size_t>(total);
+        }
+        return true;
+    }
+
+    bool read_frame(const uint8_t *p, size_t size) {
+        if (size < 6 || p[0] != 8) {
+            return fail("Only 8-bit JPEG images are supported.");
+        }
+        height_ = (p[1] << 8) | p[2];
+        width_ = (p[3] << 8) | p[4];
+        const int count = p[5];
+        if (count != 1 && count != kMaxComponents) {
+            return fail("Only grayscale and YCbCr JPEG images are supported.");
+        }
+        if (size < 6 + static_cast<size_t>(count) * 3) {
+            return fail("The JPEG frame header is invalid.");
+        }
+        if (width_ <= 0 || height_ <= 0 || width_ > kMaxDecodeDimension ||
+            height_ > kMaxDecodeDimension ||
+            static_cast<uint64_t>(width_) * height_ > kMaxDecodePixels) {
+            return fail("The image is too large.");
+        }
+
+        components_.assign(static_cast<size_t>(count), component{});
+        for (int i = 0; i < count; ++i) {
+            component &c = components_[static_cast<size_t>(i)];
+            c.id = p[6 + i * 3];
+            c.h = p[7 + i * 3] >> 4;
+            c.v = p[7 + i * 3] & 0x0F;
+            c.quant = p[8 + i * 3] & 0x03;
+            if (c.h < 1 || c.h > 4 || c.v < 1 || c.v > 4) {
+                return fail("The JPEG sampling factors are invalid.");
+            }
+        }
+        // A single-component scan is never interleaved, so its MCU is one
+        // block regardless of the declared factors.
+        if (count == 1) {
+            components_[0].h = 1;
+            components_[0].v = 1;
+        }
+        return true;
+    }
+
+    bool read_scan(const uint8_t *p, size_t size, size_t data_offset) {
+        if (components_.empty()) {
+            return fail("The JPEG frame header is missing.");
+        }
+        if (size < 1 || p[0] != components_.size() ||
+            size < 1 + static_cast<size_t>(p[0]) * 2 + 3) {
+            return fail("Only single-scan JPEG images are supported.");
+        }
+
+        for (int i = 0; i < p[0]; ++i) {
+            const int id = p[1 + i * 2];
+            const int tables = p[2 + i * 2];
+            auto it = std::find_if(components_.begin(), components_.end(),
+                                   [id](const component &c) {
+                                       return c.id == id;
+                                   });
+            if (it == components_.end()) {
+                return fail("The JPEG scan header is invalid.");
+            }
+            it->dc_table = tables >> 4 & 0x03;
+            it->ac_table = tables & 0x03;
+            if (!dc_tables_[it->dc_table].present ||
+                !ac_tables_[it->ac_table].present) {
+                return fail("The JPEG Huffman table is missing.");
+            }
+        }
+        return decode_scan(data_offset);
+    }
+
+    bool decode_scan(size_t data_offset) {
+        int max_h = 1;
+        int max_v = 1;
+        for (const component &c : components_) {
+            max_h = std::max(max_h, c.h);
+            max_v = std::max(max_v, c.v);
+        }
+
+        const int mcu_width = 8 * max_h;
+        const int mcu_height = 8 * max_v;
+        const int mcus_x = (width_ + mcu_width - 1) / mcu_width;
+        const int mcus_y = (height_ + mcu_height - 1) / mcu_height;
+        for (component &c : components_) {
+            c.plane_width = mcus_x * c.h * 8;
+            c.plane.assign(static_cast<size_t>(c.plane_width) * c.v * 8, 0);
+        }
+
+        const int stride = sample_stride(width_, height_, max_samples_);
+        result_.width = width_;
+        result_.height = height_;
+        result_.samples.reserve(max_samples_ + max_samples_ / 4);
+
+        bit_reader bits(data_, size_, data_offset);
+        std::array<int, 64> block{};
+        int mcus_until_restart = restart_interval_;
+
+        for (int mcu_y = 0; mcu_y < mcus_y; ++mcu_y) {
+            const int row_begin = mcu_y * mcu_height;
+            const int row_end = std::min(height_, row_begin + mcu_height);
+            const int first_sampled =
+                (row_begin + stride - 1) / stride * stride;
+            // Entropy decoding is sequential, but the IDCT only has to run
+            // for MCU rows that contain a sampled scanline.
+            const bool needed = first_sampled < row_end;
+
+            for (int mcu_x = 0; mcu_x < mcus_x; ++mcu_x) {
+                if (restart_interval_ > 0) {
+                    if (mcus_until_restart == 0) {
+                        if (!bits.restart()) {
+                            return fail("The JPEG restart marker is missing.");
+                        }
+                        for (component &c : components_) {
+                            c.dc_prediction = 0;
+                        }
+                        mcus_until_restart = restart_interval_;
+                    }
+                    --mcus_until_restart;
+                }
+
+                for (component &c : components_) {
+                    for (int by = 0; by < c.v; ++by) {
+                        for (int bx = 0; bx < c.h; ++bx) {
+                            if (!decode_block(bits, c, block)) {
+                                return fail("The JPEG image data is corrupt.");
+                            }
+                            if (needed) {
+                                const int x = (mcu_x * c.h + bx) * 8;
+                                const int y = by * 8;
+                                inverse_dct(block,
+                                            c.plane.data() +
+                                                static_cast<size_t>(y) *
+                                                    c.plane_width +
+                                                x,
+                                            c.plane_width);
+                            }
+                        }
+                    }
+                }
+            }
+
+            if (needed) {
+                sample_rows(row_begin, row_end, stride, max_h, max_v);
+            }
+        }
+
+        if (result_.samples.empty()) {
+            return fail("The image has no pixels.");
+        }
+        result_.ok = true;
+        return true;
+    }
+
+    bool decode_block(bit_reader &bits, component &c,
+                      std::array<int, 64> &block) {
+        block.fill(0);
+        const auto &quant = quant_[c.quant];
+
+        const int dc_bits = bits.decode(dc_tables_[c.dc_table]);
+        if (dc_bits < 0 || dc_bits > 11) {
+            return false;
+        }
+        const int diff = dc_bits ? extend(bits.read(dc_bits), dc_bits) : 0;
+        c.dc_prediction += diff;
+        block[0] = c.dc_prediction * quant[0];
+
+        const huffman_table &ac = ac_tables_[c.ac_table];
+        for (int k = 1; k < 64;) {
+            const int rs = bits.decode(ac);
+            if (rs < 0) {
+                return false;
+            }
+            const int run = rs >> 4;
+            const int size = rs & 0x0F;
+            if (size == 0) {
+                if (run != 15) {
+                    break;
+                }
+                k += 16;
+                continue;
+            }
+            k += run;
+            if (k > 63) {
+                return false;
+            }
+            const int natural = kZigzag[k];
+            block[natural] = extend(bits.read(size), size) * quant[natural];
+            ++k;
+        }
+        return true;
+    }
+
+    void sample_rows(int row_begin, int row_end, int stride, int max_h,
+                     int max_v) {
+        const bool grayscale = components_.size() == 1;
+        const bool rgb = !grayscale && adobe_transform_ == 0;
+
+        for (int y = (row_begin + stride - 1) / stride * stride; y < row_end;
+             y += stride) {
+            const int local_y = y - row_begin;
+            for (int x = 0; x < width_; x += stride) {
+                std::array<uint8_t, kMaxComponents> values{};
+                for (size_t i = 0; i < components_.size(); ++i) {
+                    const component &c = components_[i];
+                    const int cx = x * c.h / max_h;
+                    const int cy = local_y * c.v / max_v;
+                    values[i] = c.plane[static_cast<size_t>(cy) *
+                                            c.plane_width +
+                                        cx];
+                }
+
+                if (grayscale) {
+                    result_.samples.push_back(
+                        {values[0], values[0], values[0]});
+                } else if (rgb) {
+                    result_.samples.push_back(
+                        {values[0], values[1], values[2]});
+                } else {
+                    const float luma = values[0];
+                    const float cb = static_cast<float>(values[1]) - 128.0F;
+                    const float cr = static_cast<float>(values[2]) - 128.0F;
+                    result_.samples.push_back(
+                        {clamp_channel(luma + 1.402F * cr),
+                         clamp_channel(luma - 0.344136F * cb - 0.714136F * cr),
+                         clamp_channel(luma + 1.772F * cb)});
+                }
+            }
+        }
+    }
+
+    const uint8_t *data_;
+    size_t size_;
+    size_t max_samples_;
+    image_sample_result &result_;
+
+    int width_ = 0;
+    int height_ = 0;
+    int restart_interval_ = 0;
+    int adobe_transform_ = -1;
+    std::array<std::array<int, 64>, 4> quant_{};
+    std::array<huffman_table, 4> dc_tables_{};
+    std::array<huffman_table, 4> ac_tables_{};
+    std::vector<component> components_;
+};
+} // namespace
+
+image_sample_result sample_jpeg_pixels(std::string_view data,
+                                       size_t max_samples) {
+    image_sample_result result;
+    jpeg_decoder decoder(data, max_samples, result);
+    if (!decoder.run()) {
+        result.ok = false;
+        result.samples.clear();
+        if (result.error.empty()) {
+            result.error = "The JPEG file could not be decoded.";
+        }
+    }
+    return result;
+}
+
+} // namespace palette::services
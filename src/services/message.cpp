@@ -27,30 +27,20 @@ std::string messages[10] = {
 
 namespace palette::services {
 
-void add_suggestion(const dpp::slashcommand_t &event) {
-    auto rndIdx = random_index(std::size(messages));
-
-    const std::string suggestion = messages[rndIdx];
-
-    event.get_original_response(
-        [event, suggestion](const dpp::confirmation_callback_t &cc) {
-            if (cc.is_error()) {
-                std::cerr << "get_original_response failed: "
-                          << cc.get_error().message << "\n";
-                return;
-            }
-
-            // On success, cc.value holds a dpp::message
-            const auto &msg = std::get<dpp::message>(cc.value);
-            dpp::message edited = msg;
-            auto embed = dpp::embed().set_description(suggestion);
-            edited.embeds.push_back(embed);
+void append_suggestion(const interaction_context &, dpp::message &msg) {
+    const std::string &suggestion = messages[random_index(std::size(messages))];
+    msg.add_embed(dpp::embed().set_description(suggestion));
+}
 
-            event.edit_original_response(edited);
-        });
-};
-void send_ratelimited(const dpp::slashcommand_t &event) {
+void send_ratelimited(const dpp::interaction_create_t &event) {
     event.reply(dpp::embed().set_description(
         "Please slow down... chill out a little bit!"));
 }
+void send_busy(const dpp::interaction_create_t &event) {
+    dpp::message msg;
+    msg.add_embed(dpp::embed().set_description(
+        "Palette is busy right now, please try again in a few seconds."));
+    msg.set_flags(dpp::m_ephemeral);
+    event.reply(msg);
+}
 } // namespace palette::services
@@ -1,49 +1,93 @@
 #include "palette/services/palette_controls.hpp"
 #include "palette/services/color_utils.hpp"
+#include "palette/services/env_utils.hpp"
+#include "palette/services/hmac.hpp"
 #include <algorithm>
-#include <atomic>
-#include <iomanip>
-#include <mutex>
-#include <sstream>
+#include <array>
+#include <iostream>
+#include <random>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 namespace palette::services {
 namespace {
 constexpr int kMinAmount = 2;
 constexpr int kMaxAmount = 8;
-constexpr size_t kMaxStates = 1024;
-
-std::mutex state_mutex;
-std::unordered_map<std::string, palette_control_state> state_by_token;
-std::vector<std::string> insertion_order;
-std::atomic<uint64_t> token_counter{0};
-
-std::string next_token() {
-    const uint64_t value = ++token_counter;
-    std::ostringstream stream;
-    stream << std::hex << std::setfill('0') << std::setw(12) << value;
-    return stream.str();
+
+// Button state layout: a version, mode and CVD byte, amount and seed count
+// nibbles, the CVD severity, three bytes per seed, then the first bytes of
+// an HMAC over all of that. Ten seeds come to 60 base64url characters.
+constexpr unsigned kStateVersion = 1;
+constexpr size_t kStateHeaderBytes = 3;
+constexpr size_t kStateMacBytes = 12;
+constexpr size_t kMaxStateBytes =
+    kStateHeaderBytes + kMaxPaletteSeeds * 3 + kStateMacBytes;
+
+constexpr std::string_view kBase64UrlAlphabet =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+// BOT_BUTTON_SECRET lets every process accept the others' buttons. Without
+// it a random key is used, and buttons stop working after a restart.
+const std::string &button_secret() {
+    static const std::string secret = [] {
+        std::string value = get_env_value("BOT_BUTTON_SECRET");
+        if (value.empty()) {
+            std::cerr << "BOT_BUTTON_SECRET is not set; palette buttons "
+                         "will not survive a restart.\n";
+            std::random_device random;
+            for (int i = 0; i < 32; ++i) {
+                value.push_back(static_cast<char>(random() & 0xFFU));
+            }
+        }
+        return value;
+    }();
+    return secret;
 }
 
-void prune_old_states_locked() {
-    if (state_by_token.size() <= kMaxStates) {
-        return;
+std::string encode_base64url(const uint8_t *data, size_t size) {
+    std::string out;
+    out.reserve((size * 4 + 2) / 3);
+    for (size_t i = 0; i < size; i += 3) {
+        const size_t take = std::min<size_t>(3, size - i);
+        uint32_t group = static_cast<uint32_t>(data[i]) << 16;
+        if (take > 1) {
+            group |= static_cast<uint32_t>(data[i + 1]) << 8;
+        }
+        if (take > 2) {
+            group |= data[i + 2];
+        }
+        for (size_t c = 0; c <= take; ++c) {
+            out.push_back(kBase64UrlAlphabet[(group >> (18 - 6 * c)) & 0x3FU]);
+        }
     }
+    return out;
+}
 
-    size_t index = 0;
-    while (state_by_token.size() > kMaxStates &&
-           index < insertion_order.size()) {
-        state_by_token.erase(insertion_order[index]);
-        ++index;
+// Unpadded; fails on stray characters or more than `capacity` bytes.
+bool decode_base64url(std::string_view text, uint8_t *out, size_t capacity,
+                      size_t &size) {
+    if (text.size() % 4 == 1) {
+        return false;
     }
-
-    if (index > 0) {
-        insertion_order.erase(insertion_order.begin(),
-                              insertion_order.begin() +
-                                  static_cast<long>(index));
+    size = 0;
+    uint32_t group = 0;
+    int bits = 0;
+    for (const char c : text) {
+        const size_t value = kBase64UrlAlphabet.find(c);
+        if (value == std::string_view::npos) {
+            return false;
+        }
+        group = (group << 6) | static_cast<uint32_t>(value);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            if (size == capacity) {
+                return false;
+            }
+            out[size++] = static_cast<uint8_t>(group >> bits);
+        }
     }
+    return true;
 }
 
 std::string
@@ -82,96 +126,108 @@ int clamp_palette_amount(int amount) {
     return std::clamp(amount, kMinAmount, kMaxAmount);
 }
 
-std::string create_palette_control_token(palette_control_mode mode,
-                                         const std::vector<rgb_color> &seeds,
-                                         int amount) {
-    if (seeds.empty()) {
-        return std::string();
+std::optional<palette_control_state> make_palette_control_state(
+    palette_control_mode mode, const std::vector<rgb_color> &seeds, int amount,
+    const std::optional<cvd_simulation> &simulation) {
+    if (seeds.empty() || seeds.size() > kMaxPaletteSeeds) {
+        return std::nullopt;
     }
 
     palette_control_state state;
     state.mode = mode;
-    state.seed_colors = seeds;
     state.amount = clamp_palette_amount(amount);
+    state.seed_count = static_cast<uint8_t>(seeds.size());
+    std::copy(seeds.begin(), seeds.end(), state.seeds.begin());
+    state.simulation = simulation;
+    return state;
+}
 
-    const std::string token = next_token();
-    {
-        std::lock_guard<std::mutex> lock(state_mutex);
-        state_by_token[token] = state;
-        insertion_order.push_back(token);
-        prune_old_states_locked();
+std::string encode_palette_state(const palette_control_state &state) {
+    std::array<uint8_t, kMaxStateBytes> bytes{};
+    bytes[0] = static_cast<uint8_t>(
+        (kStateVersion << 6) |
+        (state.mode == palette_control_mode::tints ? 0x20U : 0U) |
+        (state.simulation ? 0x10U : 0U) |
+        (state.simulation ? static_cast<unsigned>(state.simulation->type) << 2
+                          : 0U));
+    bytes[1] = static_cast<uint8_t>(
+        (clamp_palette_amount(state.amount) << 4) | state.seed_count);
+    bytes[2] = static_cast<uint8_t>(
+        state.simulation ? std::clamp(state.simulation->severity, 0, 100) : 0);
+    size_t size = kStateHeaderBytes;
+    for (size_t i = 0; i < state.seed_count; ++i) {
+        bytes[size++] = state.seeds[i].r;
+        bytes[size++] = state.seeds[i].g;
+        bytes[size++] = state.seeds[i].b;
     }
-    return token;
+
+    const sha256_digest mac =
+        hmac_sha256(button_secret(), bytes.data(), size);
+    std::copy(mac.begin(), mac.begin() + kStateMacBytes, bytes.begin() + size);
+    return encode_base64url(bytes.data(), size + kStateMacBytes);
 }
 
-bool get_palette_control_state(const std::string &token,
-                               palette_control_state &out) {
-    std::lock_guard<std::mutex> lock(state_mutex);
-    auto it = state_by_token.find(token);
-    if (it == state_by_token.end()) {
-        return false;
-    }
-    out = it->second;
-    return true;
+std::vector<rgb_color> palette_control_state::seed_colors() const {
+    return std::vector<rgb_color>(seeds.begin(), seeds.begin() + seed_count);
 }
 
-bool adjust_palette_control_amount(const std::string &token, int delta,
-                                   palette_control_state &out) {
-    std::lock_guard<std::mutex> lock(state_mutex);
-    auto it = state_by_token.find(token);
-    if (it == state_by_token.end()) {
+bool decode_palette_state(std::string_view payload,
+                          palette_control_state &out) {
+    std::array<uint8_t, kMaxStateBytes> bytes{};
+    size_t size = 0;
+    if (!decode_base64url(payload, bytes.data(), bytes.size(), size) ||
+        size < kStateHeaderBytes + kStateMacBytes) {
         return false;
     }
 
-    it->second.amount = clamp_palette_amount(it->second.amount + delta);
-    out = it->second;
-    return true;
-}
-
-std::string build_palette_button_id(palette_control_mode mode, int delta,
-                                    const std::string &token) {
-    if (token.empty()) {
-        return std::string();
+    const size_t signed_size = size - kStateMacBytes;
+    const size_t seed_count = bytes[1] & 0x0FU;
+    if (bytes[0] >> 6 != kStateVersion || seed_count == 0 ||
+        seed_count > kMaxPaletteSeeds ||
+        signed_size != kStateHeaderBytes + seed_count * 3) {
+        return false;
+    }
+    const sha256_digest mac =
+        hmac_sha256(button_secret(), bytes.data(), signed_size);
+    if (!constant_time_equal(mac.data(), bytes.data() + signed_size,
+                             kStateMacBytes)) {
+        return false;
     }
 
-    const std::string prefix =
-        mode == palette_control_mode::shades ? "shades_" : "tints_";
-    const std::string action = delta > 0 ? "next" : "back";
-    return prefix + action + ":" + token;
-}
-
-bool parse_palette_button_id(const std::string &custom_id,
-                             palette_control_mode &mode, int &delta,
-                             std::string &token) {
-    const auto parse = [&](const char *prefix,
-                           palette_control_mode candidate_mode,
-                           int candidate_delta) -> bool {
-        const std::string full_prefix = std::string(prefix) + ":";
-        if (custom_id.rfind(full_prefix, 0) != 0) {
-            return false;
-        }
-        token = custom_id.substr(full_prefix.size());
-        if (token.empty()) {
-            return false;
-        }
-        mode = candidate_mode;
-        delta = candidate_delta;
-        return true;
-    };
-
-    if (parse("shades_next", palette_control_mode::shades, +1) ||
-        parse("shades_back", palette_control_mode::shades, -1) ||
-        parse("tints_next", palette_control_mode::tints, +1) ||
-        parse("tints_back", palette_control_mode::tints, -1)) {
-        return true;
+    const unsigned cvd = (bytes[0] >> 2) & 0x03U;
+    if (cvd > static_cast<unsigned>(cvd_type::tritan) || bytes[2] > 100) {
+        return false;
+    }
+    out.mode = (bytes[0] & 0x20U) ? palette_control_mode::tints
+                                  : palette_control_mode::shades;
+    out.amount = clamp_palette_amount(bytes[1] >> 4);
+    out.seed_count = static_cast<uint8_t>(seed_count);
+    for (size_t i = 0; i < seed_count; ++i) {
+        const uint8_t *rgb = bytes.data() + kStateHeaderBytes + i * 3;
+        out.seeds[i] = {rgb[0], rgb[1], rgb[2]};
+    }
+    out.simulation.reset();
+    if (bytes[0] & 0x10U) {
+        out.simulation =
+            cvd_simulation{static_cast<cvd_type>(cvd), bytes[2]};
     }
+    return true;
+}
 
-    return false;
+std::string build_palette_button_id(int delta,
+                                    const palette_control_state &state) {
+    const bool shades = state.mode == palette_control_mode::shades;
+    const button_action action =
+        delta > 0 ? (shades ? button_action::shades_next
+                            : button_action::tints_next)
+                  : (shades ? button_action::shades_back
+                            : button_action::tints_back);
+    return std::string(button_action_name(action)) + ":" +
+           encode_palette_state(state);
 }
 
-dpp::component build_palette_controls_row(palette_control_mode mode, int amount,
-                                          const std::string &token) {
-    const int clamped_amount = clamp_palette_amount(amount);
+dpp::component build_palette_controls_row(const palette_control_state &state) {
+    const int clamped_amount = clamp_palette_amount(state.amount);
     dpp::component row;
     row.set_type(dpp::cot_action_row);
 
@@ -181,7 +237,7 @@ dpp::component build_palette_controls_row(palette_control_mode mode, int amount,
                 .set_label("-1")
                 .set_type(dpp::cot_button)
                 .set_style(dpp::cos_primary)
-                .set_id(build_palette_button_id(mode, -1, token)));
+                .set_id(build_palette_button_id(-1, state)));
     }
 
     if (clamped_amount < kMaxAmount) {
@@ -190,7 +246,7 @@ dpp::component build_palette_controls_row(palette_control_mode mode, int amount,
                 .set_label("+1")
                 .set_type(dpp::cot_button)
                 .set_style(dpp::cos_primary)
-                .set_id(build_palette_button_id(mode, +1, token)));
+                .set_id(build_palette_button_id(+1, state)));
     }
 
     return row;
@@ -198,7 +254,8 @@ dpp::component build_palette_controls_row(palette_control_mode mode, int amount,
 
 palette_render_result
 render_palette_with_controls(palette_control_mode mode,
-                             const std::vector<rgb_color> &seeds, int amount) {
+                             const std::vector<rgb_color> &seeds, int amount,
+                             const std::optional<cvd_simulation> &simulation) {
     palette_render_result result;
     if (seeds.empty()) {
         result.error = "No source colors to render.";
@@ -224,8 +281,15 @@ render_palette_with_controls(palette_control_mode mode,
                 "A shade is a concept of darkening a color.\n\n" + description;
         }
 
+        if (simulation) {
+            description +=
+                "\n\n- **Simulated vision:** " + cvd_label(*simulation);
+        }
         result.description = std::move(description);
-        result.image_data = image.image_data;
+        result.image_data =
+            simulation
+                ? generate_cvd_comparison_image(image.palette, *simulation)
+                : image.image_data;
         result.ok = true;
         return result;
     }
@@ -252,8 +316,13 @@ render_palette_with_controls(palette_control_mode mode,
             "A tint is a concept of lightening a color.\n\n" + description;
     }
 
+    if (simulation) {
+        description += "\n\n- **Simulated vision:** " + cvd_label(*simulation);
+    }
     result.description = std::move(description);
-    result.image_data = image.image_data;
+    result.image_data =
+        simulation ? generate_cvd_comparison_image(image.palette, *simulation)
+                   : image.image_data;
     result.ok = true;
     return result;
 }
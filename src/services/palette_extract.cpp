@@ -0,0 +1,206 @@
+#include "palette/services/palette_extract.hpp"
+#include "palette/services/color_space.hpp"
+#include "palette/services/thread_pool.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+namespace palette::services {
+namespace {
+constexpr int kHistogramBits = 5;
+constexpr size_t kHistogramSize = size_t{1} << (kHistogramBits * 3);
+constexpr int kMaxIterations = 16;
+constexpr size_t kParallelChunk = 2048;
+constexpr double kConvergedShift = 1e-7;
+
+// One histogram bin: the mean OKLab value of its samples and their count.
+struct weighted_points {
+    std::vector<float> l;
+    std::vector<float> a;
+    std::vector<float> b;
+    std::vector<float> weight;
+
+    size_t size() const { return weight.size(); }
+};
+
+weighted_points build_points(const std::vector<rgb_color> &samples) {
+    struct bin {
+        uint32_t r = 0;
+        uint32_t g = 0;
+        uint32_t b = 0;
+        uint32_t count = 0;
+    };
+    std::vector<bin> bins(kHistogramSize);
+    constexpr int shift = 8 - kHistogramBits;
+    for (const rgb_color &c : samples) {
+        const size_t index = (static_cast<size_t>(c.r >> shift)
+                              << (2 * kHistogramBits)) |
+                             (static_cast<size_t>(c.g >> shift)
+                              << kHistogramBits) |
+                             static_cast<size_t>(c.b >> shift);
+        bin &target = bins[index];
+        target.r += c.r;
+        target.g += c.g;
+        target.b += c.b;
+        ++target.count;
+    }
+
+    std::vector<rgb_color> means;
+    std::vector<float> weights;
+    for (const bin &entry : bins) {
+        if (entry.count == 0) {
+            continue;
+        }
+        const uint32_t half = entry.count / 2;
+        means.push_back({static_cast<uint8_t>((entry.r + half) / entry.count),
+                         static_cast<uint8_t>((entry.g + half) / entry.count),
+                         static_cast<uint8_t>((entry.b + half) / entry.count)});
+        weights.push_back(static_cast<float>(entry.count));
+    }
+
+    weighted_points points;
+    points.l.resize(means.size());
+    points.a.resize(means.size());
+    points.b.resize(means.size());
+    points.weight = std::move(weights);
+    rgb_to_oklab_batch(means.data(), means.size(), points.l.data(),
+                       points.a.data(), points.b.data());
+    return points;
+}
+
+float distance_squared(const weighted_points &points, size_t i,
+                       const oklab_color &center) {
+    const float dl = points.l[i] - static_cast<float>(center.l);
+    const float da = points.a[i] - static_cast<float>(center.a);
+    const float db = points.b[i] - static_cast<float>(center.b);
+    return dl * dl + da * da + db * db;
+}
+
+oklab_color point_at(const weighted_points &points, size_t i) {
+    return {points.l[i], points.a[i], points.b[i]};
+}
+
+// Deterministic k-means++: start from the heaviest bin, then repeatedly take
+// the bin with the largest weighted distance to its nearest center.
+std::vector<oklab_color> seed_centers(const weighted_points &points,
+                                      size_t count) {
+    std::vector<oklab_color> centers;
+    const auto heaviest =
+        std::max_element(points.weight.begin(), points.weight.end());
+    centers.push_back(point_at(
+        points, static_cast<size_t>(heaviest - points.weight.begin())));
+
+    std::vector<float> nearest(points.size(),
+                               std::numeric_limits<float>::max());
+    while (centers.size() < count) {
+        size_t best = 0;
+        float best_score = -1.0F;
+        for (size_t i = 0; i < points.size(); ++i) {
+            nearest[i] = std::min(
+                nearest[i], distance_squared(points, i, centers.back()));
+            const float score = nearest[i] * points.weight[i];
+            if (score > best_score) {
+                best_score = score;
+                best = i;
+            }
+        }
+        if (best_score <= 0.0F) {
+            break;
+        }
+        centers.push_back(point_at(points, best));
+    }
+    return centers;
+}
+
+void assign_range(const weighted_points &points,
+                  const std::vector<oklab_color> &centers,
+                  std::vector<uint8_t> &labels, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        size_t best = 0;
+        float best_distance = std::numeric_limits<float>::max();
+        for (size_t c = 0; c < centers.size(); ++c) {
+            const float d = distance_squared(points, i, centers[c]);
+            if (d < best_distance) {
+                best_distance = d;
+                best = c;
+            }
+        }
+        labels[i] = static_cast<uint8_t>(best);
+    }
+}
+} // namespace
+
+std::vector<extracted_color>
+extract_dominant_colors(const std::vector<rgb_color> &samples, int count) {
+    if (samples.empty() || count <= 0) {
+        return {};
+    }
+
+    const weighted_points points = build_points(samples);
+    std::vector<oklab_color> centers =
+        seed_centers(points, std::min(static_cast<size_t>(count),
+                                      std::min<size_t>(points.size(), 255)));
+
+    std::vector<uint8_t> labels(points.size(), 0);
+    std::vector<double> totals(centers.size(), 0.0);
+    thread_pool *const pool = thread_pool::current();
+
+    for (int iteration = 0; iteration < kMaxIterations; ++iteration) {
+        if (pool && points.size() > kParallelChunk) {
+            pool->parallel_for(points.size(), kParallelChunk,
+                               [&](size_t begin, size_t end) {
+                                   assign_range(points, centers, labels, begin,
+                                                end);
+                               });
+        } else {
+            assign_range(points, centers, labels, 0, points.size());
+        }
+
+        std::vector<oklab_color> sums(centers.size());
+        std::fill(totals.begin(), totals.end(), 0.0);
+        for (size_t i = 0; i < points.size(); ++i) {
+            const double w = points.weight[i];
+            oklab_color &sum = sums[labels[i]];
+            sum.l += w * points.l[i];
+            sum.a += w * points.a[i];
+            sum.b += w * points.b[i];
+            totals[labels[i]] += w;
+        }
+
+        double shift = 0.0;
+        for (size_t c = 0; c < centers.size(); ++c) {
+            if (totals[c] <= 0.0) {
+                continue;
+            }
+            const oklab_color next{sums[c].l / totals[c], sums[c].a / totals[c],
+                                   sums[c].b / totals[c]};
+            shift = std::max(shift, oklab_distance_squared(next, centers[c]));
+            centers[c] = next;
+        }
+        if (shift < kConvergedShift) {
+            break;
+        }
+    }
+
+    double total_weight = 0.0;
+    for (const double t : totals) {
+        total_weight += t;
+    }
+
+    std::vector<extracted_color> result;
+    for (size_t c = 0; c < centers.size(); ++c) {
+        if (totals[c] <= 0.0) {
+            continue;
+        }
+        result.push_back(
+            {oklab_to_rgb(centers[c]), totals[c] / total_weight * 100.0});
+    }
+    std::stable_sort(result.begin(), result.end(),
+                     [](const extracted_color &x, const extracted_color &y) {
+                         return x.share > y.share;
+                     });
+    return result;
+}
+
+} // namespace palette::services
@@ -588,22 +588,38 @@ std::string generate_palette_image(const std::vector<rgb_color> &colors,
     constexpr int canvas_height = 600;
     constexpr int margin_x = 40;
     constexpr int margin_y = 40;
-    constexpr int gap = 8;
+    constexpr int small_layout_max = 25;
 
     const int total = static_cast<int>(colors.size());
-    const int cols = std::min(5, total);
-    const int rows = (total + cols - 1) / cols;
-
     const int available_width = canvas_width - (margin_x * 2);
     const int available_height = canvas_height - (margin_y * 2);
+
+    // Up to 25 colors keep rows of five. Larger palettes switch to a
+    // near-square grid matching the canvas aspect, with thinner gaps and
+    // numbers only when they fit.
+    const bool large = total > small_layout_max;
+    const int gap = large ? 3 : 8;
+    const int cols =
+        large ? static_cast<int>(std::ceil(
+                    std::sqrt(static_cast<double>(total) * available_width /
+                              available_height)))
+              : std::min(5, total);
+    const int rows = (total + cols - 1) / cols;
+
     const int swatch_width =
         (available_width - (cols - 1) * gap) / std::max(cols, 1);
     const int swatch_height =
         (available_height - (rows - 1) * gap) / std::max(rows, 1);
 
     image img = make_image(canvas_width, canvas_height, {255, 255, 255});
-    const int digit_scale =
+    int digit_scale =
         std::clamp(std::min(swatch_width / 6, swatch_height / 8), 3, 12);
+    if (large) {
+        const int digits = static_cast<int>(std::to_string(total).size());
+        digit_scale = std::min(swatch_width / (digits * 4),
+                               swatch_height / 7);
+        include_numbers = include_numbers && digit_scale >= 1;
+    }
 
     for (int i = 0; i < total; ++i) {
         const int row = i / cols;
@@ -622,6 +638,206 @@ std::string generate_palette_image(const std::vector<rgb_color> &colors,
     return encode_png(img);
 }
 
+std::string generate_gradient_image(const std::vector<rgb_color> &strip,
+                                    const std::vector<rgb_color> &swatches) {
+    if (strip.empty()) {
+        return std::string();
+    }
+
+    constexpr int margin_x = 40;
+    constexpr int margin_y = 40;
+    constexpr int strip_height = 160;
+    constexpr int section_gap = 24;
+    constexpr int swatch_height = 136;
+    constexpr int gap = 4;
+
+    const int strip_width = static_cast<int>(strip.size());
+    const int canvas_width = strip_width + 2 * margin_x;
+    const int canvas_height =
+        margin_y * 2 + strip_height + section_gap + swatch_height;
+    image img = make_image(canvas_width, canvas_height, {255, 255, 255});
+
+    const size_t row_bytes = static_cast<size_t>(canvas_width) * 4;
+    uint8_t *const first_row =
+        img.pixels.data() + static_cast<size_t>(margin_y) * row_bytes;
+    for (int x = 0; x < strip_width; ++x) {
+        uint8_t *px = first_row + static_cast<size_t>(margin_x + x) * 4;
+        px[0] = strip[static_cast<size_t>(x)].r;
+        px[1] = strip[static_cast<size_t>(x)].g;
+        px[2] = strip[static_cast<size_t>(x)].b;
+        px[3] = 255;
+    }
+    for (int y = 1; y < strip_height; ++y) {
+        std::copy(first_row, first_row + row_bytes,
+                  first_row + static_cast<size_t>(y) * row_bytes);
+    }
+
+    const int count = static_cast<int>(swatches.size());
+    if (count == 0) {
+        return encode_png(img);
+    }
+
+    // Many steps leave no room for gaps; they then tile edge to edge.
+    const int swatch_gap = count * gap * 4 <= strip_width ? gap : 0;
+    const int top = margin_y + strip_height + section_gap;
+    const int width_without_gaps = strip_width - (count - 1) * swatch_gap;
+    const int digit_scale = std::clamp(width_without_gaps / count / 8, 2, 8);
+    const bool numbered = width_without_gaps / count >= 24;
+    for (int i = 0; i < count; ++i) {
+        const int x0 =
+            margin_x + i * width_without_gaps / count + i * swatch_gap;
+        const int x1 =
+            margin_x + (i + 1) * width_without_gaps / count + i * swatch_gap;
+        const rgb_color swatch = swatches[static_cast<size_t>(i)];
+        fill_rect(img, x0, top, x1 - x0, swatch_height, swatch);
+        if (numbered) {
+            draw_number(img, i + 1, (x0 + x1) / 2, top + swatch_height / 2,
+                        digit_scale, number_color(swatch));
+        }
+    }
+
+    return encode_png(img);
+}
+
+std::string generate_heatmap_image(const std::vector<rgb_color> &row_headers,
+                                   const std::vector<rgb_color> &column_headers,
+                                   const std::vector<heatmap_cell> &cells) {
+    const int rows = static_cast<int>(row_headers.size());
+    const int cols = static_cast<int>(column_headers.size());
+    if (rows == 0 || cols == 0 ||
+        cells.size() != row_headers.size() * column_headers.size()) {
+        return std::string();
+    }
+
+    constexpr int margin = 24;
+    constexpr int max_grid = 1100;
+    constexpr int gap = 2;
+
+    const int cell = std::clamp(max_grid / (std::max(rows, cols) + 1), 24, 120);
+    const int header = cell;
+    const int canvas_width = 2 * margin + header + cols * (cell + gap);
+    const int canvas_height = 2 * margin + header + rows * (cell + gap);
+    image img = make_image(canvas_width, canvas_height, {255, 255, 255});
+
+    const int grid_x = margin + header + gap;
+    const int grid_y = margin + header + gap;
+    const int number_scale = std::clamp(cell / 16, 1, 4);
+    for (int col = 0; col < cols; ++col) {
+        const int x = grid_x + col * (cell + gap);
+        const rgb_color swatch = column_headers[static_cast<size_t>(col)];
+        fill_rect(img, x, margin, cell, header, swatch);
+        draw_number(img, col + 1, x + cell / 2, margin + header / 2,
+                    number_scale, number_color(swatch));
+    }
+    for (int row = 0; row < rows; ++row) {
+        const int y = grid_y + row * (cell + gap);
+        const rgb_color swatch = row_headers[static_cast<size_t>(row)];
+        fill_rect(img, margin, y, header, cell, swatch);
+        draw_number(img, row + 1, margin + header / 2, y + cell / 2,
+                    number_scale, number_color(swatch));
+    }
+
+    const int text_scale = std::clamp(cell / 30, 1, 3);
+    const int line_height = 7 * text_scale;
+    const int line_gap = std::max(2, text_scale * 2);
+    for (int row = 0; row < rows; ++row) {
+        for (int col = 0; col < cols; ++col) {
+            const heatmap_cell &entry =
+                cells[static_cast<size_t>(row * cols + col)];
+            const int x = grid_x + col * (cell + gap);
+            const int y = grid_y + row * (cell + gap);
+            fill_rect(img, x, y, cell, cell, entry.fill);
+
+            const rgb_color ink = number_color(entry.fill);
+            const bool show_mark =
+                !entry.mark.empty() &&
+                2 * line_height + line_gap <= cell - 4 &&
+                text_line_width(entry.mark, text_scale) <= cell - 4;
+            const int block_height =
+                show_mark ? 2 * line_height + line_gap : line_height;
+            int text_y = y + (cell - block_height) / 2;
+            if (text_line_width(entry.value, text_scale) <= cell - 4) {
+                draw_text_line(
+                    img, entry.value,
+                    x + (cell - text_line_width(entry.value, text_scale)) / 2,
+                    text_y, text_scale, ink);
+            }
+            if (show_mark) {
+                text_y += line_height + line_gap;
+                draw_text_line(
+                    img, entry.mark,
+                    x + (cell - text_line_width(entry.mark, text_scale)) / 2,
+                    text_y, text_scale, ink);
+            }
+        }
+    }
+
+    return encode_png(img);
+}
+
+std::string generate_comparison_palette_image(
+    const std::vector<std::vector<rgb_color>> &left,
+    const std::vector<std::vector<rgb_color>> &right,
+    std::string_view left_label, std::string_view right_label,
+    bool number_continuously) {
+    size_t cols = 0;
+    for (const auto &row : left) {
+        cols = std::max(cols, row.size());
+    }
+    if (left.empty() || cols == 0) {
+        return std::string();
+    }
+
+    constexpr int canvas_width = 1200;
+    constexpr int canvas_height = 600;
+    constexpr int margin_x = 40;
+    constexpr int margin_y = 40;
+    constexpr int panel_gap = 40;
+    constexpr int gap = 8;
+    constexpr int label_scale = 3;
+    constexpr int label_height = 7 * label_scale;
+    constexpr int label_gap = 16;
+
+    const int rows = static_cast<int>(left.size());
+    const int columns = static_cast<int>(cols);
+    const int panel_width = (canvas_width - 2 * margin_x - panel_gap) / 2;
+    const int grid_top = margin_y + label_height + label_gap;
+    const int available_height = canvas_height - grid_top - margin_y;
+    const int swatch_width = (panel_width - (columns - 1) * gap) / columns;
+    const int swatch_height = (available_height - (rows - 1) * gap) / rows;
+
+    image img = make_image(canvas_width, canvas_height, {255, 255, 255});
+    const int digit_scale =
+        std::clamp(std::min(swatch_width / 6, swatch_height / 8), 2, 12);
+
+    const auto draw_panel = [&](const std::vector<std::vector<rgb_color>> &grid,
+                                std::string_view label, int panel_x) {
+        const int label_width = text_line_width(label, label_scale);
+        draw_text_line(img, label, panel_x + (panel_width - label_width) / 2,
+                       margin_y, label_scale, {40, 40, 40});
+
+        int number = 0;
+        for (int row = 0; row < rows && row < static_cast<int>(grid.size());
+             ++row) {
+            const auto &line = grid[static_cast<size_t>(row)];
+            for (int col = 0; col < static_cast<int>(line.size()); ++col) {
+                const int x = panel_x + col * (swatch_width + gap);
+                const int y = grid_top + row * (swatch_height + gap);
+                const rgb_color swatch = line[static_cast<size_t>(col)];
+                fill_rect(img, x, y, swatch_width, swatch_height, swatch);
+                ++number;
+                draw_number(img, number_continuously ? number : col + 1,
+                            x + swatch_width / 2, y + swatch_height / 2,
+                            digit_scale, number_color(swatch));
+            }
+        }
+    };
+
+    draw_panel(left, left_label, margin_x);
+    draw_panel(right, right_label, margin_x + panel_width + panel_gap);
+    return encode_png(img);
+}
+
 std::string
 generate_text_on_background_image(const std::vector<std::string> &lines,
                                   rgb_color text_color,
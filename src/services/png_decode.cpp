@@ -0,0 +1,910 @@
+#include "palette/services/image_decode.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+
+namespace palette::services {
+namespace {
+constexpr size_t kWindowSize = 32768;
+constexpr size_t kFlushThreshold = 8 * kWindowSize;
+constexpr int kFastBits = 9;
+
+constexpr std::array<uint16_t, 29> kLengthBase = {
+    3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+    31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr std::array<uint8_t, 29> kLengthExtra = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+    2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr std::array<uint16_t, 30> kDistanceBase = {
+    1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+    33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+    1025, 1537, 2049, 3073, 4097, 6145,  8193,  12289, 16385, 24577};
+constexpr std::array<uint8_t, 30> kDistanceExtra = {
+    0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+    6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+constexpr std::array<uint8_t, 19> kCodeLengthOrder = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+using input_source = std::function<std::string_view()>;
+
+// Deflate packs bits LSB first. Input arrives in pieces, read in place.
+class bit_reader {
+  public:
+    explicit bit_reader(const input_source &next_input)
+        : next_input_(next_input) {}
+
+    bool read(int count, uint32_t &out) {
+        if (!fill(count)) {
+            return false;
+        }
+        out = static_cast<uint32_t>(buffer_ & ((1ULL << count) - 1));
+        consume(count);
+        return true;
+    }
+
+    // Peeks up to `count` bits, padding with zeros past the end of input.
+    uint32_t peek(int count) {
+        fill(count);
+        return static_cast<uint32_t>(buffer_ & ((1ULL << count) - 1));
+    }
+
+    bool consume(int count) {
+        if (count > available_) {
+            return false;
+        }
+        buffer_ >>= count;
+        available_ -= count;
+        return true;
+    }
+
+    void align_to_byte() { consume(available_ % 8); }
+
+    bool read_bytes(size_t count, std::vector<uint8_t> &out) {
+        // Only valid after align_to_byte(); buffered bytes come first.
+        for (; count > 0 && available_ >= 8; --count) {
+            out.push_back(static_cast<uint8_t>(buffer_));
+            consume(8);
+        }
+        while (count > 0) {
+            if (!next_piece()) {
+                return false;
+            }
+            const size_t take = std::min(count, current_.size() - position_);
+            const auto *from =
+                reinterpret_cast<const uint8_t *>(current_.data()) + position_;
+            out.insert(out.end(), from, from + take);
+            position_ += take;
+            count -= take;
+        }
+        return true;
+    }
+
+  private:
+    // Moves on once the current piece is used up; false at the end.
+    bool next_piece() {
+        if (position_ < current_.size()) {
+            return true;
+        }
+        if (ended_) {
+            return false;
+        }
+        current_ = next_input_();
+        position_ = 0;
+        ended_ = current_.empty();
+        return !ended_;
+    }
+
+    bool fill(int count) {
+        while (available_ < count) {
+            if (!next_piece()) {
+                return false;
+            }
+            buffer_ |= static_cast<uint64_t>(
+                           static_cast<uint8_t>(current_[position_++]))
+                       << available_;
+            available_ += 8;
+        }
+        return true;
+    }
+
+    const input_source &next_input_;
+    std::string_view current_;
+    bool ended_ = false;
+    size_t position_ = 0;
+    uint64_t buffer_ = 0;
+    int available_ = 0;
+};
+
+struct huffman_table {
+    // Entries are (symbol << 4) | length; zero means "use the slow path".
+    std::array<uint16_t, 1 << kFastBits> fast{};
+    std::array<uint16_t, 16> count{};
+    std::array<uint16_t, 288> symbols{};
+
+    bool build(const uint8_t *lengths, int n) {
+        fast.fill(0);
+        count.fill(0);
+        for (int i = 0; i < n; ++i) {
+            ++count[lengths[i]];
+        }
+        count[0] = 0;
+
+        int left = 1;
+        for (int len = 1; len < 16; ++len) {
+            left <<= 1;
+            left -= count[len];
+            if (left < 0) {
+                return false;
+            }
+        }
+
+        std::array<uint16_t, 16> offsets{};
+        for (int len = 1; len < 15; ++len) {
+            offsets[len + 1] = offsets[len] + count[len];
+        }
+        for (int i = 0; i < n; ++i) {
+            if (lengths[i] != 0) {
+                symbols[offsets[lengths[i]]++] = static_cast<uint16_t>(i);
+            }
+        }
+
+        // Canonical codes, bit-reversed so they can index the LSB-first
+        // lookahead directly.
+        uint32_t code = 0;
+        int index = 0;
+        for (int len = 1; len <= kFastBits; ++len) {
+            for (int i = 0; i < count[len]; ++i, ++index, ++code) {
+                uint32_t reversed = 0;
+                for (int bit = 0; bit < len; ++bit) {
+                    reversed |= ((code >> bit) & 1U) << (len - 1 - bit);
+                }
+                for (uint32_t fill = reversed; fill < fast.size();
+                     fill += 1U << len) {
+                    fast[fill] =
+                        static_cast<uint16_t>((symbols[index] << 4) | len);
+                }
+            }
+            code <<= 1;
+        }
+        return true;
+    }
+
+    int decode(bit_reader &bits) const {
+        const uint16_t entry = fast[bits.peek(kFastBits)];
+        if (entry != 0) {
+            return bits.consume(entry & 0xF) ? entry >> 4 : -1;
+        }
+
+        int code = 0;
+        int first = 0;
+        int index = 0;
+        for (int len = 1; len < 16; ++len) {
+            uint32_t bit = 0;
+            if (!bits.read(1, bit)) {
+                return -1;
+            }
+            code |= static_cast<int>(bit);
+            const int n = count[len];
+            if (code - n < first) {
+                return symbols[index + (code - first)];
+            }
+            index += n;
+            first += n;
+            first <<= 1;
+            code <<= 1;
+        }
+        return -1;
+    }
+};
+
+class inflater {
+  public:
+    inflater(const input_source &next_input,
+             const std::function<bool(const uint8_t *, size_t)> &sink)
+        : bits_(next_input), sink_(sink) {
+        window_.reserve(kFlushThreshold + 512);
+    }
+
+    bool run() {
+        uint32_t cmf = 0;
+        uint32_t flg = 0;
+        if (!bits_.read(8, cmf) || !bits_.read(8, flg) || (cmf & 0x0F) != 8 ||
+            ((cmf << 8) | flg) % 31 != 0 || (flg & 0x20)) {
+            return false;
+        }
+
+        uint32_t final_block = 0;
+        do {
+            uint32_t type = 0;
+            if (!bits_.read(1, final_block) || !bits_.read(2, type)) {
+                return false;
+            }
+
+            bool ok = false;
+            if (type == 0) {
+                ok = stored_block();
+            } else if (type == 1) {
+                ok = fixed_block();
+            } else if (type == 2) {
+                ok = dynamic_block();
+            }
+            if (!ok) {
+                return false;
+            }
+            if (stopped_) {
+                return true;
+            }
+        } while (final_block == 0);
+
+        return flush(window_.size());
+    }
+
+  private:
+    bool flush(size_t count) {
+        if (count == 0 || stopped_) {
+            return true;
+        }
+        if (!sink_(window_.data(), count)) {
+            stopped_ = true;
+            return true;
+        }
+        window_.erase(window_.begin(),
+                      window_.begin() + static_cast<long>(count));
+        return true;
+    }
+
+    bool maybe_flush() {
+        if (window_.size() < kFlushThreshold) {
+            return true;
+        }
+        return flush(window_.size() - kWindowSize);
+    }
+
+    bool stored_block() {
+        bits_.align_to_byte();
+        uint32_t len = 0;
+        uint32_t nlen = 0;
+        if (!bits_.read(16, len) || !bits_.read(16, nlen) ||
+            len != (~nlen & 0xFFFF)) {
+            return false;
+        }
+
+        if (!bits_.read_bytes(len, window_)) {
+            return false;
+        }
+        return maybe_flush();
+    }
+
+    bool fixed_block() {
+        static const std::pair<huffman_table, huffman_table> tables = [] {
+            std::array<uint8_t, 288> lengths{};
+            std::fill(lengths.begin(), lengths.begin() + 144, 8);
+            std::fill(lengths.begin() + 144, lengths.begin() + 256, 9);
+            std::fill(lengths.begin() + 256, lengths.begin() + 280, 7);
+            std::fill(lengths.begin() + 280, lengths.end(), 8);
+            std::pair<huffman_table, huffman_table> out;
+            out.first.build(lengths.data(), 288);
+            std::array<uint8_t, 30> distances{};
+            distances.fill(5);
+            out.second.build(distances.data(), 30);
+            return out;
+        }();
+        return codes(tables.first, tables.second);
+    }
+
+    bool dynamic_block() {
+        uint32_t hlit = 0;
+        uint32_t hdist = 0;
+        uint32_t hclen = 0;
+        if (!bits_.read(5, hlit) || !bits_.read(5, hdist) ||
+            !bits_.read(4, hclen)) {
+            return false;
+        }
+        hlit += 257;
+        hdist += 1;
+        hclen += 4;
+        if (hlit > 286 || hdist > 30) {
+            return false;
+        }
+
+        std::array<uint8_t, 19> code_lengths{};
+        for (uint32_t i = 0; i < hclen; ++i) {
+            uint32_t len = 0;
+            if (!bits_.read(3, len)) {
+                return false;
+            }
+            code_lengths[kCodeLengthOrder[i]] = static_cast<uint8_t>(len);
+        }
+
+        huffman_table length_codes;
+        if (!length_codes.build(code_lengths.data(), 19)) {
+            return false;
+        }
+
+        std::array<uint8_t, 320> lengths{};
+        uint32_t index = 0;
+        while (index < hlit + hdist) {
+            const int symbol = length_codes.decode(bits_);
+            if (symbol < 0) {
+                return false;
+            }
+            if (symbol < 16) {
+                lengths[index++] = static_cast<uint8_t>(symbol);
+                continue;
+            }
+
+            uint8_t value = 0;
+            uint32_t repeat = 0;
+            if (symbol == 16) {
+                if (index == 0 || !bits_.read(2, repeat)) {
+                    return false;
+                }
+                value = lengths[index - 1];
+                repeat += 3;
+            } else if (symbol == 17) {
+                if (!bits_.read(3, repeat)) {
+                    return false;
+                }
+                repeat += 3;
+            } else {
+                if (!bits_.read(7, repeat)) {
+                    return false;
+                }
+                repeat += 11;
+            }
+            if (index + repeat > hlit + hdist) {
+                return false;
+            }
+            std::fill_n(lengths.begin() + index, repeat, value);
+            index += repeat;
+        }
+
+        if (lengths[256] == 0) {
+            return false;
+        }
+
+        huffman_table literal_codes;
+        huffman_table distance_codes;
+        if (!literal_codes.build(lengths.data(), static_cast<int>(hlit)) ||
+            !distance_codes.build(lengths.data() + hlit,
+                                  static_cast<int>(hdist))) {
+            return false;
+        }
+        return codes(literal_codes, distance_codes);
+    }
+
+    bool codes(const huffman_table &literals, const huffman_table &distances) {
+        while (true) {
+            const int symbol = literals.decode(bits_);
+            if (symbol < 0) {
+                return false;
+            }
+            if (symbol < 256) {
+                window_.push_back(static_cast<uint8_t>(symbol));
+            } else if (symbol == 256) {
+                return true;
+            } else {
+                const int length_index = symbol - 257;
+                if (length_index >= static_cast<int>(kLengthBase.size())) {
+                    return false;
+                }
+                uint32_t extra = 0;
+                if (!bits_.read(kLengthExtra[length_index], extra)) {
+                    return false;
+                }
+                const size_t length = kLengthBase[length_index] + extra;
+
+                const int distance_index = distances.decode(bits_);
+                if (distance_index < 0 ||
+                    distance_index >= static_cast<int>(kDistanceBase.size())) {
+                    return false;
+                }
+                if (!bits_.read(kDistanceExtra[distance_index], extra)) {
+                    return false;
+                }
+                const size_t distance = kDistanceBase[distance_index] + extra;
+                if (distance > window_.size()) {
+                    return false;
+                }
+
+                const size_t from = window_.size() - distance;
+                for (size_t i = 0; i < length; ++i) {
+                    window_.push_back(window_[from + i]);
+                }
+            }
+
+            if (!maybe_flush()) {
+                return false;
+            }
+            if (stopped_) {
+                return true;
+            }
+        }
+    }
+
+    bit_reader bits_;
+    const std::function<bool(const uint8_t *, size_t)> &sink_;
+    std::vector<uint8_t> window_;
+    bool stopped_ = false;
+};
+
+uint32_t read_u32_be(const uint8_t *p) {
+    return (static_cast<uint32_t>(p[0]) << 24) |
+           (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+struct png_header {
+    int width = 0;
+    int height = 0;
+    int bit_depth = 0;
+    int color_type = 0;
+    bool interlaced = false;
+    int channels = 0;
+};
+
+struct adam7_pass {
+    int x0;
+    int y0;
+    int dx;
+    int dy;
+};
+
+constexpr std::array<adam7_pass, 7> kAdam7 = {{{0, 0, 8, 8},
+                                               {4, 0, 8, 8},
+                                               {0, 4, 4, 8},
+                                               {2, 0, 4, 4},
+                                               {0, 2, 2, 4},
+                                               {1, 0, 2, 2},
+                                               {0, 1, 1, 2}}};
+
+int channels_for(int color_type) {
+    switch (color_type) {
+    case 0:
+    case 3:
+        return 1;
+    case 2:
+        return 3;
+    case 4:
+        return 2;
+    case 6:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+bool valid_depth(int color_type, int depth) {
+    switch (color_type) {
+    case 0:
+        return depth == 1 || depth == 2 || depth == 4 || depth == 8 ||
+               depth == 16;
+    case 3:
+        return depth == 1 || depth == 2 || depth == 4 || depth == 8;
+    case 2:
+    case 4:
+    case 6:
+        return depth == 8 || depth == 16;
+    default:
+        return false;
+    }
+}
+
+uint8_t paeth(uint8_t a, uint8_t b, uint8_t c) {
+    const int p = static_cast<int>(a) + b - c;
+    const int pa = std::abs(p - a);
+    const int pb = std::abs(p - b);
+    const int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) {
+        return a;
+    }
+    return pb <= pc ? b : c;
+}
+
+// Receives the inflated stream, undoes the per-row filters and samples
+// pixels on the stride grid. Only the current and previous rows are kept.
+class png_row_sampler {
+  public:
+    png_row_sampler(const png_header &header,
+                    const std::vector<rgb_color> &palette,
+                    const std::vector<uint8_t> &palette_alpha,
+                    const std::array<uint16_t, 3> *transparent_key,
+                    int stride, std::vector<rgb_color> &out)
+        : header_(header), palette_(palette), palette_alpha_(palette_alpha),
+          transparent_key_(transparent_key), stride_(stride), out_(out) {
+        bytes_per_pixel_ =
+            std::max(1, header_.channels * header_.bit_depth / 8);
+        pass_ = header_.interlaced ? -1 : 0;
+        next_pass();
+    }
+
+    bool feed(const uint8_t *data, size_t size) {
+        while (size > 0 && !done_) {
+            const size_t take = std::min(size, current_.size() - filled_);
+            std::memcpy(current_.data() + filled_, data, take);
+            filled_ += take;
+            data += take;
+            size -= take;
+
+            if (filled_ == current_.size()) {
+                if (!finish_row()) {
+                    return false;
+                }
+            }
+        }
+        return !done_;
+    }
+
+    bool complete() const { return done_; }
+
+  private:
+    void next_pass() {
+        while (true) {
+            if (header_.interlaced) {
+                ++pass_;
+                if (pass_ >= static_cast<int>(kAdam7.size())) {
+                    done_ = true;
+                    return;
+                }
+                const adam7_pass &p = kAdam7[pass_];
+                x0_ = p.x0;
+                y0_ = p.y0;
+                dx_ = p.dx;
+                dy_ = p.dy;
+            } else if (started_) {
+                done_ = true;
+                return;
+            } else {
+                x0_ = 0;
+                y0_ = 0;
+                dx_ = 1;
+                dy_ = 1;
+            }
+            started_ = true;
+
+            pass_width_ = (header_.width - x0_ + dx_ - 1) / dx_;
+            pass_height_ = (header_.height - y0_ + dy_ - 1) / dy_;
+            if (pass_width_ <= 0 || pass_height_ <= 0) {
+                continue;
+            }
+
+            const size_t row_bytes =
+                (static_cast<size_t>(pass_width_) * header_.channels *
+                     header_.bit_depth +
+                 7) /
+                8;
+            current_.assign(row_bytes + 1, 0);
+            previous_.assign(row_bytes + 1, 0);
+            filled_ = 0;
+            row_ = 0;
+            return;
+        }
+    }
+
+    bool finish_row() {
+        if (!unfilter()) {
+            return false;
+        }
+
+        const int y = y0_ + row_ * dy_;
+        if (y % stride_ == 0) {
+            sample_row();
+        }
+
+        std::swap(current_, previous_);
+        filled_ = 0;
+        ++row_;
+        if (row_ >= pass_height_) {
+            next_pass();
+        }
+        return true;
+    }
+
+    bool unfilter() {
+        uint8_t *row = current_.data() + 1;
+        const uint8_t *prior = previous_.data() + 1;
+        const size_t length = current_.size() - 1;
+        const size_t bpp = static_cast<size_t>(bytes_per_pixel_);
+
+        switch (current_[0]) {
+        case 0:
+            return true;
+        case 1:
+            for (size_t i = bpp; i < length; ++i) {
+                row[i] = static_cast<uint8_t>(row[i] + row[i - bpp]);
+            }
+            return true;
+        case 2:
+            for (size_t i = 0; i < length; ++i) {
+                row[i] = static_cast<uint8_t>(row[i] + prior[i]);
+            }
+            return true;
+        case 3:
+            for (size_t i = 0; i < length; ++i) {
+                const int left = i >= bpp ? row[i - bpp] : 0;
+                row[i] =
+                    static_cast<uint8_t>(row[i] + ((left + prior[i]) >> 1));
+            }
+            return true;
+        case 4:
+            for (size_t i = 0; i < length; ++i) {
+                const uint8_t left = i >= bpp ? row[i - bpp] : 0;
+                const uint8_t up_left = i >= bpp ? prior[i - bpp] : 0;
+                row[i] = static_cast<uint8_t>(row[i] +
+                                              paeth(left, prior[i], up_left));
+            }
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    uint16_t read_sample(const uint8_t *row, int index) const {
+        const int depth = header_.bit_depth;
+        if (depth == 8) {
+            return row[index];
+        }
+        if (depth == 16) {
+            return static_cast<uint16_t>((row[index * 2] << 8) |
+                                         row[index * 2 + 1]);
+        }
+        const int bit = index * depth;
+        const int shift = 8 - depth - (bit % 8);
+        return static_cast<uint16_t>((row[bit / 8] >> shift) &
+                                     ((1 << depth) - 1));
+    }
+
+    uint8_t scale_sample(uint16_t value) const {
+        switch (header_.bit_depth) {
+        case 1:
+            return value ? 255 : 0;
+        case 2:
+            return static_cast<uint8_t>(value * 85);
+        case 4:
+            return static_cast<uint8_t>(value * 17);
+        case 16:
+            return static_cast<uint8_t>(value >> 8);
+        default:
+            return static_cast<uint8_t>(value);
+        }
+    }
+
+    void sample_row() {
+        const uint8_t *row = current_.data() + 1;
+        const int channels = header_.channels;
+
+        for (int px = 0; px < pass_width_; ++px) {
+            const int x = x0_ + px * dx_;
+            if (x % stride_ != 0) {
+                continue;
+            }
+
+            const int base = px * channels;
+            rgb_color color{};
+            bool opaque = true;
+            switch (header_.color_type) {
+            case 0: {
+                const uint16_t gray = read_sample(row, base);
+                const uint8_t v = scale_sample(gray);
+                color = {v, v, v};
+                opaque = !transparent_key_ || (*transparent_key_)[0] != gray;
+                break;
+            }
+            case 2: {
+                const uint16_t r = read_sample(row, base);
+                const uint16_t g = read_sample(row, base + 1);
+                const uint16_t b = read_sample(row, base + 2);
+                color = {scale_sample(r), scale_sample(g), scale_sample(b)};
+                opaque = !transparent_key_ ||
+                         !((*transparent_key_)[0] == r &&
+                           (*transparent_key_)[1] == g &&
+                           (*transparent_key_)[2] == b);
+                break;
+            }
+            case 3: {
+                const uint16_t index = read_sample(row, base);
+                if (index >= palette_.size()) {
+                    continue;
+                }
+                color = palette_[index];
+                opaque = index >= palette_alpha_.size() ||
+                         palette_alpha_[index] >= 128;
+                break;
+            }
+            case 4: {
+                const uint8_t v = scale_sample(read_sample(row, base));
+                color = {v, v, v};
+                opaque = scale_sample(read_sample(row, base + 1)) >= 128;
+                break;
+            }
+            case 6:
+                color = {scale_sample(read_sample(row, base)),
+                         scale_sample(read_sample(row, base + 1)),
+                         scale_sample(read_sample(row, base + 2))};
+                opaque = scale_sample(read_sample(row, base + 3)) >= 128;
+                break;
+            default:
+                break;
+            }
+
+            if (opaque) {
+                out_.push_back(color);
+            }
+        }
+    }
+
+    const png_header &header_;
+    const std::vector<rgb_color> &palette_;
+    const std::vector<uint8_t> &palette_alpha_;
+    const std::array<uint16_t, 3> *transparent_key_;
+    int stride_;
+    std::vector<rgb_color> &out_;
+
+    int bytes_per_pixel_ = 1;
+    int pass_ = 0;
+    bool started_ = false;
+    bool done_ = false;
+    int x0_ = 0;
+    int y0_ = 0;
+    int dx_ = 1;
+    int dy_ = 1;
+    int pass_width_ = 0;
+    int pass_height_ = 0;
+    int row_ = 0;
+    std::vector<uint8_t> current_;
+    std::vector<uint8_t> previous_;
+    size_t filled_ = 0;
+};
+} // namespace
+
+bool zlib_inflate(const std::function<std::string_view()> &next_input,
+                  const std::function<bool(const uint8_t *, size_t)> &sink) {
+    inflater decoder(next_input, sink);
+    return decoder.run();
+}
+
+image_sample_result sample_png_pixels(std::string_view data,
+                                      size_t max_samples) {
+    image_sample_result result;
+    const auto *bytes = reinterpret_cast<const uint8_t *>(data.data());
+
+    png_header header;
+    std::vector<rgb_color> palette;
+    std::vector<uint8_t> palette_alpha;
+    std::array<uint16_t, 3> transparent_key{};
+    bool has_transparent_key = false;
+    // IDAT chunks are inflated in place, starting from the first one.
+    size_t first_idat = 0;
+
+    size_t offset = 8;
+    bool seen_header = false;
+    bool seen_end = false;
+    while (offset + 12 <= data.size() && !seen_end) {
+        const uint32_t length = read_u32_be(bytes + offset);
+        if (length > data.size() - offset - 12) {
+            result.error = "The PNG file is truncated.";
+            return result;
+        }
+
+        const std::string_view type = data.substr(offset + 4, 4);
+        const uint8_t *chunk = bytes + offset + 8;
+        offset += 12 + length;
+
+        if (type == "IHDR") {
+            if (length != 13) {
+                result.error = "The PNG header is invalid.";
+                return result;
+            }
+            header.width = static_cast<int>(
+                std::min<uint32_t>(read_u32_be(chunk), 1U << 30));
+            header.height = static_cast<int>(
+                std::min<uint32_t>(read_u32_be(chunk + 4), 1U << 30));
+            header.bit_depth = chunk[8];
+            header.color_type = chunk[9];
+            header.interlaced = chunk[12] == 1;
+            header.channels = channels_for(header.color_type);
+            if (chunk[10] != 0 || chunk[11] != 0 || chunk[12] > 1 ||
+                header.channels == 0 ||
+                !valid_depth(header.color_type, header.bit_depth)) {
+                result.error = "Unsupported PNG pixel format.";
+                return result;
+            }
+            seen_header = true;
+        } else if (type == "PLTE") {
+            for (uint32_t i = 0; i + 2 < length && palette.size() < 256;
+                 i += 3) {
+                palette.push_back({chunk[i], chunk[i + 1], chunk[i + 2]});
+            }
+        } else if (type == "tRNS") {
+            if (header.color_type == 3) {
+                palette_alpha.assign(chunk, chunk + std::min(length, 256U));
+            } else if (header.color_type == 0 && length >= 2) {
+                transparent_key[0] =
+                    static_cast<uint16_t>((chunk[0] << 8) | chunk[1]);
+                has_transparent_key = true;
+            } else if (header.color_type == 2 && length >= 6) {
+                for (int i = 0; i < 3; ++i) {
+                    transparent_key[i] = static_cast<uint16_t>(
+                        (chunk[i * 2] << 8) | chunk[i * 2 + 1]);
+                }
+                has_transparent_key = true;
+            }
+        } else if (type == "IDAT") {
+            if (length > 0 && first_idat == 0) {
+                first_idat = offset - 12 - length;
+            }
+        } else if (type == "IEND") {
+            seen_end = true;
+        }
+    }
+
+    if (!seen_header || first_idat == 0) {
+        result.error = "The PNG file has no image data.";
+        return result;
+    }
+    if (header.width <= 0 || header.height <= 0 ||
+        header.width > kMaxDecodeDimension ||
+        header.height > kMaxDecodeDimension ||
+        static_cast<uint64_t>(header.width) * header.height >
+            kMaxDecodePixels) {
+        result.error = "The image is too large.";
+        return result;
+    }
+    if (header.color_type == 3 && palette.empty()) {
+        result.error = "The PNG palette is missing.";
+        return result;
+    }
+
+    const int stride = sample_stride(header.width, header.height, max_samples);
+    result.width = header.width;
+    result.height = header.height;
+    result.samples.reserve(max_samples + max_samples / 4);
+
+    png_row_sampler sampler(header, palette, palette_alpha,
+                            has_transparent_key ? &transparent_key : nullptr,
+                            stride, result.samples);
+    // Every chunk up to IEND was bounds-checked above.
+    size_t next_chunk = first_idat;
+    const auto next_idat = [&data, bytes, &next_chunk]() -> std::string_view {
+        while (next_chunk + 12 <= data.size()) {
+            const uint32_t length = read_u32_be(bytes + next_chunk);
+            const std::string_view type = data.substr(next_chunk + 4, 4);
+            const size_t body = next_chunk + 8;
+            next_chunk += 12 + length;
+            if (type == "IEND") {
+                break;
+            }
+            if (type == "IDAT" && length > 0) {
+                return data.substr(body, length);
+            }
+        }
+        next_chunk = data.size();
+        return {};
+    };
+
+    bool bad_row = false;
+    const bool inflated = zlib_inflate(
+        next_idat, [&sampler, &bad_row](const uint8_t *chunk, size_t size) {
+            if (!sampler.feed(chunk, size)) {
+                bad_row = !sampler.complete();
+                return false;
+            }
+            return true;
+        });
+
+    if (!inflated || bad_row || !sampler.complete()) {
+        result.error = "The PNG image data is corrupt.";
+        result.samples.clear();
+        return result;
+    }
+    if (result.samples.empty()) {
+        result.error = "The image has no opaque pixels.";
+        return result;
+    }
+
+    result.ok = true;
+    return result;
+}
+
+} // namespace palette::services
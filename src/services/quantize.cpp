@@ -0,0 +1,246 @@
+#include "palette/services/quantize.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+
+namespace palette::services {
+namespace {
+constexpr int kCellBits = 5;
+constexpr int kCellsPerAxis = 1 << kCellBits;
+constexpr int kCellWidth = 256 / kCellsPerAxis;
+constexpr size_t kCellCount =
+    static_cast<size_t>(kCellsPerAxis) * kCellsPerAxis * kCellsPerAxis;
+constexpr size_t kMaxCachedLuts = 64;
+
+std::mutex lut_mutex;
+std::unordered_map<uint64_t, std::shared_ptr<const palette_lut>> lut_by_hash;
+std::deque<uint64_t> lut_insertion_order;
+
+size_t cell_index(int r, int g, int b) {
+    return (static_cast<size_t>(r) << (2 * kCellBits)) |
+           (static_cast<size_t>(g) << kCellBits) | static_cast<size_t>(b);
+}
+
+int squared_distance(rgb_color a, rgb_color b) {
+    const int dr = static_cast<int>(a.r) - static_cast<int>(b.r);
+    const int dg = static_cast<int>(a.g) - static_cast<int>(b.g);
+    const int db = static_cast<int>(a.b) - static_cast<int>(b.b);
+    return dr * dr + dg * dg + db * db;
+}
+
+// Per-axis squared distance from one channel value to the nearest and the
+// farthest point of every cell slab. Distances in the cube are separable, so
+// the 3D bounds of a cell are the sum of three table reads.
+struct axis_bounds {
+    std::array<int, kCellsPerAxis> near;
+    std::array<int, kCellsPerAxis> far;
+};
+
+axis_bounds make_axis_bounds(uint8_t value) {
+    axis_bounds out{};
+    for (int cell = 0; cell < kCellsPerAxis; ++cell) {
+        const int lo = cell * kCellWidth;
+        const int hi = lo + kCellWidth - 1;
+        const int v = static_cast<int>(value);
+        const int near = v < lo ? lo - v : (v > hi ? v - hi : 0);
+        const int far = std::max(std::abs(v - lo), std::abs(v - hi));
+        out.near[cell] = near * near;
+        out.far[cell] = far * far;
+    }
+    return out;
+}
+
+rgb_color from_hex(uint32_t value) {
+    return {static_cast<uint8_t>((value >> 16) & 0xFF),
+            static_cast<uint8_t>((value >> 8) & 0xFF),
+            static_cast<uint8_t>(value & 0xFF)};
+}
+
+std::vector<rgb_color> make_web_safe_palette() {
+    std::vector<rgb_color> out;
+    out.reserve(216);
+    for (int r = 0; r < 6; ++r) {
+        for (int g = 0; g < 6; ++g) {
+            for (int b = 0; b < 6; ++b) {
+                out.push_back({static_cast<uint8_t>(r * 51),
+                               static_cast<uint8_t>(g * 51),
+                               static_cast<uint8_t>(b * 51)});
+            }
+        }
+    }
+    return out;
+}
+
+std::vector<rgb_color>
+make_hex_palette(std::initializer_list<uint32_t> values) {
+    std::vector<rgb_color> out;
+    out.reserve(values.size());
+    for (const uint32_t value : values) {
+        out.push_back(from_hex(value));
+    }
+    return out;
+}
+} // namespace
+
+uint64_t hash_palette(const std::vector<rgb_color> &targets) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (const rgb_color value : targets) {
+        for (const uint8_t byte : {value.r, value.g, value.b}) {
+            hash ^= byte;
+            hash *= 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+std::shared_ptr<const palette_lut>
+build_palette_lut(const std::vector<rgb_color> &targets) {
+    if (targets.empty() || targets.size() > kMaxQuantizePaletteSize) {
+        return nullptr;
+    }
+
+    auto lut = std::make_shared<palette_lut>();
+    lut->targets = targets;
+    lut->hash = hash_palette(targets);
+    lut->cell_offsets.reserve(kCellCount + 1);
+    lut->candidates.reserve(kCellCount * 2);
+
+    const size_t count = targets.size();
+    std::vector<axis_bounds> r_bounds(count);
+    std::vector<axis_bounds> g_bounds(count);
+    std::vector<axis_bounds> b_bounds(count);
+    for (size_t i = 0; i < count; ++i) {
+        r_bounds[i] = make_axis_bounds(targets[i].r);
+        g_bounds[i] = make_axis_bounds(targets[i].g);
+        b_bounds[i] = make_axis_bounds(targets[i].b);
+    }
+
+    std::vector<int> near(count);
+    for (int r = 0; r < kCellsPerAxis; ++r) {
+        for (int g = 0; g < kCellsPerAxis; ++g) {
+            for (int b = 0; b < kCellsPerAxis; ++b) {
+                lut->cell_offsets.push_back(
+                    static_cast<uint32_t>(lut->candidates.size()));
+
+                // An entry can only win inside this cell if its closest
+                // point is no farther than the best worst-case distance.
+                int best_far = std::numeric_limits<int>::max();
+                for (size_t i = 0; i < count; ++i) {
+                    near[i] = r_bounds[i].near[r] + g_bounds[i].near[g] +
+                              b_bounds[i].near[b];
+                    const int far = r_bounds[i].far[r] + g_bounds[i].far[g] +
+                                    b_bounds[i].far[b];
+                    best_far = std::min(best_far, far);
+                }
+                for (size_t i = 0; i < count; ++i) {
+                    if (near[i] <= best_far) {
+                        lut->candidates.push_back(static_cast<uint8_t>(i));
+                    }
+                }
+            }
+        }
+    }
+    lut->cell_offsets.push_back(static_cast<uint32_t>(lut->candidates.size()));
+    lut->candidates.shrink_to_fit();
+    return lut;
+}
+
+std::shared_ptr<const palette_lut>
+get_palette_lut(const std::vector<rgb_color> &targets) {
+    const uint64_t hash = hash_palette(targets);
+    {
+        std::lock_guard<std::mutex> lock(lut_mutex);
+        auto it = lut_by_hash.find(hash);
+        if (it != lut_by_hash.end()) {
+            const auto &cached = it->second->targets;
+            if (std::equal(cached.begin(), cached.end(), targets.begin(),
+                           targets.end(), [](rgb_color a, rgb_color b) {
+                               return a.r == b.r && a.g == b.g && a.b == b.b;
+                           })) {
+                return it->second;
+            }
+        }
+    }
+
+    // Build outside the lock; a concurrent build of the same palette only
+    // costs duplicate work, never a wrong answer.
+    std::shared_ptr<const palette_lut> lut = build_palette_lut(targets);
+    if (!lut) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(lut_mutex);
+    if (lut_by_hash.find(hash) == lut_by_hash.end()) {
+        lut_insertion_order.push_back(hash);
+    }
+    lut_by_hash[hash] = lut;
+    while (lut_by_hash.size() > kMaxCachedLuts &&
+           !lut_insertion_order.empty()) {
+        lut_by_hash.erase(lut_insertion_order.front());
+        lut_insertion_order.pop_front();
+    }
+    return lut;
+}
+
+size_t quantize_index(const palette_lut &lut, rgb_color value) {
+    const size_t cell =
+        cell_index(value.r >> (8 - kCellBits), value.g >> (8 - kCellBits),
+                   value.b >> (8 - kCellBits));
+    const uint32_t begin = lut.cell_offsets[cell];
+    const uint32_t end = lut.cell_offsets[cell + 1];
+
+    size_t best = lut.candidates[begin];
+    if (end - begin == 1) {
+        return best;
+    }
+
+    int best_distance = std::numeric_limits<int>::max();
+    for (uint32_t i = begin; i < end; ++i) {
+        const size_t candidate = lut.candidates[i];
+        const int distance = squared_distance(value, lut.targets[candidate]);
+        if (distance < best_distance) {
+            best_distance = distance;
+            best = candidate;
+        }
+    }
+    return best;
+}
+
+rgb_color quantize_color(const palette_lut &lut, rgb_color value) {
+    return lut.targets[quantize_index(lut, value)];
+}
+
+bool resolve_named_palette(std::string_view name, std::vector<rgb_color> &out) {
+    if (name == "websafe") {
+        static const std::vector<rgb_color> web_safe = make_web_safe_palette();
+        out = web_safe;
+        return true;
+    }
+    if (name == "material") {
+        static const std::vector<rgb_color> material = make_hex_palette({
+            0xF44336, 0xE91E63, 0x9C27B0, 0x673AB7, 0x3F51B5, 0x2196F3,
+            0x03A9F4, 0x00BCD4, 0x009688, 0x4CAF50, 0x8BC34A, 0xCDDC39,
+            0xFFEB3B, 0xFFC107, 0xFF9800, 0xFF5722, 0x795548, 0x9E9E9E,
+            0x607D8B, 0x000000, 0xFFFFFF,
+        });
+        out = material;
+        return true;
+    }
+    if (name == "tailwind") {
+        static const std::vector<rgb_color> tailwind = make_hex_palette({
+            0x64748B, 0x6B7280, 0x71717A, 0x737373, 0x78716C, 0xEF4444,
+            0xF97316, 0xF59E0B, 0xEAB308, 0x84CC16, 0x22C55E, 0x10B981,
+            0x14B8A6, 0x06B6D4, 0x0EA5E9, 0x3B82F6, 0x6366F1, 0x8B5CF6,
+            0xA855F7, 0xD946EF, 0xEC4899, 0xF43F5E, 0x000000, 0xFFFFFF,
+        });
+        out = tailwind;
+        return true;
+    }
+    return false;
+}
+
+} // namespace palette::services
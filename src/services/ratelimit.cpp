@@ -1,25 +1,182 @@
 #include "palette/services/ratelimit.hpp"
-#include <chrono>
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
 
 namespace palette::services {
-static std::unordered_map<dpp::snowflake, std::chrono::system_clock::time_point>
-    ratelimits;
+namespace {
+// The wheel turns once a second and looks this many seconds ahead; users
+// whose buckets drain later are carried over on the next pass.
+constexpr int64_t kWheelTickMs = 1000;
+constexpr size_t kWheelSlots = 32;
 
-bool is_ratelimited(dpp::snowflake user, int64_t ms) {
-    auto now = std::chrono::system_clock::now();
+struct command_bucket {
+    size_t command = 0;
+    int64_t tat = 0;
+};
 
-    auto &last = ratelimits[user];
+struct user_entry {
+    int64_t budget_tat = 0;
+    // When every bucket is back to empty and the entry can go.
+    int64_t drained = 0;
+    std::vector<command_bucket> commands;
+};
 
-    if (last.time_since_epoch().count() == 0) {
-        last = now;
+int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+class rate_shard {
+  public:
+    // Ticks are swept by whoever takes the lock next, and on a timer.
+    void sweep(int64_t now) {
+        const int64_t tick = now / kWheelTickMs;
+        // A caller that read the clock before waiting for the lock can be
+        // behind the last sweep; the wheel never turns back.
+        if (swept_tick_ < 0 || tick < swept_tick_) {
+            swept_tick_ = std::max(swept_tick_, tick);
+            return;
+        }
+        const int64_t last =
+            std::min(tick, swept_tick_ + static_cast<int64_t>(kWheelSlots));
+        for (int64_t t = swept_tick_ + 1; t <= last; ++t) {
+            // Swapped out first: after a long gap, entries can be carried
+            // over into a slot this same pass still has to visit.
+            due_.swap(wheel_[slot_of(t)]);
+            for (const uint64_t user : due_) {
+                const auto it = users_.find(user);
+                if (it == users_.end()) {
+                    continue;
+                }
+                if (it->second.drained <= now) {
+                    users_.erase(it);
+                } else {
+                    schedule(user, it->second.drained, tick);
+                }
+            }
+            due_.clear();
+        }
+        swept_tick_ = tick;
+    }
+
+    bool check(uint64_t user, size_t command,
+               const command_option_t &options, int64_t now) {
+        const auto [it, inserted] = users_.try_emplace(user);
+        user_entry &entry = it->second;
+        if (inserted) {
+            schedule(user, now, now / kWheelTickMs);
+        }
+
+        auto bucket = std::find_if(entry.commands.begin(),
+                                   entry.commands.end(),
+                                   [command](const command_bucket &b) {
+                                       return b.command == command;
+                                   });
+        if (bucket == entry.commands.end()) {
+            bucket = entry.commands.insert(entry.commands.end(),
+                                           command_bucket{command, 0});
+        }
+        // The per-command cooldown tolerates no burst.
+        if (bucket->tat > now) {
+            return true;
+        }
+
+        const int64_t interval = kRateBudgetInterval.count();
+        const int64_t budget_tat = std::max(entry.budget_tat, now) +
+                                   rate_cost(options.lane) * interval;
+        if (budget_tat - now > kRateBudgetBurst * interval) {
+            return true;
+        }
+
+        entry.budget_tat = budget_tat;
+        bucket->tat = now + options.ratelimit;
+        entry.drained = std::max({entry.drained, budget_tat, bucket->tat});
         return false;
     }
 
-    if ((now - last) < std::chrono::milliseconds(ms))
-        return true;
+    size_t size() const { return users_.size(); }
+
+    std::mutex mutex;
+
+  private:
+    static size_t slot_of(int64_t tick) {
+        return static_cast<size_t>(tick) % kWheelSlots;
+    }
+
+    // Always at least one tick ahead, so a slot being swept never receives
+    // its own entries back.
+    void schedule(uint64_t user, int64_t due, int64_t tick) {
+        const int64_t due_tick = std::clamp(
+            due / kWheelTickMs + 1, tick + 1,
+            tick + static_cast<int64_t>(kWheelSlots) - 1);
+        wheel_[slot_of(due_tick)].push_back(user);
+    }
+
+    std::unordered_map<uint64_t, user_entry> users_;
+    std::array<std::vector<uint64_t>, kWheelSlots> wheel_;
+    std::vector<uint64_t> due_;
+    int64_t swept_tick_ = -1;
+};
+
+std::array<rate_shard, kRateLimitShards> shards;
 
-    last = now;
-    return false;
+rate_shard &shard_for(uint64_t user) {
+    // The low bits of a snowflake are a per-process counter; mix in the
+    // timestamp so users spread evenly.
+    return shards[(user ^ (user >> 22)) % kRateLimitShards];
 }
+} // namespace
+
+int64_t rate_cost(task_class lane) {
+    switch (lane) {
+    case task_class::render:
+        return 3;
+    case task_class::interactive:
+    case task_class::background:
+        return 1;
+    }
+    return 1;
+}
+
+bool is_ratelimited(dpp::snowflake user_id, std::string_view command,
+                    const command_option_t &options) {
+    if (options.ratelimit <= 0) {
+        return false;
+    }
+
+    const uint64_t user = static_cast<uint64_t>(user_id);
+    const int64_t now = now_ms();
+    rate_shard &shard = shard_for(user);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.sweep(now);
+    return shard.check(user, std::hash<std::string_view>{}(command), options,
+                       now);
+}
+
+size_t ratelimited_users() {
+    size_t total = 0;
+    for (rate_shard &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        total += shard.size();
+    }
+    return total;
+}
+
+void sweep_ratelimits() {
+    for (rate_shard &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.sweep(now_ms());
+    }
+}
+
+void schedule_ratelimit_sweeps(dpp::cluster &bot) {
+    bot.start_timer([](dpp::timer) { sweep_ratelimits(); },
+                    static_cast<uint64_t>(kRateLimitSweepInterval.count()));
+}
+
 } // namespace palette::services
@@ -1,15 +1,465 @@
 #include "palette/services/thread_pool.hpp"
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <cstdlib>
 #include <exception>
+#include <iostream>
+#include <memory>
 #include <mutex>
-#include <queue>
+#include <semaphore>
 #include <thread>
 #include <utility>
 #include <vector>
 
 namespace palette::services {
+namespace {
+// Every this many tasks a worker looks at the lanes before its own deque, so
+// a worker that keeps spawning local work cannot starve external
+// submissions.
+constexpr uint32_t kInjectionCheckInterval = 31;
+constexpr size_t kInitialDequeCapacity = 256;
+constexpr int kStealAttempts = 2;
+
+// Lane shares under contention, indexed by task_class. A backlogged
+// interactive lane gets eight picks for every three render and one
+// background pick.
+constexpr std::array<uint64_t, kTaskClassCount> kLaneWeights = {8, 3, 1};
+constexpr uint64_t kLaneStrideScale = 1 << 20;
+// Workers held back from the other lanes: a quarter of the pool for
+// interactive work and an eighth for render work.
+constexpr std::array<size_t, kTaskClassCount> kLaneReserveDivisors = {4, 8,
+                                                                       0};
+
+// Elastic sizing. Busy workers are sampled every kScalingSample and a
+// decision is taken every kScalingSamplesPerWindow samples. Growing needs
+// kGrowWindows pressured windows in a row, shrinking kShrinkWindows slack
+// ones: the pool grows by half within half a second of a burst but gives
+// back only one thread per ten quiet seconds.
+constexpr std::chrono::milliseconds kScalingSample{50};
+constexpr int kScalingSamplesPerWindow = 5;
+constexpr int kGrowWindows = 2;
+constexpr int kShrinkWindows = 40;
+constexpr double kGrowWaitMs = 16.0;
+constexpr double kGrowUtilization = 0.9;
+constexpr double kShrinkWaitMs = 1.0;
+constexpr double kShrinkUtilization = 0.3;
+
+struct task_node {
+    std::atomic<task_node *> next{nullptr};
+    task run;
+    // For tasks pushed to a worker deque, the lane of the task that spawned
+    // them; they run on that lane's budget.
+    size_t lane = 0;
+    bool local = false;
+    task_clock::time_point enqueued;
+    task_clock::time_point deadline = task_clock::time_point::max();
+};
+
+// Task nodes are recycled rather than freed. Each thread keeps a small cache
+// and trades whole batches of kNodeBatch with a shared depot, so the gateway
+// thread that only allocates and the workers that only retire nodes settle
+// into a steady state without allocator traffic.
+constexpr size_t kNodeBatch = 64;
+constexpr size_t kNodeDepotBatches = 64;
+
+void free_chain(task_node *node) {
+    while (node) {
+        task_node *next = node->next.load(std::memory_order_relaxed);
+        delete node;
+        node = next;
+    }
+}
+
+class node_depot {
+  public:
+    ~node_depot() {
+        for (const batch &b : batches_) {
+            free_chain(b.head);
+        }
+    }
+
+    bool take(task_node *&head, size_t &count) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (batches_.empty()) {
+            return false;
+        }
+        head = batches_.back().head;
+        count = batches_.back().count;
+        batches_.pop_back();
+        return true;
+    }
+
+    void give(task_node *head, size_t count) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (batches_.size() < kNodeDepotBatches) {
+                batches_.push_back({head, count});
+                return;
+            }
+        }
+        free_chain(head);
+    }
+
+  private:
+    struct batch {
+        task_node *head;
+        size_t count;
+    };
+
+    std::mutex mutex_;
+    std::vector<batch> batches_;
+};
+
+node_depot &shared_depot() {
+    static node_depot depot;
+    return depot;
+}
+
+class node_cache {
+  public:
+    ~node_cache() {
+        if (free_) {
+            shared_depot().give(free_, free_count_);
+        }
+        if (spill_) {
+            shared_depot().give(spill_, spill_count_);
+        }
+    }
+
+    task_node *acquire() {
+        if (!free_) {
+            if (spill_) {
+                std::swap(free_, spill_);
+                std::swap(free_count_, spill_count_);
+            } else if (!shared_depot().take(free_, free_count_)) {
+                return new task_node{};
+            }
+        }
+        task_node *node = free_;
+        free_ = node->next.load(std::memory_order_relaxed);
+        --free_count_;
+        node->next.store(nullptr, std::memory_order_relaxed);
+        return node;
+    }
+
+    void release(task_node *node) {
+        node->run.reset();
+        node->lane = 0;
+        node->local = false;
+        node->deadline = task_clock::time_point::max();
+        if (free_count_ < kNodeBatch) {
+            push(free_, free_count_, node);
+            return;
+        }
+        push(spill_, spill_count_, node);
+        if (spill_count_ == kNodeBatch) {
+            shared_depot().give(spill_, spill_count_);
+            spill_ = nullptr;
+            spill_count_ = 0;
+        }
+    }
+
+  private:
+    static void push(task_node *&head, size_t &count, task_node *node) {
+        node->next.store(head, std::memory_order_relaxed);
+        head = node;
+        ++count;
+    }
+
+    task_node *free_ = nullptr;
+    size_t free_count_ = 0;
+    task_node *spill_ = nullptr;
+    size_t spill_count_ = 0;
+};
+
+thread_local node_cache nodes;
+
+// Chase-Lev work-stealing deque (Le et al., "Correct and Efficient
+// Work-Stealing for Weak Memory Models"). The owning worker pushes and pops
+// at the bottom; other workers steal from the top. Grown rings are retired
+// rather than freed, since a thief may still be reading one; they are
+// released with the deque.
+class work_deque {
+  public:
+    work_deque() {
+        rings_.push_back(std::make_unique<ring>(kInitialDequeCapacity));
+        ring_.store(rings_.back().get(), std::memory_order_relaxed);
+    }
+
+    void push(task_node *task) {
+        const int64_t b = bottom_.load(std::memory_order_relaxed);
+        const int64_t t = top_.load(std::memory_order_acquire);
+        ring *r = ring_.load(std::memory_order_relaxed);
+        if (b - t >= static_cast<int64_t>(r->capacity())) {
+            r = grow(r, t, b);
+        }
+        r->put(b, task);
+        bottom_.store(b + 1, std::memory_order_release);
+    }
+
+    task_node *pop() {
+        const int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        ring *r = ring_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top_.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        task_node *task = r->get(b);
+        if (t == b) {
+            // Last element: race any thief for it.
+            if (!top_.compare_exchange_strong(t, t + 1,
+                                              std::memory_order_seq_cst,
+                                              std::memory_order_relaxed)) {
+                task = nullptr;
+            }
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+        return task;
+    }
+
+    task_node *steal() {
+        int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) {
+            return nullptr;
+        }
+
+        ring *r = ring_.load(std::memory_order_acquire);
+        task_node *task = r->get(t);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return task;
+    }
+
+    size_t size() const {
+        const int64_t b = bottom_.load(std::memory_order_seq_cst);
+        const int64_t t = top_.load(std::memory_order_seq_cst);
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+
+  private:
+    struct ring {
+        explicit ring(size_t capacity)
+            : mask(capacity - 1),
+              slots(new std::atomic<task_node *>[capacity]) {}
+
+        size_t capacity() const { return mask + 1; }
+        task_node *get(int64_t index) const {
+            return slots[static_cast<size_t>(index) & mask].load(
+                std::memory_order_relaxed);
+        }
+        void put(int64_t index, task_node *task) {
+            slots[static_cast<size_t>(index) & mask].store(
+                task, std::memory_order_relaxed);
+        }
+
+        size_t mask;
+        std::unique_ptr<std::atomic<task_node *>[]> slots;
+    };
+
+    ring *grow(ring *old, int64_t top, int64_t bottom) {
+        rings_.push_back(std::make_unique<ring>(old->capacity() * 2));
+        ring *grown = rings_.back().get();
+        for (int64_t i = top; i < bottom; ++i) {
+            grown->put(i, old->get(i));
+        }
+        ring_.store(grown, std::memory_order_release);
+        return grown;
+    }
+
+    alignas(64) std::atomic<int64_t> top_{0};
+    alignas(64) std::atomic<int64_t> bottom_{0};
+    std::atomic<ring *> ring_{nullptr};
+    std::vector<std::unique_ptr<ring>> rings_;
+};
+
+// Intrusive multi-producer queue for tasks submitted from outside the pool
+// (Vyukov's MPSC list). Producers never block: a push is one exchange on the
+// tail. Consumers must be serialized by the caller.
+class injection_queue {
+  public:
+    injection_queue() : head_(&stub_), tail_(&stub_) {}
+
+    void push(task_node *task) {
+        // Counted before linking, so `size` never under-reports a task a
+        // producer has started to publish.
+        pending_.fetch_add(1, std::memory_order_seq_cst);
+        link(task);
+    }
+
+    task_node *pop() {
+        task_node *task = pop_locked();
+        if (task) {
+            pending_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return task;
+    }
+
+    size_t size() const { return pending_.load(std::memory_order_seq_cst); }
+
+    // Only called once no producer or consumer is left.
+    task_node *drain() { return pop_locked(); }
+
+  private:
+    void link(task_node *task) {
+        task->next.store(nullptr, std::memory_order_relaxed);
+        task_node *previous = tail_.exchange(task, std::memory_order_acq_rel);
+        previous->next.store(task, std::memory_order_release);
+    }
+
+    task_node *pop_locked() {
+        task_node *head = head_;
+        task_node *next = head->next.load(std::memory_order_acquire);
+        if (head == &stub_) {
+            if (!next) {
+                return nullptr;
+            }
+            head_ = next;
+            head = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next) {
+            head_ = next;
+            return head;
+        }
+        if (head != tail_.load(std::memory_order_acquire)) {
+            // A producer has swapped the tail but not linked it yet.
+            return nullptr;
+        }
+        link(&stub_);
+        next = head->next.load(std::memory_order_acquire);
+        if (next) {
+            head_ = next;
+            return head;
+        }
+        return nullptr;
+    }
+
+    task_node *head_;
+    alignas(64) std::atomic<task_node *> tail_;
+    alignas(64) std::atomic<size_t> pending_{0};
+    task_node stub_;
+};
+
+struct worker {
+    size_t index = 0;
+    work_deque deque;
+    std::binary_semaphore wake{0};
+    uint64_t rng = 0;
+    // Sampled by the scaling controller.
+    std::atomic<bool> busy{false};
+    // Set by the controller on a parked worker it is retiring; the worker
+    // raises `exited` as its last step so the thread can be joined.
+    std::atomic<bool> retiring{false};
+    std::atomic<bool> exited{false};
+    std::thread thread;
+};
+
+thread_local thread_pool *current_pool = nullptr;
+thread_local worker *current_worker = nullptr;
+// Lane of the task the calling worker is running.
+thread_local size_t current_lane = 0;
+
+uint64_t next_random(uint64_t &state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+void run_guarded(task_node *task) {
+    try {
+        task->run();
+    } catch (...) {
+        // Keep the worker alive even if a handler throws.
+    }
+}
+
+size_t wait_bucket(task_clock::duration wait) {
+    const auto micros =
+        std::chrono::duration_cast<std::chrono::microseconds>(wait).count();
+    size_t bucket = 0;
+    for (int64_t bound = 1; bucket + 1 < kQueueWaitBuckets && micros >= bound;
+         bound *= 2) {
+        ++bucket;
+    }
+    return bucket;
+}
+} // namespace
+
+const char *task_class_label(task_class lane) {
+    switch (lane) {
+    case task_class::interactive:
+        return "interactive";
+    case task_class::render:
+        return "render";
+    case task_class::background:
+        return "background";
+    }
+    return "unknown";
+}
+
+const char *admission_label(admission result) {
+    switch (result) {
+    case admission::accepted:
+        return "accepted";
+    case admission::queue_full:
+        return "queue full";
+    case admission::over_budget:
+        return "over budget";
+    case admission::stopped:
+        return "stopped";
+    }
+    return "unknown";
+}
+
+const char *scaling_decision_label(scaling_decision decision) {
+    switch (decision) {
+    case scaling_decision::hold:
+        return "hold";
+    case scaling_decision::grow:
+        return "grow";
+    case scaling_decision::shrink:
+        return "shrink";
+    }
+    return "unknown";
+}
+
+uint64_t queue_wait_histogram::total() const {
+    uint64_t sum = 0;
+    for (const uint64_t count : counts) {
+        sum += count;
+    }
+    return sum;
+}
+
+double queue_wait_histogram::percentile_ms(double fraction) const {
+    const uint64_t count = total();
+    if (count == 0) {
+        return 0.0;
+    }
+    const double target = std::clamp(fraction, 0.0, 1.0) * count;
+    uint64_t seen = 0;
+    for (size_t b = 0; b < kQueueWaitBuckets; ++b) {
+        seen += counts[b];
+        if (seen > 0 && static_cast<double>(seen) >= target) {
+            return static_cast<double>(uint64_t{1} << b) / 1000.0;
+        }
+    }
+    return static_cast<double>(uint64_t{1} << (kQueueWaitBuckets - 1)) /
+           1000.0;
+}
 
 size_t resolve_worker_thread_count(const char *env_name, size_t fallback) {
     const size_t default_fallback = fallback == 0 ? 4 : fallback;
@@ -29,78 +479,757 @@ size_t resolve_worker_thread_count(const char *env_name, size_t fallback) {
                       max_threads);
 }
 
+// Workers look for work in their own deque, then the lanes, then other
+// workers' deques. External submissions go to one injection queue per
+// task_class. A worker picks among the backlogged lanes by stride
+// scheduling (weighted fair queuing over picks), skipping any lane that
+// already occupies every worker not reserved for the others, or whose next
+// task would leave the other lanes together eating into a reserve. Tasks
+// spawned locally count against their parent's lane; a worker that finds
+// one the lane has no room for moves it to that lane's queue instead.
+//
+// A worker that finds nothing parks on its own semaphore. A submission wakes
+// at most one parked worker, and only when the queue it went to holds more
+// tasks than there are workers already searching; a searcher that finds
+// work wakes the next one if more is visible. Wakeups therefore track the
+// backlog one worker at a time instead of arriving as a thundering herd.
+//
+// Lost wakeups are ruled out by a Dekker-style handshake: submitters publish
+// the task and then read `searching`/`idle_count`, while a parking worker
+// publishes itself as idle, leaves `searching`, and then re-checks every
+// queue. All of those accesses are sequentially consistent.
+//
+// Worker slots are allocated up front for the maximum pool size so the
+// stealing loops never see the vector change. The scaling controller starts
+// threads in vacant slots and retires only parked workers, whose deques are
+// empty by construction.
 struct thread_pool::impl {
-    std::vector<std::thread> workers;
-    std::queue<std::function<void()>> tasks;
-    std::mutex mutex;
-    std::condition_variable cv;
-    bool stopping = false;
-};
+    thread_pool *owner = nullptr;
+    std::vector<std::unique_ptr<worker>> workers;
+    std::atomic<size_t> active{0};
+    size_t min_workers = 1;
+    size_t max_workers = 1;
+    std::array<injection_queue, kTaskClassCount> lanes;
+    std::array<std::atomic<size_t>, kTaskClassCount> lane_running{};
+    std::array<std::array<std::atomic<uint64_t>, kQueueWaitBuckets>,
+               kTaskClassCount>
+        lane_waits{};
+    size_t lane_capacity = kDefaultLaneCapacity;
+    // Exponentially smoothed run time per lane, in nanoseconds.
+    std::array<std::atomic<uint64_t>, kTaskClassCount> lane_service_ns{};
+    std::array<std::atomic<uint64_t>, kTaskClassCount> lane_shed_full{};
+    std::array<std::atomic<uint64_t>, kTaskClassCount> lane_shed_budget{};
+    std::array<std::atomic<uint64_t>, kTaskClassCount> lane_expired{};
+    // Lane consumers take turns through this try-lock; it also guards the
+    // stride scheduler's virtual times.
+    std::atomic_flag lane_lock = ATOMIC_FLAG_INIT;
+    std::array<uint64_t, kTaskClassCount> lane_pass{};
+    uint64_t lane_clock = 0;
+    std::atomic<bool> stopping{false};
+    std::atomic<size_t> searching{0};
+    std::atomic<size_t> idle_count{0};
+    std::mutex idle_mutex;
+    std::vector<size_t> idle;
 
-thread_pool::thread_pool(size_t thread_count) : state_(new impl{}) {
-    const size_t resolved = std::max<size_t>(1, thread_count);
-    state_->workers.reserve(resolved);
-    impl *const state = state_;
-
-    for (size_t i = 0; i < resolved; ++i) {
-        state_->workers.emplace_back([state]() {
-            while (true) {
-                std::function<void()> task;
-                {
-                    std::unique_lock<std::mutex> lock(state->mutex);
-                    state->cv.wait(lock, [state]() {
-                        return state->stopping || !state->tasks.empty();
-                    });
+    std::thread controller;
+    std::mutex controller_mutex;
+    std::condition_variable controller_cv;
+    bool controller_stop = false;
+    scaling_stats scaling;
 
-                    if (state->stopping && state->tasks.empty()) {
-                        return;
-                    }
+    // Workers a lane may occupy: the active pool minus what is reserved
+    // for the other lanes, and never less than one.
+    size_t lane_limit(size_t lane) const {
+        const size_t count = active.load(std::memory_order_relaxed);
+        size_t others = 0;
+        for (size_t other = 0; other < kTaskClassCount; ++other) {
+            if (other != lane && kLaneReserveDivisors[other] != 0) {
+                others += count / kLaneReserveDivisors[other];
+            }
+        }
+        return count > others ? count - others : size_t{1};
+    }
+
+    // Whether one more task of the lane fits: the lane stays within its
+    // own limit, and for every other lane with a reserve, the lanes other
+    // than that one together leave the reserve free.
+    bool lane_has_room(size_t lane) const {
+        const size_t count = active.load(std::memory_order_relaxed);
+        std::array<size_t, kTaskClassCount> running{};
+        for (size_t l = 0; l < kTaskClassCount; ++l) {
+            running[l] = lane_running[l].load(std::memory_order_seq_cst);
+        }
+        if (running[lane] >= lane_limit(lane)) {
+            return false;
+        }
+        for (size_t reserved = 0; reserved < kTaskClassCount; ++reserved) {
+            if (reserved == lane || kLaneReserveDivisors[reserved] == 0) {
+                continue;
+            }
+            size_t others = 1;
+            for (size_t l = 0; l < kTaskClassCount; ++l) {
+                others += l == reserved ? 0 : running[l];
+            }
+            if (others > count - count / kLaneReserveDivisors[reserved]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool lane_ready(size_t lane) const {
+        return lanes[lane].size() != 0 && lane_has_room(lane);
+    }
+
+    bool has_work() const {
+        for (size_t lane = 0; lane < kTaskClassCount; ++lane) {
+            if (lane_ready(lane)) {
+                return true;
+            }
+        }
+        return std::any_of(workers.begin(), workers.end(),
+                           [](const std::unique_ptr<worker> &w) {
+                               return w->deque.size() != 0;
+                           });
+    }
 
-                    task = std::move(state->tasks.front());
-                    state->tasks.pop();
+    void notify_one(size_t queued) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (searching.load(std::memory_order_seq_cst) >= queued ||
+            idle_count.load(std::memory_order_seq_cst) == 0) {
+            return;
+        }
+
+        worker *target = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(idle_mutex);
+            if (idle.empty()) {
+                return;
+            }
+            target = workers[idle.back()].get();
+            idle.pop_back();
+            idle_count.fetch_sub(1, std::memory_order_seq_cst);
+            searching.fetch_add(1, std::memory_order_seq_cst);
+        }
+        target->wake.release();
+    }
+
+    bool on_worker() const {
+        return current_worker && current_pool && current_pool->state_ == this;
+    }
+
+    void submit_local(task_node *task) {
+        task->lane = current_lane;
+        task->local = true;
+        current_worker->deque.push(task);
+        notify_one(current_worker->deque.size());
+    }
+
+    void submit_lane(task_node *task, size_t lane) {
+        task->lane = lane;
+        task->enqueued = task_clock::now();
+        lanes[lane].push(task);
+        // A lane at its limit is picked up by whichever of its own workers
+        // finishes first, so waking anyone else would be wasted.
+        if (lane_ready(lane)) {
+            notify_one(lanes[lane].size());
+        }
+    }
+
+    task_node *pop_lane() {
+        if (lane_lock.test_and_set(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        size_t best = kTaskClassCount;
+        for (size_t lane = 0; lane < kTaskClassCount; ++lane) {
+            if (!lane_ready(lane)) {
+                continue;
+            }
+            // A lane returning from idle starts at the current virtual time
+            // instead of cashing in the picks it did not need.
+            lane_pass[lane] = std::max(lane_pass[lane], lane_clock);
+            if (best == kTaskClassCount || lane_pass[lane] < lane_pass[best]) {
+                best = lane;
+            }
+        }
+
+        task_node *task = nullptr;
+        if (best != kTaskClassCount) {
+            task = lanes[best].pop();
+            if (task) {
+                lane_clock = lane_pass[best];
+                lane_pass[best] += kLaneStrideScale / kLaneWeights[best];
+                lane_running[best].fetch_add(1, std::memory_order_seq_cst);
+            }
+        }
+        lane_lock.clear(std::memory_order_release);
+        return task;
+    }
+
+    // Counts a local task against its lane if the lane has room. Waits for
+    // the lane lock rather than trying it, since the task is already in
+    // hand.
+    bool claim_local(size_t lane) {
+        while (lane_lock.test_and_set(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+        const bool room = lane_has_room(lane);
+        if (room) {
+            lane_running[lane].fetch_add(1, std::memory_order_seq_cst);
+        }
+        lane_lock.clear(std::memory_order_release);
+        return room;
+    }
+
+    // Tasks ahead of a new arrival, spread over the workers the lane may use.
+    task_clock::duration estimated_wait(size_t lane) const {
+        const size_t backlog =
+            lanes[lane].size() +
+            lane_running[lane].load(std::memory_order_relaxed);
+        const size_t limit = lane_limit(lane);
+        if (backlog < limit) {
+            return task_clock::duration::zero();
+        }
+        const uint64_t service =
+            lane_service_ns[lane].load(std::memory_order_relaxed);
+        return std::chrono::nanoseconds((backlog - limit + 1) * service /
+                                        limit);
+    }
+
+    void record_service(size_t lane, task_clock::duration elapsed) {
+        const auto sample = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                .count());
+        const uint64_t previous =
+            lane_service_ns[lane].load(std::memory_order_relaxed);
+        // A lost update between racing workers only skips one sample.
+        const uint64_t next =
+            previous == 0 ? sample : previous - previous / 8 + sample / 8;
+        lane_service_ns[lane].store(next, std::memory_order_relaxed);
+    }
+
+    void run_task(task_node *task) {
+        const size_t lane = task->lane;
+        current_lane = lane;
+        if (task->local) {
+            if (!claim_local(lane)) {
+                // Waits its turn with the lane's other work; a parallel_for
+                // caller finishes the chunks itself meanwhile.
+                task->local = false;
+                submit_lane(task, lane);
+                return;
+            }
+            run_guarded(task);
+            nodes.release(task);
+            lane_running[lane].fetch_sub(1, std::memory_order_seq_cst);
+            return;
+        }
+
+        const task_clock::time_point started = task_clock::now();
+        lane_waits[lane][wait_bucket(started - task->enqueued)].fetch_add(
+            1, std::memory_order_relaxed);
+        if (started > task->deadline) {
+            lane_expired[lane].fetch_add(1, std::memory_order_relaxed);
+        } else {
+            run_guarded(task);
+            record_service(lane, task_clock::now() - started);
+        }
+        nodes.release(task);
+        lane_running[lane].fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    task_node *steal(worker &self) {
+        const size_t count = workers.size();
+        if (count < 2) {
+            return nullptr;
+        }
+        for (int attempt = 0; attempt < kStealAttempts; ++attempt) {
+            const size_t start = next_random(self.rng) % count;
+            for (size_t i = 0; i < count; ++i) {
+                worker &victim = *workers[(start + i) % count];
+                if (&victim == &self) {
+                    continue;
+                }
+                if (task_node *task = victim.deque.steal()) {
+                    return task;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    task_node *find_task(worker &self, uint32_t tick) {
+        if (tick % kInjectionCheckInterval == 0) {
+            if (task_node *task = pop_lane()) {
+                return task;
+            }
+        }
+        if (task_node *task = self.deque.pop()) {
+            return task;
+        }
+        if (task_node *task = pop_lane()) {
+            return task;
+        }
+        return steal(self);
+    }
+
+    // Returns once the worker has been woken, or straight away when work or
+    // shutdown showed up while it was registering as idle.
+    void park(worker &self, bool searching_worker) {
+        {
+            std::lock_guard<std::mutex> lock(idle_mutex);
+            idle.push_back(self.index);
+            idle_count.fetch_add(1, std::memory_order_seq_cst);
+        }
+        if (searching_worker) {
+            searching.fetch_sub(1, std::memory_order_seq_cst);
+        }
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (has_work() || stopping.load(std::memory_order_seq_cst)) {
+            std::unique_lock<std::mutex> lock(idle_mutex);
+            auto it = std::find(idle.begin(), idle.end(), self.index);
+            if (it != idle.end()) {
+                idle.erase(it);
+                idle_count.fetch_sub(1, std::memory_order_seq_cst);
+                searching.fetch_add(1, std::memory_order_seq_cst);
+                return;
+            }
+            // A submitter already claimed this worker; take its wakeup.
+        }
+        self.wake.acquire();
+    }
+
+    void worker_loop(worker &self) {
+        bool searching_worker = true;
+        bool stop_seen = false;
+        uint32_t tick = 0;
+        while (true) {
+            if (task_node *task = find_task(self, ++tick)) {
+                if (searching_worker) {
+                    searching_worker = false;
+                    if (searching.fetch_sub(1, std::memory_order_seq_cst) ==
+                            1 &&
+                        has_work()) {
+                        notify_one(1);
+                    }
                 }
+                self.busy.store(true, std::memory_order_relaxed);
+                run_task(task);
+                self.busy.store(false, std::memory_order_relaxed);
+                continue;
+            }
 
-                try {
-                    task();
-                } catch (...) {
-                    // Keep the worker alive even if a handler throws.
+            if (stopping.load(std::memory_order_acquire)) {
+                // The flag may have been raised just after the search above
+                // came up empty; search once more before leaving so nothing
+                // submitted before the stop is stranded in a lane.
+                if (!stop_seen) {
+                    stop_seen = true;
+                    continue;
+                }
+                if (searching_worker) {
+                    searching.fetch_sub(1, std::memory_order_seq_cst);
                 }
+                return;
             }
+            park(self, searching_worker);
+            if (self.retiring.load(std::memory_order_acquire)) {
+                // Work may have arrived while this worker was being
+                // retired; hand it to someone else.
+                if (has_work()) {
+                    notify_one(1);
+                }
+                self.exited.store(true, std::memory_order_release);
+                return;
+            }
+            searching_worker = true;
+        }
+    }
+
+    void start_worker(worker &self) {
+        self.retiring.store(false, std::memory_order_relaxed);
+        self.exited.store(false, std::memory_order_relaxed);
+        searching.fetch_add(1, std::memory_order_seq_cst);
+        active.fetch_add(1, std::memory_order_seq_cst);
+        thread_pool *const pool = owner;
+        self.thread = std::thread([this, pool, &self]() {
+            current_pool = pool;
+            current_worker = &self;
+            worker_loop(self);
         });
     }
+
+    // Starts up to `count` workers in vacant slots, joining the threads of
+    // retired workers first.
+    size_t grow(size_t count) {
+        size_t started = 0;
+        for (auto &w : workers) {
+            if (started == count) {
+                break;
+            }
+            if (w->thread.joinable()) {
+                if (!w->exited.load(std::memory_order_acquire)) {
+                    continue;
+                }
+                w->thread.join();
+            }
+            start_worker(*w);
+            ++started;
+        }
+        return started;
+    }
+
+    // Retires the longest-parked worker, if any worker is parked.
+    bool retire_one() {
+        worker *target = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(idle_mutex);
+            if (idle.empty()) {
+                return false;
+            }
+            target = workers[idle.front()].get();
+            idle.erase(idle.begin());
+            idle_count.fetch_sub(1, std::memory_order_seq_cst);
+            target->retiring.store(true, std::memory_order_release);
+            active.fetch_sub(1, std::memory_order_seq_cst);
+        }
+        target->wake.release();
+        return true;
+    }
+
+    queue_wait_histogram total_waits() const {
+        queue_wait_histogram merged;
+        for (const auto &lane : lane_waits) {
+            for (size_t b = 0; b < kQueueWaitBuckets; ++b) {
+                merged.counts[b] += lane[b].load(std::memory_order_relaxed);
+            }
+        }
+        return merged;
+    }
+
+    // Sizes the pool from the queue-wait p90 and worker utilization of each
+    // window. Decisions are logged and kept in `scaling`.
+    void control_loop() {
+        queue_wait_histogram previous = total_waits();
+        size_t busy_samples = 0;
+        size_t worker_samples = 0;
+        int samples = 0;
+        int pressured_windows = 0;
+        int slack_windows = 0;
+
+        std::unique_lock<std::mutex> lock(controller_mutex);
+        while (!controller_cv.wait_for(lock, kScalingSample,
+                                       [this]() { return controller_stop; })) {
+            for (const auto &w : workers) {
+                busy_samples += w->busy.load(std::memory_order_relaxed);
+            }
+            worker_samples += active.load(std::memory_order_relaxed);
+            if (++samples < kScalingSamplesPerWindow) {
+                continue;
+            }
+
+            const queue_wait_histogram current = total_waits();
+            queue_wait_histogram window;
+            for (size_t b = 0; b < kQueueWaitBuckets; ++b) {
+                window.counts[b] = current.counts[b] - previous.counts[b];
+            }
+            previous = current;
+            const double p90 = window.percentile_ms(0.9);
+            const double utilization =
+                worker_samples == 0 ? 0.0
+                                    : static_cast<double>(busy_samples) /
+                                          static_cast<double>(worker_samples);
+            samples = 0;
+            busy_samples = 0;
+            worker_samples = 0;
+
+            size_t backlog = 0;
+            for (const injection_queue &lane : lanes) {
+                backlog += lane.size();
+            }
+            // Waits are recorded when tasks start, so they lag the queue;
+            // without a backlog there is nothing left for new threads to do.
+            const bool pressured =
+                backlog != 0 &&
+                (p90 >= kGrowWaitMs || utilization >= kGrowUtilization);
+            const bool slack = backlog == 0 &&
+                               utilization <= kShrinkUtilization &&
+                               p90 <= kShrinkWaitMs;
+            pressured_windows = pressured ? pressured_windows + 1 : 0;
+            slack_windows = slack ? slack_windows + 1 : 0;
+
+            const size_t before = active.load(std::memory_order_relaxed);
+            scaling_decision decision = scaling_decision::hold;
+            if (pressured_windows >= kGrowWindows && before < max_workers) {
+                const size_t step = std::max<size_t>(1, before / 2);
+                if (grow(std::min(step, max_workers - before)) != 0) {
+                    decision = scaling_decision::grow;
+                    ++scaling.grown;
+                }
+                pressured_windows = 0;
+            } else if (slack_windows >= kShrinkWindows &&
+                       before > min_workers) {
+                if (retire_one()) {
+                    decision = scaling_decision::shrink;
+                    ++scaling.shrunk;
+                }
+                slack_windows = 0;
+            }
+
+            scaling.workers = active.load(std::memory_order_relaxed);
+            scaling.window_p90_ms = p90;
+            scaling.utilization = utilization;
+            scaling.last_decision = decision;
+            if (decision != scaling_decision::hold) {
+                std::cout << "Worker pool "
+                          << (decision == scaling_decision::grow ? "grew"
+                                                                 : "shrank")
+                          << " from " << before << " to " << scaling.workers
+                          << " (wait p90 <= " << p90 << " ms, utilization "
+                          << static_cast<int>(utilization * 100.0) << "%)\n";
+            }
+        }
+    }
+};
+
+thread_pool::thread_pool(size_t thread_count, size_t lane_capacity)
+    : thread_pool(thread_pool_options{.threads = thread_count,
+                                      .lane_capacity = lane_capacity}) {}
+
+thread_pool::thread_pool(const thread_pool_options &options)
+    : state_(new impl{}) {
+    const size_t initial = std::max<size_t>(1, options.threads);
+    const size_t min_workers =
+        options.min_threads == 0 ? initial
+                                 : std::min(options.min_threads, initial);
+    const size_t max_workers =
+        std::max(options.max_threads == 0 ? initial : options.max_threads,
+                 initial);
+    state_->owner = this;
+    state_->min_workers = min_workers;
+    state_->max_workers = max_workers;
+    state_->lane_capacity = std::max<size_t>(1, options.lane_capacity);
+    state_->scaling.min_workers = min_workers;
+    state_->scaling.max_workers = max_workers;
+    state_->workers.reserve(max_workers);
+    for (size_t i = 0; i < max_workers; ++i) {
+        auto w = std::make_unique<worker>();
+        w->index = i;
+        w->rng = 0x9E3779B97F4A7C15ULL * (i + 1);
+        state_->workers.push_back(std::move(w));
+    }
+
+    state_->grow(initial);
+    state_->scaling.workers = initial;
+    if (max_workers > min_workers) {
+        impl *const state = state_;
+        state_->controller = std::thread([state]() { state->control_loop(); });
+    }
 }
 
 thread_pool::~thread_pool() {
+    if (state_->controller.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(state_->controller_mutex);
+            state_->controller_stop = true;
+        }
+        state_->controller_cv.notify_all();
+        state_->controller.join();
+    }
+
+    state_->stopping.store(true, std::memory_order_seq_cst);
     {
-        std::lock_guard<std::mutex> lock(state_->mutex);
-        state_->stopping = true;
+        std::lock_guard<std::mutex> lock(state_->idle_mutex);
+        for (const size_t index : state_->idle) {
+            state_->searching.fetch_add(1, std::memory_order_seq_cst);
+            state_->workers[index]->wake.release();
+        }
+        state_->idle.clear();
+        state_->idle_count.store(0, std::memory_order_seq_cst);
     }
-    state_->cv.notify_all();
 
-    for (auto &worker : state_->workers) {
-        if (worker.joinable()) {
-            worker.join();
+    for (auto &w : state_->workers) {
+        if (w->thread.joinable()) {
+            w->thread.join();
         }
     }
 
+    // Workers drain everything before exiting; this only catches tasks a
+    // racing external submitter published after the last worker looked.
+    for (injection_queue &lane : state_->lanes) {
+        while (task_node *task = lane.drain()) {
+            nodes.release(task);
+        }
+    }
     delete state_;
 }
 
-void thread_pool::enqueue(std::function<void()> task) {
-    if (!task) {
+namespace {
+// While stopping, workers still drain the queues, so tasks spawned by
+// running tasks are kept; outside submissions are dropped.
+bool accepts(const task &work, bool stopping,
+             bool on_worker) {
+    return work && (!stopping || on_worker);
+}
+} // namespace
+
+void thread_pool::enqueue(task work) {
+    const bool on_worker = state_->on_worker();
+    if (!accepts(work, state_->stopping.load(std::memory_order_acquire),
+                 on_worker)) {
         return;
     }
 
-    {
-        std::lock_guard<std::mutex> lock(state_->mutex);
-        if (state_->stopping) {
-            return;
+    task_node *node = nodes.acquire();
+    node->run = std::move(work);
+    if (on_worker) {
+        state_->submit_local(node);
+    } else {
+        state_->submit_lane(node,
+                            static_cast<size_t>(task_class::interactive));
+    }
+}
+
+admission thread_pool::enqueue(task work, task_class lane) {
+    if (!accepts(work, state_->stopping.load(std::memory_order_acquire),
+                 state_->on_worker())) {
+        return work ? admission::stopped : admission::accepted;
+    }
+
+    task_node *node = nodes.acquire();
+    node->run = std::move(work);
+    state_->submit_lane(node, static_cast<size_t>(lane));
+    return admission::accepted;
+}
+
+admission thread_pool::try_enqueue(task work, task_class lane,
+                                   task_clock::time_point deadline) {
+    if (!accepts(work, state_->stopping.load(std::memory_order_acquire),
+                 state_->on_worker())) {
+        return work ? admission::stopped : admission::accepted;
+    }
+
+    const size_t index = static_cast<size_t>(lane);
+    if (state_->lanes[index].size() >= state_->lane_capacity) {
+        state_->lane_shed_full[index].fetch_add(1, std::memory_order_relaxed);
+        return admission::queue_full;
+    }
+    if (deadline != task_clock::time_point::max() &&
+        task_clock::now() + state_->estimated_wait(index) > deadline) {
+        state_->lane_shed_budget[index].fetch_add(1,
+                                                  std::memory_order_relaxed);
+        return admission::over_budget;
+    }
+
+    task_node *node = nodes.acquire();
+    node->run = std::move(work);
+    node->deadline = deadline;
+    state_->submit_lane(node, index);
+    return admission::accepted;
+}
+
+size_t thread_pool::size() const {
+    return state_->active.load(std::memory_order_relaxed);
+}
+
+scaling_stats thread_pool::scaling() const {
+    std::lock_guard<std::mutex> lock(state_->controller_mutex);
+    scaling_stats out = state_->scaling;
+    out.workers = size();
+    return out;
+}
+
+thread_pool::lane_stats thread_pool::stats(task_class lane) const {
+    const size_t index = static_cast<size_t>(lane);
+    lane_stats out;
+    out.queued = state_->lanes[index].size();
+    out.running = state_->lane_running[index].load(std::memory_order_relaxed);
+    out.limit = state_->lane_limit(index);
+    out.capacity = state_->lane_capacity;
+    out.service_ms = static_cast<double>(state_->lane_service_ns[index].load(
+                         std::memory_order_relaxed)) /
+                     1e6;
+    out.shed_full =
+        state_->lane_shed_full[index].load(std::memory_order_relaxed);
+    out.shed_over_budget =
+        state_->lane_shed_budget[index].load(std::memory_order_relaxed);
+    out.expired = state_->lane_expired[index].load(std::memory_order_relaxed);
+    for (size_t b = 0; b < kQueueWaitBuckets; ++b) {
+        out.wait.counts[b] =
+            state_->lane_waits[index][b].load(std::memory_order_relaxed);
+    }
+    return out;
+}
+
+void thread_pool::parallel_for(
+    size_t count, size_t min_chunk,
+    const std::function<void(size_t, size_t)> &body) {
+    if (count == 0) {
+        return;
+    }
+
+    const size_t chunk = std::max<size_t>(1, min_chunk);
+    const size_t chunk_count = (count + chunk - 1) / chunk;
+    if (chunk_count == 1) {
+        body(0, count);
+        return;
+    }
+
+    struct shared_state {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::exception_ptr error;
+    };
+    auto shared = std::make_shared<shared_state>();
+
+    // Helpers only touch `body` after claiming a chunk, and the caller does
+    // not return before every claimed chunk is finished.
+    const auto *body_ptr = &body;
+    auto run_chunks = [shared, body_ptr, count, chunk, chunk_count]() {
+        while (true) {
+            const size_t index = shared->next.fetch_add(1);
+            if (index >= chunk_count) {
+                return;
+            }
+
+            const size_t begin = index * chunk;
+            try {
+                (*body_ptr)(begin, std::min(count, begin + chunk));
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(shared->mutex);
+                if (!shared->error) {
+                    shared->error = std::current_exception();
+                }
+            }
+
+            if (shared->done.fetch_add(1) + 1 == chunk_count) {
+                std::lock_guard<std::mutex> lock(shared->mutex);
+                shared->cv.notify_all();
+            }
         }
-        state_->tasks.emplace(std::move(task));
+    };
+
+    // From a worker the helpers land in its own deque, where idle workers
+    // steal them.
+    const size_t helpers = std::min(size(), chunk_count);
+    for (size_t i = 1; i < helpers; ++i) {
+        enqueue(run_chunks);
+    }
+    run_chunks();
+
+    std::unique_lock<std::mutex> lock(shared->mutex);
+    shared->cv.wait(lock,
+                    [&shared, chunk_count]() {
+                        return shared->done.load() == chunk_count;
+                    });
+    if (shared->error) {
+        std::rethrow_exception(shared->error);
     }
-    state_->cv.notify_one();
 }
 
-size_t thread_pool::size() const { return state_->workers.size(); }
+thread_pool *thread_pool::current() { return current_pool; }
 
 } // namespace palette::services